@@ -30,6 +30,7 @@
 #include <libsecret/secret.h>
 
 #include "applet-agent.h"
+#include "applet-stats.h"
 #include "utils.h"
 
 #define KEYRING_UUID_TAG "connection-uuid"
@@ -84,8 +85,42 @@ typedef struct {
 
 	GCancellable *cancellable;
 	gint keyring_calls;
+	gint64 start_time;
+
+	/* SaveSecrets only */
+	GQueue *keyring_ops;     /* KeyringOp waiting for a free slot */
+	GHashTable *saved_keys;  /* "setting/key" written by this save */
+	GError *save_error;
 } Request;
 
+/* Keyring operations a single SaveSecrets request keeps in flight at once */
+#define SAVE_MAX_IN_FLIGHT 8
+
+typedef struct {
+	/* Either store a secret... */
+	GHashTable *attrs;
+	char *label;
+	char *secret;
+	/* ...or delete a stale item */
+	SecretItem *item;
+} KeyringOp;
+
+static void
+keyring_op_free (gpointer data)
+{
+	KeyringOp *op = data;
+
+	if (op->attrs)
+		g_hash_table_unref (op->attrs);
+	g_free (op->label);
+	if (op->secret) {
+		memset (op->secret, 0, strlen (op->secret));
+		g_free (op->secret);
+	}
+	g_clear_object (&op->item);
+	g_slice_free (KeyringOp, op);
+}
+
 static Request *
 request_new (NMSecretAgentOld *agent,
              NMConnection *connection,
@@ -115,6 +150,7 @@ request_new (NMSecretAgentOld *agent,
 	r->delete_callback = delete_callback;
 	r->callback_data = callback_data;
 	r->cancellable = g_cancellable_new ();
+	r->start_time = g_get_monotonic_time ();
 	return r;
 }
 
@@ -132,6 +168,11 @@ request_free (Request *r)
 	g_free (r->setting_name);
 	g_strfreev (r->hints);
 	g_object_unref (r->cancellable);
+	if (r->keyring_ops)
+		g_queue_free_full (r->keyring_ops, keyring_op_free);
+	if (r->saved_keys)
+		g_hash_table_destroy (r->saved_keys);
+	g_clear_error (&r->save_error);
 	memset (r, 0, sizeof (*r));
 	g_slice_free (Request, r);
 }
@@ -183,6 +224,7 @@ get_secrets_cb (AppletAgent *self,
 		}
 
 		r->get_callback (NM_SECRET_AGENT_OLD (r->agent), r->connection, secrets, error, r->callback_data);
+		applet_stats_record (APPLET_STATS_SECRETS_DIALOG, r->start_time);
 	}
 	request_free (r);
 }
@@ -398,6 +440,7 @@ done:
 	} else {
 		/* Otherwise send the secrets back to NetworkManager */
 		r->get_callback (NM_SECRET_AGENT_OLD (r->agent), r->connection, error ? NULL : settings, error, r->callback_data);
+		applet_stats_record (APPLET_STATS_SECRETS_KEYRING, r->start_time);
 		request_free (r);
 	}
 
@@ -526,17 +569,42 @@ cancel_get_secrets (NMSecretAgentOld *agent,
 
 /*******************************************************/
 
+static void save_request_pump (Request *r);
+
 static void
 save_request_try_complete (Request *r)
 {
 	/* Only call the SaveSecrets callback and free the request when all the
-	 * secrets have been saved to the keyring.
+	 * keyring writes and deletes have finished.
 	 */
-	if (r->keyring_calls == 0) {
-		if (!g_cancellable_is_cancelled (r->cancellable))
-			r->save_callback (NM_SECRET_AGENT_OLD (r->agent), r->connection, NULL, r->callback_data);
+	if (r->keyring_calls > 0)
+		return;
+
+	if (g_cancellable_is_cancelled (r->cancellable)) {
+		/* Callback already called by NM or dispose */
 		request_free (r);
+		return;
 	}
+
+	if (!g_queue_is_empty (r->keyring_ops))
+		return;
+
+	r->save_callback (NM_SECRET_AGENT_OLD (r->agent), r->connection, r->save_error, r->callback_data);
+	request_free (r);
+}
+
+static void
+save_request_set_error (Request *r, GError *error)
+{
+	if (!error)
+		return;
+	if (!r->save_error && !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		r->save_error = g_error_new (NM_SECRET_AGENT_ERROR,
+		                             NM_SECRET_AGENT_ERROR_FAILED,
+		                             "Failed to save secrets to the keyring (%s)",
+		                             error->message);
+	}
+	g_error_free (error);
 }
 
 static void
@@ -544,11 +612,52 @@ save_secret_cb (GObject *source,
                 GAsyncResult *result,
                 gpointer user_data)
 {
-	secret_password_store_finish (result, NULL);
-	save_request_try_complete (user_data);
+	Request *r = user_data;
+	GError *error = NULL;
+
+	r->keyring_calls--;
+	secret_password_store_finish (result, &error);
+	save_request_set_error (r, error);
+	save_request_pump (r);
 }
 
+static void
+delete_stale_cb (GObject *source,
+                 GAsyncResult *result,
+                 gpointer user_data)
+{
+	Request *r = user_data;
 
+	/* Ignore errors; a stale secret is not worth failing the save for */
+	r->keyring_calls--;
+	secret_item_delete_finish (SECRET_ITEM (source), result, NULL);
+	save_request_pump (r);
+}
+
+/* Issue queued keyring operations until SAVE_MAX_IN_FLIGHT are outstanding,
+ * completing the request once everything has returned.
+ */
+static void
+save_request_pump (Request *r)
+{
+	KeyringOp *op;
+
+	while (   !g_cancellable_is_cancelled (r->cancellable)
+	       && r->keyring_calls < SAVE_MAX_IN_FLIGHT
+	       && (op = g_queue_pop_head (r->keyring_ops))) {
+		if (op->item) {
+			secret_item_delete (op->item, r->cancellable, delete_stale_cb, r);
+		} else {
+			secret_password_storev (&network_manager_secret_schema, op->attrs, NULL,
+			                        op->label, op->secret,
+			                        r->cancellable, save_secret_cb, r);
+		}
+		r->keyring_calls++;
+		keyring_op_free (op);
+	}
+
+	save_request_try_complete (r);
+}
 
 static GHashTable *
 _create_keyring_add_attr_list (NMConnection *connection,
@@ -592,6 +701,7 @@ save_one_secret (Request *r,
 	char *alt_display_name = NULL;
 	const char *setting_name;
 	NMSettingSecretFlags secret_flags = NM_SETTING_SECRET_FLAG_NONE;
+	KeyringOp *op;
 
 	/* Don't system-owned or always-ask secrets */
 	if (!nm_setting_get_secret_flags (setting, key, &secret_flags, NULL))
@@ -608,13 +718,13 @@ save_one_secret (Request *r,
 	                                       display_name ? NULL : &alt_display_name);
 	g_assert (attrs);
 
-	secret_password_storev (&network_manager_secret_schema, attrs, NULL,
-	                        display_name ? display_name : alt_display_name, secret,
-	                        r->cancellable, save_secret_cb, r);
-	r->keyring_calls++;
+	op = g_slice_new0 (KeyringOp);
+	op->attrs = attrs;
+	op->label = display_name ? g_strdup (display_name) : alt_display_name;
+	op->secret = g_strdup (secret);
+	g_queue_push_tail (r->keyring_ops, op);
 
-	g_hash_table_unref (attrs);
-	g_free (alt_display_name);
+	g_hash_table_add (r->saved_keys, g_strdup_printf ("%s/%s", setting_name, key));
 }
 
 static void
@@ -674,21 +784,43 @@ write_one_secret_to_keyring (NMSetting *setting,
 }
 
 static void
-save_delete_cb (NMSecretAgentOld *agent,
-                NMConnection *connection,
-                GError *error,
-                gpointer user_data)
+save_find_stale_cb (GObject *source,
+                    GAsyncResult *result,
+                    gpointer user_data)
 {
 	Request *r = user_data;
+	GList *list, *iter;
 
-	/* Ignore errors; now save all new secrets */
-	nm_connection_for_each_setting_value (connection, write_one_secret_to_keyring, r);
+	r->keyring_calls--;
+	list = secret_service_search_finish (NULL, result, NULL);
 
-	/* If no secrets actually got saved there may be nothing to do so
-	 * try to complete the request here.  If there were secrets to save the
-	 * request will get completed when those keyring calls return.
+	/* Anything in the keyring for this connection that this save didn't
+	 * just rewrite is stale.
 	 */
-	save_request_try_complete (r);
+	for (iter = list; iter; iter = iter->next) {
+		SecretItem *item = iter->data;
+		GHashTable *attributes;
+		const char *setting_name, *setting_key;
+		char *saved_key;
+		KeyringOp *op;
+
+		attributes = secret_item_get_attributes (item);
+		setting_name = g_hash_table_lookup (attributes, KEYRING_SN_TAG);
+		setting_key = g_hash_table_lookup (attributes, KEYRING_SK_TAG);
+		saved_key = g_strdup_printf ("%s/%s",
+		                             setting_name ? setting_name : "",
+		                             setting_key ? setting_key : "");
+		if (!g_hash_table_contains (r->saved_keys, saved_key)) {
+			op = g_slice_new0 (KeyringOp);
+			op->item = g_object_ref (item);
+			g_queue_push_tail (r->keyring_ops, op);
+		}
+		g_free (saved_key);
+		g_hash_table_unref (attributes);
+	}
+	g_list_free_full (list, g_object_unref);
+
+	save_request_pump (r);
 }
 
 static void
@@ -699,13 +831,31 @@ save_secrets (NMSecretAgentOld *agent,
               gpointer callback_data)
 {
 	AppletAgentPrivate *priv = APPLET_AGENT_GET_PRIVATE (agent);
+	GHashTable *attrs;
 	Request *r;
 
 	r = request_new (agent, connection, connection_path, NULL, NULL, FALSE, NULL, callback, NULL, callback_data);
+	r->keyring_ops = g_queue_new ();
+	r->saved_keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 	g_hash_table_insert (priv->requests, GUINT_TO_POINTER (r->id), r);
 
-	/* First delete any existing items in the keyring */
-	nm_secret_agent_old_delete_secrets (agent, connection, save_delete_cb, r);
+	/* Queue a write for every agent-owned secret */
+	nm_connection_for_each_setting_value (connection, write_one_secret_to_keyring, r);
+
+	/* Rather than clearing the connection's keyring items before writing
+	 * (a full round-trip before any write can start), look for items the
+	 * writes won't replace in parallel with them and delete just those.
+	 */
+	attrs = secret_attributes_build (&network_manager_secret_schema,
+	                                 KEYRING_UUID_TAG, nm_connection_get_uuid (connection),
+	                                 NULL);
+	secret_service_search (NULL, &network_manager_secret_schema, attrs,
+	                       SECRET_SEARCH_ALL, r->cancellable,
+	                       save_find_stale_cb, r);
+	r->keyring_calls++;
+	g_hash_table_unref (attrs);
+
+	save_request_pump (r);
 }
 
 /*******************************************************/
@@ -813,7 +813,7 @@ notify_connected (NMDevice *device,
                   const char *msg,
                   NMApplet *applet)
 {
-	applet_do_notify_with_pref (applet,
+	applet_do_notify_with_pref (applet, nm_object_get_path (NM_OBJECT (device)),
 	                            _("Connection Established"),
 	                            msg ? msg : _("You are now connected to the Mobile Broadband network."),
 	                            "nm-device-wwan",
@@ -951,13 +951,13 @@ modem_state_changed (MMModem *object,
 		/* Notify about new registration info */
 		mb_state = broadband_state_to_mb_state (info);
 		if (mb_state == MB_STATE_HOME) {
-			applet_do_notify_with_pref (info->applet,
+			applet_do_notify_with_pref (info->applet, nm_object_get_path (NM_OBJECT (info->device)),
 			                            _("Mobile Broadband network."),
 			                            _("You are now registered on the home network."),
 			                            "nm-signal-100",
 			                            PREF_DISABLE_CONNECTED_NOTIFICATIONS);
 		} else if (mb_state == MB_STATE_ROAMING) {
-			applet_do_notify_with_pref (info->applet,
+			applet_do_notify_with_pref (info->applet, nm_object_get_path (NM_OBJECT (info->device)),
 			                            _("Mobile Broadband network."),
 			                            _("You are now registered on a roaming network."),
 			                            "nm-signal-100",
@@ -88,7 +88,7 @@ bt_notify_connected (NMDevice *device,
                      const char *msg,
                      NMApplet *applet)
 {
-	applet_do_notify_with_pref (applet,
+	applet_do_notify_with_pref (applet, nm_object_get_path (NM_OBJECT (device)),
 	                            _("Connection Established"),
 	                            msg ? msg : _("You are now connected to the mobile broadband network."),
 	                            "nm-device-wwan",
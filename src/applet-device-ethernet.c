@@ -138,7 +138,7 @@ ethernet_notify_connected (NMDevice *device,
                            const char *msg,
                            NMApplet *applet)
 {
-	applet_do_notify_with_pref (applet,
+	applet_do_notify_with_pref (applet, nm_object_get_path (NM_OBJECT (device)),
 	                            _("Connection Established"),
 	                            msg ? msg : _("You are now connected to the ethernet network."),
 	                            "nm-device-wired",
@@ -36,15 +36,20 @@
 #include "applet-device-wifi.h"
 #include "ap-menu-item.h"
 #include "utils.h"
+#include "wifi-profile-index.h"
 #include "nma-wifi-dialog.h"
 #include "mobile-helpers.h"
 
 #define ACTIVE_AP_TAG "active-ap"
+#define AP_TABLE_TAG "ap-table"
 
 static void wifi_dialog_response_cb (GtkDialog *dialog, gint response, gpointer user_data);
 
 static NMAccessPoint *update_active_ap (NMDevice *device, NMDeviceState state, NMApplet *applet);
 
+static const char *ap_table_get_hash (NMDeviceWifi *device, NMAccessPoint *ap);
+static void ap_table_get_counts (NMDeviceWifi *device, guint *out_known, guint *out_unknown);
+
 static void _do_new_auto_connection (NMApplet *applet,
                                      NMDevice *device,
                                      NMAccessPoint *ap,
@@ -498,7 +503,7 @@ wifi_menu_item_activate (GtkMenuItem *item, gpointer user_data)
 struct dup_data {
 	NMDevice *device;
 	NMNetworkMenuItem *found;
-	char *hash;
+	const char *hash;
 };
 
 static void
@@ -525,22 +530,44 @@ find_duplicate (gpointer d, gpointer user_data)
 		data->found = NM_NETWORK_MENU_ITEM (widget);
 }
 
+/* Non-slave profiles for @ap's SSID usable on @device; only the profiles
+ * for that SSID are looked at rather than every connection.
+ */
+static GPtrArray *
+get_ap_connections (NMDeviceWifi *device, NMAccessPoint *ap, NMApplet *applet)
+{
+	GPtrArray *candidates, *dev_connections, *ap_connections;
+	guint i;
+
+	candidates = wifi_profile_index_get_for_ssid (applet->nm_client, nm_access_point_get_ssid (ap));
+	for (i = candidates->len; i > 0; i--) {
+		NMSettingConnection *s_con;
+
+		s_con = nm_connection_get_setting_connection (candidates->pdata[i - 1]);
+		if (!s_con || nm_setting_connection_get_master (s_con))
+			g_ptr_array_remove_index (candidates, i - 1);
+	}
+
+	dev_connections = nm_device_filter_connections (NM_DEVICE (device), candidates);
+	ap_connections = nm_access_point_filter_connections (ap, dev_connections);
+	g_ptr_array_unref (dev_connections);
+	g_ptr_array_unref (candidates);
+
+	return ap_connections;
+}
+
 static NMNetworkMenuItem *
 create_new_ap_item (NMDeviceWifi *device,
                     NMAccessPoint *ap,
                     struct dup_data *dup_data,
-                    const GPtrArray *connections,
                     NMApplet *applet)
 {
 	WifiMenuItemInfo *info;
 	int i;
 	GtkWidget *item;
-	GPtrArray *dev_connections;
 	GPtrArray *ap_connections;
 
-	dev_connections = nm_device_filter_connections (NM_DEVICE (device), connections);
-	ap_connections = nm_access_point_filter_connections (ap, dev_connections);
-	g_ptr_array_unref (dev_connections);
+	ap_connections = get_ap_connections (device, ap, applet);
 
 	item = nm_network_menu_item_new (ap,
 	                                 nm_device_wifi_get_capabilities (device),
@@ -606,7 +633,6 @@ create_new_ap_item (NMDeviceWifi *device,
 static NMNetworkMenuItem *
 get_menu_item_for_ap (NMDeviceWifi *device,
                       NMAccessPoint *ap,
-                      const GPtrArray *connections,
                       GSList *menu_list,
                       NMApplet *applet)
 {
@@ -626,7 +652,7 @@ get_menu_item_for_ap (NMDeviceWifi *device,
 	 * menu item's duplicate list.
 	 */
 	dup_data.found = NULL;
-	dup_data.hash = g_object_get_data (G_OBJECT (ap), "hash");
+	dup_data.hash = ap_table_get_hash (device, ap);
 	g_return_val_if_fail (dup_data.hash != NULL, NULL);
 
 	dup_data.device = NM_DEVICE (device);
@@ -638,7 +664,7 @@ get_menu_item_for_ap (NMDeviceWifi *device,
 		return NULL;
 	}
 
-	return create_new_ap_item (device, ap, &dup_data, connections, applet);
+	return create_new_ap_item (device, ap, &dup_data, applet);
 }
 
 static gint
@@ -772,7 +798,7 @@ wifi_add_menu_item (NMDevice *device,
 	if (!nma_menu_device_check_unusable (device)) {
 		active_ap = nm_device_wifi_get_active_access_point (wdev);
 		if (active_ap) {
-			active_item = item = get_menu_item_for_ap (wdev, active_ap, connections, NULL, applet);
+			active_item = item = get_menu_item_for_ap (wdev, active_ap, NULL, applet);
 			if (item) {
 				nm_network_menu_item_set_active (item, TRUE);
 				menu_items = g_slist_append (menu_items, item);
@@ -803,7 +829,7 @@ wifi_add_menu_item (NMDevice *device,
 	for (i = 0; aps && (i < aps->len); i++) {
 		NMAccessPoint *ap = g_ptr_array_index (aps, i);
 
-		item = get_menu_item_for_ap (wdev, ap, connections, menu_items, applet);
+		item = get_menu_item_for_ap (wdev, ap, menu_items, applet);
 		if (item)
 			menu_items = g_slist_append (menu_items, item);
 	}
@@ -909,36 +935,6 @@ notify_active_ap_changed_cb (NMDeviceWifi *device,
 	applet_schedule_update_icon (applet);
 }
 
-static void
-add_hash_to_ap (NMAccessPoint *ap)
-{
-	char *hash;
-
-	hash = utils_hash_ap (nm_access_point_get_ssid (ap),
-	                      nm_access_point_get_mode (ap),
-	                      nm_access_point_get_flags (ap),
-	                      nm_access_point_get_wpa_flags (ap),
-	                      nm_access_point_get_rsn_flags (ap));
-	g_object_set_data_full (G_OBJECT (ap), "hash", hash, (GDestroyNotify) g_free);
-}
-
-static void
-notify_ap_prop_changed_cb (NMAccessPoint *ap,
-                           GParamSpec *pspec,
-                           NMApplet *applet)
-{
-	const char *prop = g_param_spec_get_name (pspec);
-
-	if (   !strcmp (prop, NM_ACCESS_POINT_FLAGS)
-	    || !strcmp (prop, NM_ACCESS_POINT_WPA_FLAGS)
-	    || !strcmp (prop, NM_ACCESS_POINT_RSN_FLAGS)
-	    || !strcmp (prop, NM_ACCESS_POINT_SSID)
-	    || !strcmp (prop, NM_ACCESS_POINT_FREQUENCY)
-	    || !strcmp (prop, NM_ACCESS_POINT_MODE)) {
-		add_hash_to_ap (ap);
-	}
-}
-
 static void
 wifi_available_dont_show_cb (NotifyNotification *notify,
 			                 gchar *id,
@@ -975,13 +971,12 @@ idle_check_avail_access_point_notification (gpointer datap)
 	struct ap_notification_data *data = datap;
 	NMApplet *applet = data->applet;
 	NMDeviceWifi *device = data->device;
-	int i;
-	const GPtrArray *aps;
-	GPtrArray *all_connections;
-	GPtrArray *connections;
+	guint n_known, n_unknown;
 	GTimeVal timeval;
-	gboolean have_unused_access_point = FALSE;
-	gboolean have_no_autoconnect_points = TRUE;
+	gboolean have_unused_access_point;
+	gboolean have_no_autoconnect_points;
+
+	data->id = 0;
 
 	if (nm_client_get_state (data->applet->nm_client) != NM_STATE_DISCONNECTED)
 		return FALSE;
@@ -993,35 +988,9 @@ idle_check_avail_access_point_notification (gpointer datap)
 	if ((timeval.tv_sec - data->last_notification_time) < 60*60) /* Notify at most once an hour */
 		return FALSE;	
 
-	all_connections = applet_get_all_connections (applet);
-	connections = nm_device_filter_connections (NM_DEVICE (device), all_connections);
-	g_ptr_array_unref (all_connections);	
-
-	aps = nm_device_wifi_get_access_points (device);
-	for (i = 0; i < aps->len; i++) {
-		NMAccessPoint *ap = aps->pdata[i];
-		GPtrArray *ap_connections = nm_access_point_filter_connections (ap, connections);
-		int a;
-		gboolean is_autoconnect = FALSE;
-
-		for (a = 0; a < ap_connections->len; a++) {
-			NMConnection *connection = NM_CONNECTION (ap_connections->pdata[a]);
-			NMSettingConnection *s_con;
-
-			s_con = nm_connection_get_setting_connection (connection);
-			if (nm_setting_connection_get_autoconnect (s_con))  {
-				is_autoconnect = TRUE;
-				break;
-			}
-		}
-		g_ptr_array_unref (ap_connections);
-
-		if (!is_autoconnect)
-			have_unused_access_point = TRUE;
-		else
-			have_no_autoconnect_points = FALSE;
-	}
-	g_ptr_array_unref (connections);
+	ap_table_get_counts (device, &n_known, &n_unknown);
+	have_unused_access_point = (n_unknown > 0);
+	have_no_autoconnect_points = (n_known == 0);
 
 	if (!(have_unused_access_point && have_no_autoconnect_points))
 		return FALSE;
@@ -1031,6 +1000,7 @@ idle_check_avail_access_point_notification (gpointer datap)
 	data->last_notification_time = timeval.tv_sec;
 
 	applet_do_notify (applet,
+	                  nm_object_get_path (NM_OBJECT (device)),
 	                  NOTIFY_URGENCY_LOW,
 	                  _("Wi-Fi Networks Available"),
 	                  _("Use the network menu to connect to a Wi-Fi network"),
@@ -1058,21 +1028,442 @@ queue_avail_access_point_notification (NMDevice *device)
 	data->id = g_timeout_add_seconds (3, idle_check_avail_access_point_notification, data);
 }
 
+/*****************************************************************************/
+
+/* Per-device table of the access points a Wi-Fi device knows about.  For
+ * every AP it holds the hash used to group APs of the same network in the
+ * menu and the autoconnect profiles that match it, and keeps a running
+ * count of known (matched by an autoconnect profile) and unknown APs for
+ * the "networks available" notification.
+ *
+ * APs that appear or whose identity changes are only marked dirty; all
+ * dirty entries are processed together from an idle handler so that a burst
+ * of scan results costs one pass per main loop iteration.
+ */
+typedef struct {
+	char *hash;
+	GHashTable *paths;      /* set of matching autoconnect profile paths */
+} ApEntry;
+
+typedef struct {
+	NMApplet *applet;
+	NMDeviceWifi *device;
+	GHashTable *entries;    /* NMAccessPoint -> ApEntry */
+	GHashTable *dirty;      /* set of NMAccessPoint, referenced */
+	guint dirty_id;
+
+	/* What each profile was counted on, so that it can be taken back
+	 * exactly even after the profile's settings changed.
+	 */
+	GHashTable *contributions;  /* profile path -> set of NMAccessPoint */
+
+	guint n_known;
+	guint n_unknown;
+
+	gulong con_added_id;
+	gulong con_removed_id;
+} ApTable;
+
+/* Only these properties feed into utils_hash_ap() */
+static const char *ap_identity_props[] = {
+	"notify::" NM_ACCESS_POINT_SSID,
+	"notify::" NM_ACCESS_POINT_MODE,
+	"notify::" NM_ACCESS_POINT_FLAGS,
+	"notify::" NM_ACCESS_POINT_WPA_FLAGS,
+	"notify::" NM_ACCESS_POINT_RSN_FLAGS,
+	NULL
+};
+
+static void
+ap_entry_free (gpointer data)
+{
+	ApEntry *entry = data;
+
+	g_free (entry->hash);
+	g_hash_table_destroy (entry->paths);
+	g_slice_free (ApEntry, entry);
+}
+
+static char *
+hash_ap (NMAccessPoint *ap)
+{
+	return utils_hash_ap (nm_access_point_get_ssid (ap),
+	                      nm_access_point_get_mode (ap),
+	                      nm_access_point_get_flags (ap),
+	                      nm_access_point_get_wpa_flags (ap),
+	                      nm_access_point_get_rsn_flags (ap));
+}
+
+/* Whether @connection is a non-slave autoconnect profile usable on the device */
+static gboolean
+ap_table_connection_is_candidate (ApTable *table, NMConnection *connection)
+{
+	NMSettingConnection *s_con;
+
+	s_con = nm_connection_get_setting_connection (connection);
+	if (   !s_con
+	    || nm_setting_connection_get_master (s_con)
+	    || !nm_setting_connection_get_autoconnect (s_con))
+		return FALSE;
+
+	return nm_device_connection_compatible (NM_DEVICE (table->device), connection, NULL);
+}
+
+static void
+ap_table_count (ApTable *table, ApEntry *entry, int delta)
+{
+	if (g_hash_table_size (entry->paths))
+		table->n_known += delta;
+	else
+		table->n_unknown += delta;
+}
+
+static void
+ap_table_link (ApTable *table, NMAccessPoint *ap, ApEntry *entry, const char *path)
+{
+	GHashTable *aps;
+
+	aps = g_hash_table_lookup (table->contributions, path);
+	if (!aps) {
+		aps = g_hash_table_new (NULL, NULL);
+		g_hash_table_insert (table->contributions, g_strdup (path), aps);
+	} else if (g_hash_table_contains (aps, ap))
+		return;
+	g_hash_table_add (aps, ap);
+
+	ap_table_count (table, entry, -1);
+	g_hash_table_add (entry->paths, g_strdup (path));
+	ap_table_count (table, entry, 1);
+}
+
+/* Takes back everything the profiles matching @ap contributed to it */
+static void
+ap_table_unlink_ap (ApTable *table, NMAccessPoint *ap, ApEntry *entry)
+{
+	GHashTableIter iter;
+	const char *path;
+	GHashTable *aps;
+
+	g_hash_table_iter_init (&iter, entry->paths);
+	while (g_hash_table_iter_next (&iter, (gpointer) &path, NULL)) {
+		aps = g_hash_table_lookup (table->contributions, path);
+		if (aps) {
+			g_hash_table_remove (aps, ap);
+			if (!g_hash_table_size (aps))
+				g_hash_table_remove (table->contributions, path);
+		}
+	}
+
+	ap_table_count (table, entry, -1);
+	g_hash_table_remove_all (entry->paths);
+	ap_table_count (table, entry, 1);
+}
+
+/* Takes back everything the profile at @path contributed to any AP */
+static void
+ap_table_unlink_connection (ApTable *table, const char *path)
+{
+	GHashTableIter iter;
+	GHashTable *aps;
+	NMAccessPoint *ap;
+	ApEntry *entry;
+
+	aps = g_hash_table_lookup (table->contributions, path);
+	if (!aps)
+		return;
+
+	g_hash_table_iter_init (&iter, aps);
+	while (g_hash_table_iter_next (&iter, (gpointer) &ap, NULL)) {
+		entry = g_hash_table_lookup (table->entries, ap);
+		if (!entry)
+			continue;
+		ap_table_count (table, entry, -1);
+		g_hash_table_remove (entry->paths, path);
+		ap_table_count (table, entry, 1);
+	}
+	g_hash_table_remove (table->contributions, path);
+}
+
+static void
+ap_table_link_connection (ApTable *table, NMConnection *connection)
+{
+	GHashTableIter iter;
+	NMAccessPoint *ap;
+	ApEntry *entry;
+	const char *path;
+
+	path = nm_connection_get_path (connection);
+	if (!path || !ap_table_connection_is_candidate (table, connection))
+		return;
+
+	g_hash_table_iter_init (&iter, table->entries);
+	while (g_hash_table_iter_next (&iter, (gpointer) &ap, (gpointer) &entry)) {
+		if (nm_access_point_connection_valid (ap, connection))
+			ap_table_link (table, ap, entry, path);
+	}
+}
+
+static ApEntry *
+ap_table_update_entry (ApTable *table, NMAccessPoint *ap)
+{
+	GPtrArray *connections;
+	ApEntry *entry;
+	guint i;
+
+	entry = g_hash_table_lookup (table->entries, ap);
+	if (!entry) {
+		entry = g_slice_new0 (ApEntry);
+		entry->paths = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+		g_hash_table_insert (table->entries, g_object_ref (ap), entry);
+		ap_table_count (table, entry, 1);
+	} else
+		ap_table_unlink_ap (table, ap, entry);
+
+	g_free (entry->hash);
+	entry->hash = hash_ap (ap);
+
+	connections = wifi_profile_index_get_for_ssid (table->applet->nm_client,
+	                                               nm_access_point_get_ssid (ap));
+	for (i = 0; i < connections->len; i++) {
+		NMConnection *connection = connections->pdata[i];
+		const char *path = nm_connection_get_path (connection);
+
+		if (   path
+		    && ap_table_connection_is_candidate (table, connection)
+		    && nm_access_point_connection_valid (ap, connection))
+			ap_table_link (table, ap, entry, path);
+	}
+	g_ptr_array_unref (connections);
+
+	return entry;
+}
+
+static void
+ap_table_flush (ApTable *table)
+{
+	GHashTableIter iter;
+	NMAccessPoint *ap;
+
+	g_hash_table_iter_init (&iter, table->dirty);
+	while (g_hash_table_iter_next (&iter, (gpointer) &ap, NULL))
+		ap_table_update_entry (table, ap);
+	g_hash_table_remove_all (table->dirty);
+}
+
+static gboolean
+ap_table_flush_idle (gpointer user_data)
+{
+	ApTable *table = user_data;
+
+	table->dirty_id = 0;
+	ap_table_flush (table);
+	applet_schedule_update_menu (table->applet);
+	return FALSE;
+}
+
+static void
+ap_table_mark_dirty (ApTable *table, NMAccessPoint *ap)
+{
+	g_hash_table_add (table->dirty, g_object_ref (ap));
+	if (!table->dirty_id)
+		table->dirty_id = g_idle_add (ap_table_flush_idle, table);
+}
+
+static void
+ap_identity_changed_cb (NMAccessPoint *ap, GParamSpec *pspec, gpointer user_data)
+{
+	ap_table_mark_dirty ((ApTable *) user_data, ap);
+}
+
+static void
+ap_table_add (ApTable *table, NMAccessPoint *ap)
+{
+	guint i;
+
+	if (   g_hash_table_contains (table->entries, ap)
+	    || g_hash_table_contains (table->dirty, ap))
+		return;
+
+	for (i = 0; ap_identity_props[i]; i++) {
+		g_signal_connect (ap, ap_identity_props[i],
+		                  G_CALLBACK (ap_identity_changed_cb),
+		                  table);
+	}
+	ap_table_mark_dirty (table, ap);
+}
+
+static void
+ap_table_remove (ApTable *table, NMAccessPoint *ap)
+{
+	ApEntry *entry;
+
+	g_signal_handlers_disconnect_by_func (ap, G_CALLBACK (ap_identity_changed_cb), table);
+	g_hash_table_remove (table->dirty, ap);
+
+	entry = g_hash_table_lookup (table->entries, ap);
+	if (entry) {
+		ap_table_unlink_ap (table, ap, entry);
+		ap_table_count (table, entry, -1);
+		g_hash_table_remove (table->entries, ap);
+	}
+}
+
+static void
+ap_table_connection_changed_cb (NMConnection *connection, gpointer user_data)
+{
+	ApTable *table = user_data;
+	const char *path = nm_connection_get_path (connection);
+
+	/* SSID or autoconnect may have changed; recount from scratch */
+	if (path)
+		ap_table_unlink_connection (table, path);
+	ap_table_link_connection (table, connection);
+}
+
+static void
+ap_table_connection_added_cb (NMClient *client,
+                              NMRemoteConnection *connection,
+                              gpointer user_data)
+{
+	ApTable *table = user_data;
+
+	g_signal_connect (connection, NM_CONNECTION_CHANGED,
+	                  G_CALLBACK (ap_table_connection_changed_cb), table);
+	ap_table_link_connection (table, NM_CONNECTION (connection));
+}
+
+static void
+ap_table_connection_removed_cb (NMClient *client,
+                                NMRemoteConnection *connection,
+                                gpointer user_data)
+{
+	ApTable *table = user_data;
+	const char *path = nm_connection_get_path (NM_CONNECTION (connection));
+
+	g_signal_handlers_disconnect_by_func (connection,
+	                                      G_CALLBACK (ap_table_connection_changed_cb),
+	                                      table);
+	if (path)
+		ap_table_unlink_connection (table, path);
+}
+
+static void
+ap_table_free (gpointer user_data)
+{
+	ApTable *table = user_data;
+	const GPtrArray *connections;
+	GHashTableIter iter;
+	NMAccessPoint *ap;
+	guint i;
+
+	if (table->dirty_id)
+		g_source_remove (table->dirty_id);
+
+	if (table->applet->nm_client) {
+		g_signal_handler_disconnect (table->applet->nm_client, table->con_added_id);
+		g_signal_handler_disconnect (table->applet->nm_client, table->con_removed_id);
+
+		connections = nm_client_get_connections (table->applet->nm_client);
+		for (i = 0; connections && (i < connections->len); i++) {
+			g_signal_handlers_disconnect_by_func (connections->pdata[i],
+			                                      G_CALLBACK (ap_table_connection_changed_cb),
+			                                      table);
+		}
+	}
+
+	g_hash_table_iter_init (&iter, table->dirty);
+	while (g_hash_table_iter_next (&iter, (gpointer) &ap, NULL))
+		g_signal_handlers_disconnect_by_func (ap, G_CALLBACK (ap_identity_changed_cb), table);
+	g_hash_table_iter_init (&iter, table->entries);
+	while (g_hash_table_iter_next (&iter, (gpointer) &ap, NULL))
+		g_signal_handlers_disconnect_by_func (ap, G_CALLBACK (ap_identity_changed_cb), table);
+
+	g_hash_table_destroy (table->dirty);
+	g_hash_table_destroy (table->entries);
+	g_hash_table_destroy (table->contributions);
+	g_slice_free (ApTable, table);
+}
+
+static ApTable *
+ap_table_new (NMDeviceWifi *device, NMApplet *applet)
+{
+	ApTable *table;
+	const GPtrArray *aps, *connections;
+	guint i;
+
+	table = g_slice_new0 (ApTable);
+	table->applet = applet;
+	table->device = device;
+	table->entries = g_hash_table_new_full (NULL, NULL, g_object_unref, ap_entry_free);
+	table->dirty = g_hash_table_new_full (NULL, NULL, g_object_unref, NULL);
+	table->contributions = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                              (GDestroyNotify) g_hash_table_destroy);
+
+	table->con_added_id = g_signal_connect (applet->nm_client,
+	                                        NM_CLIENT_CONNECTION_ADDED,
+	                                        G_CALLBACK (ap_table_connection_added_cb),
+	                                        table);
+	table->con_removed_id = g_signal_connect (applet->nm_client,
+	                                          NM_CLIENT_CONNECTION_REMOVED,
+	                                          G_CALLBACK (ap_table_connection_removed_cb),
+	                                          table);
+
+	connections = nm_client_get_connections (applet->nm_client);
+	for (i = 0; connections && (i < connections->len); i++) {
+		g_signal_connect (connections->pdata[i], NM_CONNECTION_CHANGED,
+		                  G_CALLBACK (ap_table_connection_changed_cb), table);
+	}
+
+	aps = nm_device_wifi_get_access_points (device);
+	for (i = 0; aps && (i < aps->len); i++)
+		ap_table_add (table, g_ptr_array_index (aps, i));
+
+	return table;
+}
+
+static const char *
+ap_table_get_hash (NMDeviceWifi *device, NMAccessPoint *ap)
+{
+	ApTable *table;
+	ApEntry *entry;
+
+	table = g_object_get_data (G_OBJECT (device), AP_TABLE_TAG);
+	g_return_val_if_fail (table != NULL, NULL);
+
+	/* The menu may be built before the idle handler ran */
+	if (g_hash_table_contains (table->dirty, ap)) {
+		entry = ap_table_update_entry (table, ap);
+		g_hash_table_remove (table->dirty, ap);
+	} else
+		entry = g_hash_table_lookup (table->entries, ap);
+
+	return entry ? entry->hash : NULL;
+}
+
+static void
+ap_table_get_counts (NMDeviceWifi *device, guint *out_known, guint *out_unknown)
+{
+	ApTable *table;
+
+	table = g_object_get_data (G_OBJECT (device), AP_TABLE_TAG);
+	g_return_if_fail (table != NULL);
+
+	/* Scan results may still be pending */
+	ap_table_flush (table);
+
+	*out_known = table->n_known;
+	*out_unknown = table->n_unknown;
+}
+
 static void
 access_point_added_cb (NMDeviceWifi *device,
                        NMAccessPoint *ap,
                        gpointer user_data)
 {
-	NMApplet *applet = NM_APPLET  (user_data);
+	ApTable *table = g_object_get_data (G_OBJECT (device), AP_TABLE_TAG);
 
-	add_hash_to_ap (ap);
-	g_signal_connect (G_OBJECT (ap),
-	                  "notify",
-	                  G_CALLBACK (notify_ap_prop_changed_cb),
-	                  applet);
-	
+	ap_table_add (table, ap);
 	queue_avail_access_point_notification (NM_DEVICE (device));
-	applet_schedule_update_menu (applet);
 }
 
 static void
@@ -1081,8 +1472,11 @@ access_point_removed_cb (NMDeviceWifi *device,
                          gpointer user_data)
 {
 	NMApplet *applet = NM_APPLET  (user_data);
+	ApTable *table = g_object_get_data (G_OBJECT (device), AP_TABLE_TAG);
 	NMAccessPoint *old;
 
+	ap_table_remove (table, ap);
+
 	/* If this AP was the active AP, make sure ACTIVE_AP_TAG gets cleared from
 	 * its device.
 	 */
@@ -1122,11 +1516,13 @@ static void
 wifi_device_added (NMDevice *device, NMApplet *applet)
 {
 	NMDeviceWifi *wdev = NM_DEVICE_WIFI (device);
-	const GPtrArray *aps;
-	int i;
 	struct ap_notification_data *data;
 	guint id;
 
+	/* Track all APs this device knows about */
+	g_object_set_data_full (G_OBJECT (wdev), AP_TABLE_TAG,
+	                        ap_table_new (wdev, applet), ap_table_free);
+
 	g_signal_connect (wdev,
 	                  "notify::" NM_DEVICE_WIFI_ACTIVE_ACCESS_POINT,
 	                  G_CALLBACK (notify_active_ap_changed_cb),
@@ -1161,11 +1557,6 @@ wifi_device_added (NMDevice *device, NMApplet *applet)
 	                        data, free_ap_notification_data);
 
 	queue_avail_access_point_notification (device);
-
-	/* Hash all APs this device knows about */
-	aps = nm_device_wifi_get_access_points (wdev);
-	for (i = 0; aps && (i < aps->len); i++)
-		add_hash_to_ap (g_ptr_array_index (aps, i));
 }
 
 static void
@@ -1235,7 +1626,8 @@ wifi_notify_connected (NMDevice *device,
 
 	esc_ssid = get_ssid_utf8 (ap);
 	ssid_msg = g_strdup_printf (_("You are now connected to the Wi-Fi network '%s'."), esc_ssid);
-	applet_do_notify_with_pref (applet, _("Connection Established"),
+	applet_do_notify_with_pref (applet, nm_object_get_path (NM_OBJECT (device)),
+	                            _("Connection Established"),
 	                            ssid_msg, "nm-device-wireless",
 	                            PREF_DISABLE_CONNECTED_NOTIFICATIONS);
 	g_free (ssid_msg);
@@ -203,12 +203,11 @@ create_info_group_label (const char *text, gboolean selectable)
 	return label;
 }
 
-static GtkWidget *
-create_info_label_security (NMConnection *connection)
+static char *
+get_security_label (NMConnection *connection)
 {
 	NMSettingConnection *s_con;
 	char *label = NULL;
-	GtkWidget *w = NULL;
 	const char *connection_type;
 
 	s_con = nm_connection_get_setting_connection (connection);
@@ -246,6 +245,16 @@ create_info_label_security (NMConnection *connection)
 			label = g_strdup (C_("Wi-Fi/Ethernet security", "None"));
 	}
 
+	return label;
+}
+
+static GtkWidget *
+create_info_label_security (NMConnection *connection)
+{
+	char *label;
+	GtkWidget *w = NULL;
+
+	label = get_security_label (connection);
 	if (label)
 		w = create_info_label (label, TRUE);
 	g_free (label);
@@ -460,11 +469,9 @@ display_dns_info (const char * const *dns, GtkGrid *grid, int *row)
 	}
 }
 
-static void
-info_dialog_add_page (GtkNotebook *notebook,
-                      NMConnection *connection,
-                      gboolean is_default,
-                      NMDevice *device)
+static GtkWidget *
+info_dialog_create_page (NMConnection *connection,
+                         NMDevice *device)
 {
 	GtkGrid *grid;
 	guint32 speed = 0;
@@ -698,10 +705,8 @@ info_dialog_add_page (GtkNotebook *notebook,
 	data_widget = NULL;
 	data_object = NULL;
 
-	gtk_notebook_append_page (notebook, GTK_WIDGET (grid),
-	                          create_info_notebook_label (connection, is_default));
-
 	gtk_widget_show_all (GTK_WIDGET (grid));
+	return GTK_WIDGET (grid);
 }
 
 static char *
@@ -773,11 +778,10 @@ get_vpn_data_item (NMConnection *connection, enum VpnDataItem vpn_data_item)
 	return nm_setting_vpn_get_data_item (nm_connection_get_setting_vpn (connection), key);
 }
 
-static void
-info_dialog_add_page_for_vpn (GtkNotebook *notebook,
-                              NMConnection *connection,
-                              NMActiveConnection *active,
-                              NMConnection *parent_con)
+static GtkWidget *
+info_dialog_create_page_for_vpn (NMConnection *connection,
+                                 NMActiveConnection *active,
+                                 NMConnection *parent_con)
 {
 	GtkGrid *grid;
 	char *str;
@@ -791,7 +795,6 @@ info_dialog_add_page_for_vpn (GtkNotebook *notebook,
 	GPtrArray *addresses;
 	NMSettingIPConfig *s_ip6;
 	const char *method = NULL;
-	gboolean is_default = nm_active_connection_get_default (active);
 
 	grid = GTK_GRID (gtk_grid_new ());
 	gtk_grid_set_column_spacing (grid, 12);
@@ -888,27 +891,212 @@ info_dialog_add_page_for_vpn (GtkNotebook *notebook,
 		display_dns_info (dns6, grid, &row);
 	}
 
-	gtk_notebook_append_page (notebook, GTK_WIDGET (grid),
-	                          create_info_notebook_label (connection, is_default));
-
 	gtk_widget_show_all (GTK_WIDGET (grid));
+	return GTK_WIDGET (grid);
 }
 
-static GtkWidget *
+/* Pages of the info dialog are kept across updates, keyed by the object path
+ * of their active connection.  Each page remembers a signature of everything
+ * it displays, and is only rebuilt when that signature changes; the Wi-Fi
+ * bitrate label updates itself through bitrate_changed_cb().
+ */
+typedef struct {
+	GtkWidget *grid;
+	char *signature;
+	gboolean seen;
+} InfoPage;
+
+/* While shown, refresh the dialog at most this often (in seconds) */
+#define INFO_DIALOG_REFRESH_INTERVAL 1
+
+#define STR_OR_EMPTY(s) ((s) ? (s) : "")
+
+static void
+info_page_free (gpointer data)
+{
+	InfoPage *page = data;
+
+	if (page->grid) {
+		GtkWidget *parent = gtk_widget_get_parent (page->grid);
+
+		if (parent)
+			gtk_container_remove (GTK_CONTAINER (parent), page->grid);
+		g_object_unref (page->grid);
+	}
+	g_free (page->signature);
+	g_slice_free (InfoPage, page);
+}
+
+static void
+append_ip_config_signature (GString *sig, NMIPConfig *config)
+{
+	GPtrArray *addresses;
+	const char * const *dns;
+	int i;
+
+	if (!config) {
+		g_string_append (sig, "|none");
+		return;
+	}
+
+	addresses = nm_ip_config_get_addresses (config);
+	for (i = 0; addresses && (i < addresses->len); i++) {
+		NMIPAddress *addr = g_ptr_array_index (addresses, i);
+
+		g_string_append_printf (sig, "|%s/%u",
+		                        nm_ip_address_get_address (addr),
+		                        nm_ip_address_get_prefix (addr));
+	}
+	g_string_append_printf (sig, "|gw %s", STR_OR_EMPTY (nm_ip_config_get_gateway (config)));
+
+	dns = nm_ip_config_get_nameservers (config);
+	for (i = 0; dns && dns[i]; i++)
+		g_string_append_printf (sig, "|dns %s", dns[i]);
+}
+
+static void
+append_ip6_method_signature (GString *sig, NMConnection *connection)
+{
+	NMSettingIPConfig *s_ip6;
+
+	s_ip6 = nm_connection_get_setting_ip6_config (connection);
+	g_string_append_printf (sig, "|%s", s_ip6 ? STR_OR_EMPTY (nm_setting_ip_config_get_method (s_ip6)) : "");
+}
+
+static char *
+info_page_get_signature (NMConnection *connection, NMDevice *device)
+{
+	GString *sig;
+	char *security;
+
+	sig = g_string_new (nm_device_get_iface (device));
+	g_string_append_printf (sig, "|%s|%s",
+	                        STR_OR_EMPTY (nm_device_get_hw_address (device)),
+	                        STR_OR_EMPTY (nm_device_get_driver (device)));
+
+	/* The Wi-Fi bitrate is updated in place */
+	if (NM_IS_DEVICE_ETHERNET (device))
+		g_string_append_printf (sig, "|%u", nm_device_ethernet_get_speed (NM_DEVICE_ETHERNET (device)));
+
+	security = get_security_label (connection);
+	g_string_append_printf (sig, "|%s", STR_OR_EMPTY (security));
+	g_free (security);
+
+	append_ip_config_signature (sig, nm_device_get_ip4_config (device));
+	append_ip6_method_signature (sig, connection);
+	append_ip_config_signature (sig, nm_device_get_ip6_config (device));
+
+	return g_string_free (sig, FALSE);
+}
+
+static char *
+info_page_get_signature_for_vpn (NMConnection *connection,
+                                 NMActiveConnection *active,
+                                 NMConnection *parent_con)
+{
+	GString *sig;
+
+	sig = g_string_new (get_vpn_data_item (connection, VPN_DATA_ITEM_GATEWAY));
+	g_string_append_printf (sig, "|%s|%s|%s",
+	                        STR_OR_EMPTY (get_vpn_data_item (connection, VPN_DATA_ITEM_USERNAME)),
+	                        STR_OR_EMPTY (nm_vpn_connection_get_banner (NM_VPN_CONNECTION (active))),
+	                        parent_con ? STR_OR_EMPTY (nm_connection_get_id (parent_con)) : "");
+
+	append_ip_config_signature (sig, nm_active_connection_get_ip4_config (active));
+	append_ip6_method_signature (sig, connection);
+	append_ip_config_signature (sig, nm_active_connection_get_ip6_config (active));
+
+	return g_string_free (sig, FALSE);
+}
+
+static void
+info_dialog_sync_page (NMApplet *applet,
+                       GtkNotebook *notebook,
+                       NMActiveConnection *active,
+                       NMConnection *connection,
+                       NMDevice *device,
+                       int position)
+{
+	const char *path = nm_object_get_path (NM_OBJECT (active));
+	gboolean is_default = nm_active_connection_get_default (active);
+	NMConnection *parent_con = NULL;
+	InfoPage *page;
+	char *signature, *tmp;
+
+	if (device)
+		signature = info_page_get_signature (connection, device);
+	else {
+		parent_con = get_connection_for_active_path (applet, nm_active_connection_get_specific_object_path (active));
+		signature = info_page_get_signature_for_vpn (connection, active, parent_con);
+	}
+
+	/* The tab label is cheap; fold it into the signature too */
+	tmp = signature;
+	signature = g_strdup_printf ("%s|%d|%s", STR_OR_EMPTY (nm_connection_get_id (connection)), is_default, tmp);
+	g_free (tmp);
+
+	page = g_hash_table_lookup (applet->info_dialog_pages, path);
+	if (page) {
+		page->seen = TRUE;
+		if (!strcmp (page->signature, signature)) {
+			g_free (signature);
+			return;
+		}
+
+		/* Something changed; replace the page at its current position */
+		position = gtk_notebook_page_num (notebook, page->grid);
+		gtk_notebook_remove_page (notebook, position);
+		g_clear_object (&page->grid);
+		g_free (page->signature);
+	} else {
+		page = g_slice_new0 (InfoPage);
+		page->seen = TRUE;
+		g_hash_table_insert (applet->info_dialog_pages, g_strdup (path), page);
+	}
+
+	page->signature = signature;
+	if (device)
+		page->grid = info_dialog_create_page (connection, device);
+	else
+		page->grid = info_dialog_create_page_for_vpn (connection, active, parent_con);
+	g_object_ref (page->grid);
+
+	gtk_notebook_insert_page (notebook, page->grid,
+	                          create_info_notebook_label (connection, is_default),
+	                          position);
+}
+
+static gboolean
+info_page_is_stale (gpointer key, gpointer value, gpointer user_data)
+{
+	return !((InfoPage *) value)->seen;
+}
+
+static int
 info_dialog_update (NMApplet *applet)
 {
 	GtkNotebook *notebook;
 	const GPtrArray *connections;
+	GHashTableIter iter;
+	InfoPage *page;
 	int i;
 	int pages = 0;
 
 	notebook = GTK_NOTEBOOK (GTK_WIDGET (gtk_builder_get_object (applet->info_dialog_ui, "info_notebook")));
 
-	/* Remove old pages */
-	for (i = gtk_notebook_get_n_pages (notebook); i > 0; i--)
-		gtk_notebook_remove_page (notebook, -1);
+	if (!applet->info_dialog_pages) {
+		/* Drop whatever the UI file came with */
+		for (i = gtk_notebook_get_n_pages (notebook); i > 0; i--)
+			gtk_notebook_remove_page (notebook, -1);
+
+		applet->info_dialog_pages = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                                   g_free, info_page_free);
+	}
+
+	g_hash_table_iter_init (&iter, applet->info_dialog_pages);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &page))
+		page->seen = FALSE;
 
-	/* Add new pages */
 	connections = nm_client_get_active_connections (applet->nm_client);
 	for (i = 0; connections && (i < connections->len); i++) {
 		NMActiveConnection *active_connection = g_ptr_array_index (connections, i);
@@ -926,15 +1114,11 @@ info_dialog_update (NMApplet *applet)
 
 		devices = nm_active_connection_get_devices (active_connection);
 		if (NM_IS_VPN_CONNECTION (active_connection)) {
-			const char *spec_object = nm_active_connection_get_specific_object_path (active_connection);
-			NMConnection *parent_con = get_connection_for_active_path (applet, spec_object);
-
-			info_dialog_add_page_for_vpn (notebook, connection, active_connection, parent_con);
+			info_dialog_sync_page (applet, notebook, active_connection, connection,
+			                       NULL, pages);
 		} else if (devices && devices->len > 0) {
-				info_dialog_add_page (notebook,
-				                      connection,
-				                      nm_active_connection_get_default (active_connection),
-				                      g_ptr_array_index (devices, 0));
+			info_dialog_sync_page (applet, notebook, active_connection, connection,
+			                       g_ptr_array_index (devices, 0), pages);
 		} else {
 			g_warning ("Active connection %s had no devices and was not a VPN!",
 			           nm_object_get_path (NM_OBJECT (active_connection)));
@@ -944,13 +1128,42 @@ info_dialog_update (NMApplet *applet)
 		pages++;
 	}
 
-	if (pages == 0) {
-		/* Shouldn't really happen but ... */
-		info_dialog_show_error (_("No valid active connections found!"));
-		return NULL;
+	/* Remove pages of connections that went away */
+	g_hash_table_foreach_remove (applet->info_dialog_pages, info_page_is_stale, NULL);
+
+	return pages;
+}
+
+static gboolean
+info_dialog_refresh_cb (gpointer user_data)
+{
+	NMApplet *applet = user_data;
+	GtkWidget *dialog;
+
+	dialog = GTK_WIDGET (gtk_builder_get_object (applet->info_dialog_ui, "info_dialog"));
+	if (info_dialog_update (applet) == 0)
+		gtk_widget_hide (dialog);
+
+	return TRUE;
+}
+
+static void
+info_dialog_map_cb (GtkWidget *dialog, NMApplet *applet)
+{
+	if (!applet->info_dialog_update_id) {
+		applet->info_dialog_update_id = g_timeout_add_seconds (INFO_DIALOG_REFRESH_INTERVAL,
+		                                                       info_dialog_refresh_cb,
+		                                                       applet);
 	}
+}
 
-	return GTK_WIDGET (gtk_builder_get_object (applet->info_dialog_ui, "info_dialog"));
+static void
+info_dialog_unmap_cb (GtkWidget *dialog, NMApplet *applet)
+{
+	if (applet->info_dialog_update_id) {
+		g_source_remove (applet->info_dialog_update_id);
+		applet->info_dialog_update_id = 0;
+	}
 }
 
 void
@@ -958,12 +1171,21 @@ applet_info_dialog_show (NMApplet *applet)
 {
 	GtkWidget *dialog;
 
-	dialog = info_dialog_update (applet);
-	if (!dialog)
+	if (info_dialog_update (applet) == 0) {
+		/* Shouldn't really happen but ... */
+		info_dialog_show_error (_("No valid active connections found!"));
 		return;
+	}
+
+	dialog = GTK_WIDGET (gtk_builder_get_object (applet->info_dialog_ui, "info_dialog"));
+	if (!g_object_get_data (G_OBJECT (dialog), "nma-info-dialog-setup")) {
+		g_signal_connect (dialog, "delete-event", G_CALLBACK (gtk_widget_hide_on_delete), dialog);
+		g_signal_connect_swapped (dialog, "response", G_CALLBACK (gtk_widget_hide), dialog);
+		g_signal_connect (dialog, "map", G_CALLBACK (info_dialog_map_cb), applet);
+		g_signal_connect (dialog, "unmap", G_CALLBACK (info_dialog_unmap_cb), applet);
+		g_object_set_data (G_OBJECT (dialog), "nma-info-dialog-setup", GINT_TO_POINTER (TRUE));
+	}
 
-	g_signal_connect (dialog, "delete-event", G_CALLBACK (gtk_widget_hide_on_delete), dialog);
-	g_signal_connect_swapped (dialog, "response", G_CALLBACK (gtk_widget_hide), dialog);
 	gtk_widget_realize (dialog);
 	gtk_window_present_with_time (GTK_WINDOW (dialog),
 		gdk_x11_get_server_time (gtk_widget_get_window (dialog)));
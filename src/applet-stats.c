@@ -0,0 +1,182 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib-object.h>
+#include <dbus/dbus-glib.h>
+
+#include "applet-stats.h"
+#include "stall-detector.h"
+
+/* Histogram buckets are decades of microseconds: <100us, <1ms, <10ms,
+ * <100ms, <1s and everything slower.
+ */
+#define N_BUCKETS 6
+
+typedef struct {
+	guint64 count;
+	guint64 total_us;
+	guint64 max_us;
+	guint buckets[N_BUCKETS];
+} Histogram;
+
+static struct {
+	Histogram timers[APPLET_STATS_LAST];
+	guint64 menu_items_total;
+	guint menu_items_last;
+	guint64 icon_cache_hits;
+	guint64 icon_cache_misses;
+} stats;
+
+static const char *timer_names[APPLET_STATS_LAST] = {
+	[APPLET_STATS_ICON_UPDATE]     = "icon-updates",
+	[APPLET_STATS_MENU_BUILD]      = "menu-builds",
+	[APPLET_STATS_SECRETS_KEYRING] = "secrets-keyring",
+	[APPLET_STATS_SECRETS_DIALOG]  = "secrets-dialog",
+	[APPLET_STATS_STALL]           = "stalls",
+};
+
+static void
+histogram_add (Histogram *h, guint64 elapsed_us)
+{
+	guint64 bound = 100;
+	int i;
+
+	for (i = 0; i < N_BUCKETS - 1 && elapsed_us >= bound; i++)
+		bound *= 10;
+	h->buckets[i]++;
+
+	h->count++;
+	h->total_us += elapsed_us;
+	if (elapsed_us > h->max_us)
+		h->max_us = elapsed_us;
+}
+
+void
+applet_stats_record (AppletStatsTimer timer, gint64 start_us)
+{
+	gint64 elapsed_us;
+
+	g_return_if_fail (timer < APPLET_STATS_LAST && timer != APPLET_STATS_STALL);
+
+	elapsed_us = MAX (g_get_monotonic_time () - start_us, 0);
+	histogram_add (&stats.timers[timer], elapsed_us);
+}
+
+/* Stalls are whole main loop iterations, so they are only counted while
+ * the stall detector is enabled.
+ */
+void
+applet_stats_record_stall (gint64 duration_us)
+{
+	histogram_add (&stats.timers[APPLET_STATS_STALL], MAX (duration_us, 0));
+}
+
+void
+applet_stats_record_menu_items (guint n_items)
+{
+	stats.menu_items_total += n_items;
+	stats.menu_items_last = n_items;
+}
+
+void
+applet_stats_icon_cache_lookup (gboolean hit)
+{
+	if (hit)
+		stats.icon_cache_hits++;
+	else
+		stats.icon_cache_misses++;
+}
+
+/*******************************************************/
+
+static void
+value_destroy (gpointer data)
+{
+	GValue *value = data;
+
+	g_value_unset (value);
+	g_slice_free (GValue, value);
+}
+
+static void
+add_uint64 (GHashTable *hash, const char *key, guint64 val)
+{
+	GValue *value = g_slice_new0 (GValue);
+
+	g_value_init (value, G_TYPE_UINT64);
+	g_value_set_uint64 (value, val);
+	g_hash_table_insert (hash, g_strdup (key), value);
+}
+
+static void
+add_uint_array (GHashTable *hash, const char *key, const guint *vals, guint len)
+{
+	GValue *value = g_slice_new0 (GValue);
+	GArray *array;
+
+	array = g_array_sized_new (FALSE, FALSE, sizeof (guint), len);
+	g_array_append_vals (array, vals, len);
+	g_value_init (value, DBUS_TYPE_G_UINT_ARRAY);
+	g_value_take_boxed (value, array);
+	g_hash_table_insert (hash, g_strdup (key), value);
+}
+
+/* Returns an a{sv} suitable for a dbus-glib out argument */
+GHashTable *
+applet_stats_to_hash (void)
+{
+	static const guint bounds[N_BUCKETS - 1] = { 100, 1000, 10000, 100000, 1000000 };
+	GHashTable *hash;
+	char *key;
+	int i;
+
+	hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, value_destroy);
+
+	add_uint_array (hash, "histogram-bounds-us", bounds, G_N_ELEMENTS (bounds));
+	add_uint64 (hash, "stall-threshold-ms", stall_detector_get_threshold_ms ());
+
+	for (i = 0; i < APPLET_STATS_LAST; i++) {
+		Histogram *h = &stats.timers[i];
+
+		key = g_strdup_printf ("%s-count", timer_names[i]);
+		add_uint64 (hash, key, h->count);
+		g_free (key);
+		key = g_strdup_printf ("%s-total-us", timer_names[i]);
+		add_uint64 (hash, key, h->total_us);
+		g_free (key);
+		key = g_strdup_printf ("%s-max-us", timer_names[i]);
+		add_uint64 (hash, key, h->max_us);
+		g_free (key);
+		key = g_strdup_printf ("%s-histogram", timer_names[i]);
+		add_uint_array (hash, key, h->buckets, N_BUCKETS);
+		g_free (key);
+	}
+
+	add_uint64 (hash, "menu-items-total", stats.menu_items_total);
+	add_uint64 (hash, "menu-items-last", stats.menu_items_last);
+	add_uint64 (hash, "icon-cache-hits", stats.icon_cache_hits);
+	add_uint64 (hash, "icon-cache-misses", stats.icon_cache_misses);
+
+	return hash;
+}
@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef APPLET_STATS_H
+#define APPLET_STATS_H
+
+#include <glib.h>
+
+/* Runtime counters exported read-only over the applet's D-Bus object */
+
+typedef enum {
+	APPLET_STATS_ICON_UPDATE = 0,
+	APPLET_STATS_MENU_BUILD,
+	APPLET_STATS_SECRETS_KEYRING,
+	APPLET_STATS_SECRETS_DIALOG,
+	APPLET_STATS_STALL,
+
+	APPLET_STATS_LAST
+} AppletStatsTimer;
+
+void applet_stats_record (AppletStatsTimer timer, gint64 start_us);
+
+/* A StallFunc for the stall detector */
+void applet_stats_record_stall (gint64 duration_us);
+
+void applet_stats_record_menu_items (guint n_items);
+
+void applet_stats_icon_cache_lookup (gboolean hit);
+
+GHashTable *applet_stats_to_hash (void);
+
+#endif  /* APPLET_STATS_H */
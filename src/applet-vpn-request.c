@@ -35,6 +35,7 @@
 #include <NetworkManager.h>
 
 #include "applet-vpn-request.h"
+#include "stall-detector.h"
 
 #define APPLET_TYPE_VPN_REQUEST            (applet_vpn_request_get_type ())
 #define APPLET_VPN_REQUEST(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), APPLET_TYPE_VPN_REQUEST, AppletVpnRequest))
@@ -374,7 +375,9 @@ applet_vpn_request_get_secrets (SecretsRequest *req, GError **error)
 	g_return_val_if_fail (service_type != NULL, FALSE);
 
 	/* find the auth-dialog binary */
+	stall_trace_begin ("find_auth_dialog_binary");
 	bin_path = find_auth_dialog_binary (service_type, &supports_hints, error);
+	stall_trace_end ();
 	if (!bin_path)
 		return FALSE;
 
@@ -53,6 +53,8 @@
 #include "applet-dialogs.h"
 #include "nma-wifi-dialog.h"
 #include "applet-vpn-request.h"
+#include "applet-stats.h"
+#include "stall-detector.h"
 #include "utils.h"
 
 #if WITH_WWAN
@@ -188,6 +190,13 @@ impl_dbus_connect_to_3g_network (NMApplet *applet,
 	return FALSE;
 }
 
+static gboolean
+impl_dbus_get_stats (NMApplet *applet, GHashTable **stats, GError **error)
+{
+	*stats = applet_stats_to_hash ();
+	return TRUE;
+}
+
 #include "applet-dbus-bindings.h"
 
 /********************************************************************/
@@ -751,17 +760,6 @@ applet_menu_item_create_device_item_helper (NMDevice *device,
 	return item;
 }
 
-static void
-applet_clear_notify (NMApplet *applet)
-{
-	if (applet->notification == NULL)
-		return;
-
-	notify_notification_close (applet->notification, NULL);
-	g_object_unref (applet->notification);
-	applet->notification = NULL;
-}
-
 static gboolean
 applet_notify_server_has_actions (void)
 {
@@ -786,64 +784,139 @@ applet_notify_server_has_actions (void)
 	return has_actions;
 }
 
-void
-applet_do_notify (NMApplet *applet,
-                  NotifyUrgency urgency,
-                  const char *summary,
-                  const char *message,
-                  const char *icon,
-                  const char *action1,
-                  const char *action1_label,
-                  NotifyActionCallback action1_cb,
-                  gpointer action1_user_data)
+/* Notifications are held back for NOTIFY_COALESCE_MS so that bursts (a
+ * link flapping, say) collapse into a single bubble: a newer notification
+ * of the same category replaces a queued one.  Categories are per subject
+ * (a device path or connection UUID), so one connection never swallows
+ * another's notification.  Each category is also shown at most once every
+ * NOTIFY_RATE_LIMIT_MS, and whatever is on screen gets updated in place
+ * rather than a new bubble being created.
+ */
+#define NOTIFY_COALESCE_MS   500
+#define NOTIFY_RATE_LIMIT_MS 3000
+
+typedef struct {
+	char *category;
+	NotifyUrgency urgency;
+	char *summary;
+	char *message;
+	char *icon;
+	char *action1;
+	char *action1_label;
+	NotifyActionCallback action1_cb;
+	gpointer action1_user_data;
+} QueuedNotify;
+
+static void
+queued_notify_free (gpointer data)
 {
-	NotifyNotification *notify;
-	GError *error = NULL;
-	char *escaped;
+	QueuedNotify *qn = data;
 
-	g_return_if_fail (applet != NULL);
-	g_return_if_fail (summary != NULL);
-	g_return_if_fail (message != NULL);
+	g_free (qn->category);
+	g_free (qn->summary);
+	g_free (qn->message);
+	g_free (qn->icon);
+	g_free (qn->action1);
+	g_free (qn->action1_label);
+	g_slice_free (QueuedNotify, qn);
+}
 
+static void
+notify_queue_clear (NMApplet *applet)
+{
+	if (applet->notify_flush_id) {
+		g_source_remove (applet->notify_flush_id);
+		applet->notify_flush_id = 0;
+	}
+	g_queue_foreach (applet->notify_queue, (GFunc) queued_notify_free, NULL);
+	g_queue_clear (applet->notify_queue);
+}
+
+static void
+applet_clear_notify (NMApplet *applet)
+{
+	/* Whatever was still queued is acknowledged along with it */
+	notify_queue_clear (applet);
+
+	if (applet->notification == NULL)
+		return;
+
+	notify_notification_close (applet->notification, NULL);
+	g_object_unref (applet->notification);
+	applet->notification = NULL;
+}
+
+static char *
+notify_category (const char *subject, const char *summary, const char *action1)
+{
+	const char *kind;
+
+	/* Connected and disconnected supersede each other */
+	if (   !g_strcmp0 (action1, PREF_DISABLE_CONNECTED_NOTIFICATIONS)
+	    || !g_strcmp0 (action1, PREF_DISABLE_DISCONNECTED_NOTIFICATIONS))
+		kind = "connection";
+	else
+		kind = action1 ? action1 : summary;
+
+	return subject ? g_strdup_printf ("%s:%s", kind, subject) : g_strdup (kind);
+}
+
+static gboolean
+applet_can_notify (NMApplet *applet)
+{
 #ifdef ENABLE_INDICATOR
 	if (app_indicator_get_status (applet->app_indicator) == APP_INDICATOR_STATUS_PASSIVE)
-		return;
+		return FALSE;
 #else
 	if (!gtk_status_icon_is_embedded (applet->status_icon))
-		return;
+		return FALSE;
 #endif
 
 	/* if we're not acting as a secret agent, don't notify either */
-	if (!applet->agent)
-		return;
+	return applet->agent != NULL;
+}
 
-	applet_clear_notify (applet);
+static void
+applet_show_notify (NMApplet *applet, QueuedNotify *qn)
+{
+	NotifyNotification *notify;
+	GError *error = NULL;
+	char *escaped;
+	const char *icon = qn->icon ? qn->icon : GTK_STOCK_NETWORK;
 
-	escaped = utils_escape_notify_message (message);
-	notify = notify_notification_new (summary,
-	                                  escaped,
-	                                  icon ? icon : GTK_STOCK_NETWORK
+	escaped = utils_escape_notify_message (qn->message);
+	if (applet->notification) {
+		notify = applet->notification;
+		notify_notification_update (notify, qn->summary, escaped, icon);
+	} else {
+		notify = notify_notification_new (qn->summary,
+		                                  escaped,
+		                                  icon
 #if HAVE_LIBNOTIFY_07
-	                                  );
+		                                  );
 #else
-	                                  , NULL);
+		                                  , NULL);
 #endif
-	g_free (escaped);
-	applet->notification = notify;
+		applet->notification = notify;
 
 #if HAVE_LIBNOTIFY_07
-	notify_notification_set_hint (notify, "transient", g_variant_new_boolean (TRUE));
-	notify_notification_set_hint (notify, "desktop-entry", g_variant_new_string ("nm-applet"));
+		notify_notification_set_hint (notify, "transient", g_variant_new_boolean (TRUE));
+		notify_notification_set_hint (notify, "desktop-entry", g_variant_new_string ("nm-applet"));
 #else
-	notify_notification_attach_to_status_icon (notify, applet->status_icon);
+		notify_notification_attach_to_status_icon (notify, applet->status_icon);
 #endif
-	notify_notification_set_urgency (notify, urgency);
+	}
+	g_free (escaped);
+
+	notify_notification_set_urgency (notify, qn->urgency);
 	notify_notification_set_timeout (notify, NOTIFY_EXPIRES_DEFAULT);
 
-	if (applet_notify_server_has_actions () && action1) {
+	if (applet_notify_server_has_actions ()) {
 		notify_notification_clear_actions (notify);
-		notify_notification_add_action (notify, action1, action1_label,
-		                                action1_cb, action1_user_data, NULL);
+		if (qn->action1) {
+			notify_notification_add_action (notify, qn->action1, qn->action1_label,
+			                                qn->action1_cb, qn->action1_user_data, NULL);
+		}
 	}
 
 	if (!notify_notification_show (notify, &error)) {
@@ -853,6 +926,124 @@ applet_do_notify (NMApplet *applet,
 	}
 }
 
+/* Monotonic time (in ms) at which @category may be shown again */
+static gint64
+notify_category_next_allowed (NMApplet *applet, const char *category)
+{
+	gint64 *last;
+
+	last = g_hash_table_lookup (applet->notify_last_shown, category);
+	return last ? *last + NOTIFY_RATE_LIMIT_MS : 0;
+}
+
+static gboolean notify_queue_flush_cb (gpointer user_data);
+
+static void
+notify_queue_schedule (NMApplet *applet, guint delay_ms)
+{
+	if (applet->notify_flush_id)
+		return;
+	applet->notify_flush_id = g_timeout_add (delay_ms, notify_queue_flush_cb, applet);
+}
+
+static gboolean
+notify_queue_flush_cb (gpointer user_data)
+{
+	NMApplet *applet = NM_APPLET (user_data);
+	gint64 now = g_get_monotonic_time () / 1000;
+	gint64 next = G_MAXINT64;
+	GList *iter;
+
+	applet->notify_flush_id = 0;
+
+	if (!applet_can_notify (applet)) {
+		notify_queue_clear (applet);
+		return FALSE;
+	}
+
+	/* Show the oldest notification whose category isn't rate-limited */
+	for (iter = applet->notify_queue->head; iter; iter = g_list_next (iter)) {
+		QueuedNotify *qn = iter->data;
+		gint64 *last;
+
+		if (notify_category_next_allowed (applet, qn->category) > now)
+			continue;
+
+		applet_show_notify (applet, qn);
+
+		last = g_new (gint64, 1);
+		*last = now;
+		g_hash_table_insert (applet->notify_last_shown, g_strdup (qn->category), last);
+
+		g_queue_delete_link (applet->notify_queue, iter);
+		queued_notify_free (qn);
+		break;
+	}
+
+	/* And come back for the rest once they are allowed */
+	for (iter = applet->notify_queue->head; iter; iter = g_list_next (iter)) {
+		QueuedNotify *qn = iter->data;
+
+		next = MIN (next, notify_category_next_allowed (applet, qn->category));
+	}
+	if (next != G_MAXINT64)
+		notify_queue_schedule (applet, MAX (next - now, NOTIFY_COALESCE_MS));
+
+	return FALSE;
+}
+
+void
+applet_do_notify (NMApplet *applet,
+                  const char *subject,
+                  NotifyUrgency urgency,
+                  const char *summary,
+                  const char *message,
+                  const char *icon,
+                  const char *action1,
+                  const char *action1_label,
+                  NotifyActionCallback action1_cb,
+                  gpointer action1_user_data)
+{
+	QueuedNotify *qn = NULL;
+	char *category;
+	GList *iter;
+
+	g_return_if_fail (applet != NULL);
+	g_return_if_fail (summary != NULL);
+	g_return_if_fail (message != NULL);
+
+	if (!applet_can_notify (applet))
+		return;
+
+	/* Supersede a queued notification of the same category */
+	category = notify_category (subject, summary, action1);
+	for (iter = applet->notify_queue->head; iter; iter = g_list_next (iter)) {
+		QueuedNotify *queued = iter->data;
+
+		if (!strcmp (queued->category, category)) {
+			queued_notify_free (queued);
+			qn = iter->data = g_slice_new0 (QueuedNotify);
+			break;
+		}
+	}
+	if (!qn) {
+		qn = g_slice_new0 (QueuedNotify);
+		g_queue_push_tail (applet->notify_queue, qn);
+	}
+
+	qn->category = category;
+	qn->urgency = urgency;
+	qn->summary = g_strdup (summary);
+	qn->message = g_strdup (message);
+	qn->icon = g_strdup (icon);
+	qn->action1 = g_strdup (action1);
+	qn->action1_label = g_strdup (action1_label);
+	qn->action1_cb = action1_cb;
+	qn->action1_user_data = action1_user_data;
+
+	notify_queue_schedule (applet, NOTIFY_COALESCE_MS);
+}
+
 static void
 notify_dont_show_cb (NotifyNotification *notify,
                      gchar *id,
@@ -872,6 +1063,7 @@ notify_dont_show_cb (NotifyNotification *notify,
 }
 
 void applet_do_notify_with_pref (NMApplet *applet,
+                                 const char *subject,
                                  const char *summary,
                                  const char *message,
                                  const char *icon,
@@ -880,79 +1072,153 @@ void applet_do_notify_with_pref (NMApplet *applet,
 	if (g_settings_get_boolean (applet->gsettings, pref))
 		return;
 	
-	applet_do_notify (applet, NOTIFY_URGENCY_LOW, summary, message, icon, pref,
+	applet_do_notify (applet, subject, NOTIFY_URGENCY_LOW, summary, message, icon, pref,
 	                  _("Don't show this message again"),
 	                  notify_dont_show_cb,
 	                  applet);
 }
 
+static const char *
+link_frame_name (int stage, int step)
+{
+	static char *frames[3][NUM_CONNECTING_FRAMES];
+
+	g_return_val_if_fail (stage >= 0 && stage < 3, NULL);
+
+	step %= NUM_CONNECTING_FRAMES;
+	if (!frames[stage][step])
+		frames[stage][step] = g_strdup_printf ("nm-stage%02d-connecting%02d", stage + 1, step + 1);
+	return frames[stage][step];
+}
+
+static const char *
+vpn_frame_name (int step)
+{
+	static char *frames[NUM_VPN_CONNECTING_FRAMES];
+
+	step %= NUM_VPN_CONNECTING_FRAMES;
+	if (!frames[step])
+		frames[step] = g_strdup_printf ("nm-vpn-connecting%02d", step + 1);
+	return frames[step];
+}
+
+static void foo_set_icon (NMApplet *applet, guint32 layer, GdkPixbuf *pixbuf, char *icon_name);
+
+/* Each tick only swaps the connecting frames in; the rest of the icon and
+ * the tooltip are left as the last applet_update_icon() computed them.
+ */
 static gboolean
 animation_timeout (gpointer data)
 {
-	applet_schedule_update_icon (NM_APPLET (data));
+	NMApplet *applet = NM_APPLET (data);
+
+	applet->animation_step++;
+	if (applet->animation_link_stage >= 0) {
+		foo_set_icon (applet, ICON_LAYER_LINK, NULL,
+		              (char *) link_frame_name (applet->animation_link_stage, applet->animation_step));
+	}
+	if (applet->animation_vpn)
+		foo_set_icon (applet, ICON_LAYER_VPN, NULL, (char *) vpn_frame_name (applet->animation_step));
 	return TRUE;
 }
 
+static gboolean
+animation_visible (NMApplet *applet)
+{
+#ifdef ENABLE_INDICATOR
+	/* The indicator is passive whenever NM isn't running */
+	return nm_client_get_nm_running (applet->nm_client);
+#else
+	return    applet->visible
+	       && applet->status_icon
+	       && gtk_status_icon_is_embedded (applet->status_icon);
+#endif
+}
+
+/* Run the frame timer only while something is activating, the current icon
+ * actually has connecting frames, and somebody can see it.
+ */
+static void
+update_animation_timeout (NMApplet *applet)
+{
+	gboolean run;
+
+	run =    applet->animation_wanted
+	      && (applet->animation_link_stage >= 0 || applet->animation_vpn)
+	      && animation_visible (applet);
+
+	if (run && !applet->animation_id)
+		applet->animation_id = g_timeout_add (100, animation_timeout, applet);
+	else if (!run && applet->animation_id) {
+		g_source_remove (applet->animation_id);
+		applet->animation_id = 0;
+	}
+}
+
 static void
 start_animation_timeout (NMApplet *applet)
 {
-	if (applet->animation_id == 0) {
+	if (!applet->animation_wanted) {
+		applet->animation_wanted = TRUE;
 		applet->animation_step = 0;
-		applet->animation_id = g_timeout_add (100, animation_timeout, applet);
+		update_animation_timeout (applet);
 	}
 }
 
 static void
 clear_animation_timeout (NMApplet *applet)
 {
-	if (applet->animation_id) {
-		g_source_remove (applet->animation_id);
-		applet->animation_id = 0;
+	if (applet->animation_wanted) {
+		applet->animation_wanted = FALSE;
 		applet->animation_step = 0;
+		update_animation_timeout (applet);
 	}
 }
 
+/* Counters of activating devices and VPNs are kept current from state
+ * transitions so the animation decision doesn't have to walk every device
+ * and active connection.  The tag on each object remembers whether it is
+ * currently counted, which keeps repeated signals from skewing them.
+ */
+#define ACTIVATING_TAG "applet-activating"
+
 static gboolean
-applet_is_any_device_activating (NMApplet *applet)
+device_state_is_activating (NMDeviceState state)
 {
-	const GPtrArray *devices;
-	int i;
-
-	/* Check for activating devices */
-	devices = nm_client_get_devices (applet->nm_client);
-	for (i = 0; devices && (i < devices->len); i++) {
-		NMDevice *candidate = NM_DEVICE (g_ptr_array_index (devices, i));
-		NMDeviceState state;
-
-		state = nm_device_get_state (candidate);
-		if (state > NM_DEVICE_STATE_DISCONNECTED && state < NM_DEVICE_STATE_ACTIVATED)
-			return TRUE;
-	}
-	return FALSE;
+	return state > NM_DEVICE_STATE_DISCONNECTED && state < NM_DEVICE_STATE_ACTIVATED;
 }
 
 static gboolean
-applet_is_any_vpn_activating (NMApplet *applet)
+vpn_state_is_activating (NMVpnConnectionState state)
 {
-	const GPtrArray *connections;
-	int i;
+	return    state == NM_VPN_CONNECTION_STATE_PREPARE
+	       || state == NM_VPN_CONNECTION_STATE_NEED_AUTH
+	       || state == NM_VPN_CONNECTION_STATE_CONNECT
+	       || state == NM_VPN_CONNECTION_STATE_IP_CONFIG_GET;
+}
 
-	connections = nm_client_get_active_connections (applet->nm_client);
-	for (i = 0; connections && (i < connections->len); i++) {
-		NMActiveConnection *candidate = NM_ACTIVE_CONNECTION (g_ptr_array_index (connections, i));
-		NMVpnConnectionState vpn_state;
-
-		if (NM_IS_VPN_CONNECTION (candidate)) {
-			vpn_state = nm_vpn_connection_get_vpn_state (NM_VPN_CONNECTION (candidate));
-			if (   vpn_state == NM_VPN_CONNECTION_STATE_PREPARE
-			    || vpn_state == NM_VPN_CONNECTION_STATE_NEED_AUTH
-			    || vpn_state == NM_VPN_CONNECTION_STATE_CONNECT
-			    || vpn_state == NM_VPN_CONNECTION_STATE_IP_CONFIG_GET) {
-				return TRUE;
-			}
-		}
-	}
-	return FALSE;
+static void
+track_activating (GObject *object, gboolean activating, guint *counter)
+{
+	gboolean counted = !!g_object_get_data (object, ACTIVATING_TAG);
+
+	if (activating == counted)
+		return;
+
+	if (activating)
+		(*counter)++;
+	else if (*counter > 0)
+		(*counter)--;
+	g_object_set_data (object, ACTIVATING_TAG, GUINT_TO_POINTER (activating));
+}
+
+static void
+update_activating_animation (NMApplet *applet)
+{
+	if (applet->n_activating_devices || applet->n_activating_vpns)
+		start_animation_timeout (applet);
+	else
+		clear_animation_timeout (applet);
 }
 
 static char *
@@ -1033,21 +1299,14 @@ vpn_connection_state_changed (NMVpnConnection *vpn,
 	NMApplet *applet = NM_APPLET (user_data);
 	const char *banner;
 	char *title = NULL, *msg;
-	gboolean device_activating, vpn_activating;
 
-	device_activating = applet_is_any_device_activating (applet);
-	vpn_activating = applet_is_any_vpn_activating (applet);
+	/* Count the VPN right away since the dbus signals for new active
+	 * connections might not have come through yet.
+	 */
+	track_activating (G_OBJECT (vpn), vpn_state_is_activating (state),
+	                  &applet->n_activating_vpns);
 
 	switch (state) {
-	case NM_VPN_CONNECTION_STATE_PREPARE:
-	case NM_VPN_CONNECTION_STATE_NEED_AUTH:
-	case NM_VPN_CONNECTION_STATE_CONNECT:
-	case NM_VPN_CONNECTION_STATE_IP_CONFIG_GET:
-		/* Be sure to turn animation timeout on here since the dbus signals
-		 * for new active connections might not have come through yet.
-		 */
-		vpn_activating = TRUE;
-		break;
 	case NM_VPN_CONNECTION_STATE_ACTIVATED:
 		banner = nm_vpn_connection_get_banner (vpn);
 		if (banner && strlen (banner))
@@ -1056,14 +1315,16 @@ vpn_connection_state_changed (NMVpnConnection *vpn,
 			msg = g_strdup (_("VPN connection has been successfully established.\n"));
 
 		title = _("VPN Login Message");
-		applet_do_notify_with_pref (applet, title, msg, "gnome-lockscreen",
+		applet_do_notify_with_pref (applet, nm_active_connection_get_uuid (NM_ACTIVE_CONNECTION (vpn)),
+		                            title, msg, "gnome-lockscreen",
 		                            PREF_DISABLE_VPN_NOTIFICATIONS);
 		g_free (msg);
 		break;
 	case NM_VPN_CONNECTION_STATE_FAILED:
 		title = _("VPN Connection Failed");
 		msg = make_vpn_failure_message (vpn, reason, applet);
-		applet_do_notify_with_pref (applet, title, msg, "gnome-lockscreen",
+		applet_do_notify_with_pref (applet, nm_active_connection_get_uuid (NM_ACTIVE_CONNECTION (vpn)),
+		                            title, msg, "gnome-lockscreen",
 		                            PREF_DISABLE_VPN_NOTIFICATIONS);
 		g_free (msg);
 		break;
@@ -1071,7 +1332,8 @@ vpn_connection_state_changed (NMVpnConnection *vpn,
 		if (reason != NM_VPN_CONNECTION_STATE_REASON_USER_DISCONNECTED) {
 			title = _("VPN Connection Failed");
 			msg = make_vpn_disconnection_message (vpn, reason, applet);
-			applet_do_notify_with_pref (applet, title, msg, "gnome-lockscreen",
+			applet_do_notify_with_pref (applet, nm_active_connection_get_uuid (NM_ACTIVE_CONNECTION (vpn)),
+			                            title, msg, "gnome-lockscreen",
 			                            PREF_DISABLE_VPN_NOTIFICATIONS);
 			g_free (msg);
 		}
@@ -1080,10 +1342,7 @@ vpn_connection_state_changed (NMVpnConnection *vpn,
 		break;
 	}
 
-	if (device_activating || vpn_activating)
-		start_animation_timeout (applet);
-	else
-		clear_animation_timeout (applet);
+	update_activating_animation (applet);
 
 	applet_schedule_update_icon (applet);
 	applet_schedule_update_menu (applet);
@@ -1092,6 +1351,7 @@ vpn_connection_state_changed (NMVpnConnection *vpn,
 typedef struct {
 	NMApplet *applet;
 	char *vpn_name;
+	char *vpn_uuid;
 } VPNActivateInfo;
 
 static void
@@ -1124,7 +1384,8 @@ activate_vpn_cb (GObject *client,
 			                       info->vpn_name, error->message);
 		}
 
-		applet_do_notify_with_pref (info->applet, title, msg, "gnome-lockscreen",
+		applet_do_notify_with_pref (info->applet, info->vpn_uuid,
+		                            title, msg, "gnome-lockscreen",
 		                            PREF_DISABLE_VPN_NOTIFICATIONS);
 		g_warning ("VPN Connection activation failed: (%s) %s", name, error->message);
 		g_free (msg);
@@ -1134,6 +1395,7 @@ activate_vpn_cb (GObject *client,
 	applet_schedule_update_icon (info->applet);
 	applet_schedule_update_menu (info->applet);
 	g_free (info->vpn_name);
+	g_free (info->vpn_uuid);
 	g_free (info);
 }
 
@@ -1173,6 +1435,7 @@ nma_menu_vpn_item_clicked (GtkMenuItem *item, gpointer user_data)
 	info = g_malloc0 (sizeof (VPNActivateInfo));
 	info->applet = applet;
 	info->vpn_name = g_strdup (nm_connection_get_id (connection));
+	info->vpn_uuid = g_strdup (nm_connection_get_uuid (connection));
 
 	/* Connection inactive, activate */
 	nm_client_activate_connection_async (applet->nm_client,
@@ -1734,22 +1997,52 @@ has_usable_wifi (NMApplet *applet)
  * Pop up the wifi networks menu
  *
  */
+static void
+count_menu_items_cb (GtkWidget *widget, gpointer user_data)
+{
+	guint *n_items = user_data;
+	GtkWidget *submenu;
+
+	(*n_items)++;
+	if (GTK_IS_MENU_ITEM (widget)) {
+		submenu = gtk_menu_item_get_submenu (GTK_MENU_ITEM (widget));
+		if (submenu)
+			gtk_container_foreach (GTK_CONTAINER (submenu), count_menu_items_cb, n_items);
+	}
+}
+
+/* Items in @menu and all of its submenus */
+static guint
+count_menu_items (GtkWidget *menu)
+{
+	guint n_items = 0;
+
+	gtk_container_foreach (GTK_CONTAINER (menu), count_menu_items_cb, &n_items);
+	return n_items;
+}
+
 static void nma_menu_show_cb (GtkWidget *menu, NMApplet *applet)
 {
+	gint64 start = g_get_monotonic_time ();
+
 	g_return_if_fail (menu != NULL);
 	g_return_if_fail (applet != NULL);
 
+	stall_trace_begin ("nma_menu_show_cb");
+
 #ifndef ENABLE_INDICATOR
 	gtk_status_icon_set_tooltip_text (applet->status_icon, NULL);
 #endif
 
 	if (!nm_client_get_nm_running (applet->nm_client)) {
 		nma_menu_add_text_item (menu, _("NetworkManager is not running..."));
+		stall_trace_end ();
 		return;
 	}
 
 	if (nm_client_get_state (applet->nm_client) == NM_STATE_ASLEEP) {
 		nma_menu_add_text_item (menu, _("Networking disabled"));
+		stall_trace_end ();
 		return;
 	}
 
@@ -1767,6 +2060,10 @@ static void nma_menu_show_cb (GtkWidget *menu, NMApplet *applet)
 	gtk_widget_show_all (menu);
 #endif
 
+	stall_trace_end ();
+	applet_stats_record (APPLET_STATS_MENU_BUILD, start);
+	applet_stats_record_menu_items (count_menu_items (menu));
+
 //	nmi_dbus_signal_user_interface_activated (applet->connection);
 }
 
@@ -2256,39 +2553,21 @@ applet_get_exported_connection_for_device (NMDevice *device, NMApplet *applet)
 }
 
 static void
-applet_common_device_state_changed (NMDevice *device,
-                                    NMDeviceState new_state,
-                                    NMDeviceState old_state,
-                                    NMDeviceStateReason reason,
-                                    NMApplet *applet)
+foo_device_activating_cb (NMDevice *device,
+                          NMDeviceState new_state,
+                          NMDeviceState old_state,
+                          NMDeviceStateReason reason,
+                          gpointer user_data)
 {
-	gboolean device_activating = FALSE, vpn_activating = FALSE;
+	NMApplet *applet = NM_APPLET (user_data);
 
-	device_activating = applet_is_any_device_activating (applet);
-	vpn_activating = applet_is_any_vpn_activating (applet);
-
-	switch (new_state) {
-	case NM_DEVICE_STATE_PREPARE:
-	case NM_DEVICE_STATE_CONFIG:
-	case NM_DEVICE_STATE_NEED_AUTH:
-	case NM_DEVICE_STATE_IP_CONFIG:
-		/* Be sure to turn animation timeout on here since the dbus signals
-		 * for new active connections or devices might not have come through yet.
-		 */
-		device_activating = TRUE;
-		break;
-	case NM_DEVICE_STATE_ACTIVATED:
-	default:
-		break;
-	}
+	track_activating (G_OBJECT (device), device_state_is_activating (new_state),
+	                  &applet->n_activating_devices);
 
 	/* If there's an activating device but we're not animating, start animation.
 	 * If we're animating, but there's no activating device or VPN, stop animating.
 	 */
-	if (device_activating || vpn_activating)
-		start_animation_timeout (applet);
-	else
-		clear_animation_timeout (applet);
+	update_activating_animation (applet);
 }
 
 static void
@@ -2306,7 +2585,6 @@ foo_device_state_changed_cb (NMDevice *device,
 
 	if (dclass->device_state_changed)
 		dclass->device_state_changed (device, new_state, old_state, reason, applet);
-	applet_common_device_state_changed (device, new_state, old_state, reason, applet);
 
 	if (   new_state == NM_DEVICE_STATE_ACTIVATED
 	    && !g_settings_get_boolean (applet->gsettings, PREF_DISABLE_CONNECTED_NOTIFICATIONS)) {
@@ -2333,6 +2611,19 @@ foo_device_added_cb (NMClient *client, NMDevice *device, gpointer user_data)
 	NMApplet *applet = NM_APPLET (user_data);
 	NMADeviceClass *dclass;
 
+	/* Every device counts towards the animation, including ones without a
+	 * device class; it may also already be activating.
+	 */
+	g_signal_handlers_disconnect_by_func (device, foo_device_activating_cb, applet);
+	g_signal_connect (device, "state-changed",
+	                  G_CALLBACK (foo_device_activating_cb),
+	                  applet);
+	foo_device_activating_cb (device,
+	                          nm_device_get_state (device),
+	                          NM_DEVICE_STATE_UNKNOWN,
+	                          NM_DEVICE_STATE_REASON_NONE,
+	                          applet);
+
 	dclass = get_device_class (device, applet);
 	if (!dclass)
 		return;
@@ -2358,7 +2649,7 @@ foo_client_state_changed_cb (NMClient *client, GParamSpec *pspec, gpointer user_
 
 	switch (nm_client_get_state (client)) {
 	case NM_STATE_DISCONNECTED:
-		applet_do_notify_with_pref (applet, _("Disconnected"),
+		applet_do_notify_with_pref (applet, NULL, _("Disconnected"),
 		                            _("The network connection has been disconnected."),
 		                            "nm-no-connection",
 		                            PREF_DISABLE_DISCONNECTED_NOTIFICATIONS);
@@ -2371,16 +2662,20 @@ foo_client_state_changed_cb (NMClient *client, GParamSpec *pspec, gpointer user_
 	applet_schedule_update_menu (applet);
 }
 
-#ifdef ENABLE_INDICATOR
 static void
 foo_device_removed_cb (NMClient *client, NMDevice *device, gpointer user_data)
 {
 	NMApplet *applet = NM_APPLET (user_data);
 
+	g_signal_handlers_disconnect_by_func (device, foo_device_activating_cb, applet);
+	track_activating (G_OBJECT (device), FALSE, &applet->n_activating_devices);
+	update_activating_animation (applet);
+
+#ifdef ENABLE_INDICATOR
 	applet_schedule_update_icon (applet);
 	applet_schedule_update_menu (applet);
-}
 #endif
+}
 
 static void
 foo_manager_running_cb (NMClient *client,
@@ -2424,12 +2719,31 @@ foo_active_connections_changed_cb (NMClient *client,
 		id = g_signal_connect (G_OBJECT (candidate), "vpn-state-changed",
 		                       G_CALLBACK (vpn_connection_state_changed), applet);
 		g_object_set_data (G_OBJECT (candidate), VPN_STATE_ID_TAG, GUINT_TO_POINTER (id));
+
+		track_activating (G_OBJECT (candidate),
+		                  vpn_state_is_activating (nm_vpn_connection_get_vpn_state (NM_VPN_CONNECTION (candidate))),
+		                  &applet->n_activating_vpns);
 	}
+	update_activating_animation (applet);
 
 	applet_schedule_update_icon (applet);
 	applet_schedule_update_menu (applet);
 }
 
+static void
+foo_active_connection_removed_cb (NMClient *client,
+                                  NMActiveConnection *active,
+                                  gpointer user_data)
+{
+	NMApplet *applet = NM_APPLET (user_data);
+
+	if (!NM_IS_VPN_CONNECTION (active))
+		return;
+
+	track_activating (G_OBJECT (active), FALSE, &applet->n_activating_vpns);
+	update_activating_animation (applet);
+}
+
 static void
 foo_manager_permission_changed (NMClient *client,
                                 NMClientPermission permission,
@@ -2465,7 +2779,9 @@ foo_client_setup (NMApplet *applet)
 {
 	NMClientPermission perm;
 
+	stall_trace_begin ("nm_client_new");
 	applet->nm_client = nm_client_new (NULL, NULL);
+	stall_trace_end ();
 	if (!applet->nm_client)
 		return;
 
@@ -2478,11 +2794,12 @@ foo_client_setup (NMApplet *applet)
 	g_signal_connect (applet->nm_client, "device-added",
 	                  G_CALLBACK (foo_device_added_cb),
 	                  applet);
-#ifdef ENABLE_INDICATOR
 	g_signal_connect (applet->nm_client, "device-removed",
 	                  G_CALLBACK (foo_device_removed_cb),
 	                  applet);
-#endif
+	g_signal_connect (applet->nm_client, "active-connection-removed",
+	                  G_CALLBACK (foo_active_connection_removed_cb),
+	                  applet);
 	g_signal_connect (applet->nm_client, "notify::manager-running",
 	                  G_CALLBACK (foo_manager_running_cb),
 	                  applet);
@@ -2584,18 +2901,15 @@ applet_common_get_device_icon (NMDeviceState state,
 	}
 
 	if (stage >= 0) {
-		char *name = g_strdup_printf ("nm-stage%02d-connecting%02d", stage + 1, applet->animation_step + 1);
+		const char *name = link_frame_name (stage, applet->animation_step);
 
 		if (out_pixbuf)
 			*out_pixbuf = g_object_ref (nma_icon_check_and_load (name, applet));
 		if (out_icon_name)
-			*out_icon_name = name;
-		else
-			g_free (name);
+			*out_icon_name = g_strdup (name);
 
-		applet->animation_step++;
-		if (applet->animation_step >= NUM_CONNECTING_FRAMES)
-			applet->animation_step = 0;
+		/* animation_timeout() advances the frames from here on */
+		applet->animation_link_stage = stage;
 	}
 }
 
@@ -2725,8 +3039,11 @@ applet_update_icon (gpointer user_data)
 	NMVpnConnectionState vpn_state = NM_VPN_CONNECTION_STATE_UNKNOWN;
 	gboolean nm_running;
 	NMActiveConnection *active_vpn = NULL;
+	gint64 start = g_get_monotonic_time ();
 
 	applet->update_icon_id = 0;
+	applet->animation_link_stage = -1;
+	applet->animation_vpn = FALSE;
 
 	nm_running = nm_client_get_nm_running (applet->nm_client);
 
@@ -2776,10 +3093,8 @@ applet_update_icon (gpointer user_data)
 		case NM_VPN_CONNECTION_STATE_NEED_AUTH:
 		case NM_VPN_CONNECTION_STATE_CONNECT:
 		case NM_VPN_CONNECTION_STATE_IP_CONFIG_GET:
-			icon_name = g_strdup_printf ("nm-vpn-connecting%02d", applet->animation_step + 1);
-			applet->animation_step++;
-			if (applet->animation_step >= NUM_VPN_CONNECTING_FRAMES)
-				applet->animation_step = 0;
+			icon_name = g_strdup (vpn_frame_name (applet->animation_step));
+			applet->animation_vpn = TRUE;
 			break;
 		default:
 			break;
@@ -2811,6 +3126,9 @@ applet_update_icon (gpointer user_data)
 	g_free (vpn_tip);
 	g_free (dev_tip);
 
+	update_animation_timeout (applet);
+
+	applet_stats_record (APPLET_STATS_ICON_UPDATE, start);
 	return FALSE;
 }
 
@@ -2823,6 +3141,46 @@ applet_schedule_update_icon (NMApplet *applet)
 
 /*****************************************************************************/
 
+typedef struct {
+	gpointer reqid;
+	AppletAgentSecretsCallback callback;
+	gpointer callback_data;
+} SecretsRequestWaiter;
+
+static char *
+secrets_request_key (NMConnection *connection,
+                     const char *setting_name,
+                     const char **hints,
+                     guint32 flags)
+{
+	GString *key;
+	int i;
+
+	key = g_string_new (nm_connection_get_uuid (connection));
+	g_string_append_printf (key, "/%s/%u", setting_name, flags);
+	for (i = 0; hints && hints[i]; i++)
+		g_string_append_printf (key, "/%s", hints[i]);
+
+	return g_string_free (key, FALSE);
+}
+
+static void
+secrets_request_add_waiter (SecretsRequest *req,
+                            gpointer request_id,
+                            AppletAgentSecretsCallback callback,
+                            gpointer callback_data)
+{
+	SecretsRequestWaiter *waiter;
+
+	waiter = g_slice_new (SecretsRequestWaiter);
+	waiter->reqid = request_id;
+	waiter->callback = callback;
+	waiter->callback_data = callback_data;
+	req->waiters = g_slist_append (req->waiters, waiter);
+
+	g_hash_table_insert (req->applet->secrets_reqs, request_id, req);
+}
+
 static SecretsRequest *
 applet_secrets_request_new (size_t totsize,
                             NMConnection *connection,
@@ -2842,13 +3200,15 @@ applet_secrets_request_new (size_t totsize,
 	req = g_malloc0 (totsize);
 	req->totsize = totsize;
 	req->connection = g_object_ref (connection);
-	req->reqid = request_id;
 	req->setting_name = g_strdup (setting_name);
 	req->hints = g_strdupv ((char **) hints);
 	req->flags = flags;
-	req->callback = callback;
-	req->callback_data = callback_data;
 	req->applet = applet;
+
+	req->key = secrets_request_key (connection, setting_name, hints, flags);
+	g_hash_table_insert (applet->secrets_reqs_by_key, req->key, req);
+	secrets_request_add_waiter (req, request_id, callback, callback_data);
+
 	return req;
 }
 
@@ -2859,12 +3219,26 @@ applet_secrets_request_set_free_func (SecretsRequest *req,
 	req->free_func = free_func;
 }
 
+static void
+secrets_request_notify_waiters (SecretsRequest *req,
+                                GVariant *settings,
+                                GError *error)
+{
+	GSList *iter;
+
+	for (iter = req->waiters; iter; iter = g_slist_next (iter)) {
+		SecretsRequestWaiter *waiter = iter->data;
+
+		waiter->callback (req->applet->agent, settings, error, waiter->callback_data);
+	}
+}
+
 void
 applet_secrets_request_complete (SecretsRequest *req,
                                  GVariant *settings,
                                  GError *error)
 {
-	req->callback (req->applet->agent, error ? NULL : settings, error, req->callback_data);
+	secrets_request_notify_waiters (req, error ? NULL : settings, error);
 }
 
 void
@@ -2895,18 +3269,30 @@ applet_secrets_request_complete_setting (SecretsRequest *req,
 		}
 	}
 
-	req->callback (req->applet->agent, secrets_dict, error, req->callback_data);
+	secrets_request_notify_waiters (req, secrets_dict, error);
 }
 
 void
 applet_secrets_request_free (SecretsRequest *req)
 {
+	GSList *iter;
+
 	g_return_if_fail (req != NULL);
 
 	if (req->free_func)
 		req->free_func (req);
 
-	req->applet->secrets_reqs = g_slist_remove (req->applet->secrets_reqs, req);
+	for (iter = req->waiters; iter; iter = g_slist_next (iter)) {
+		SecretsRequestWaiter *waiter = iter->data;
+
+		g_hash_table_remove (req->applet->secrets_reqs, waiter->reqid);
+		g_slice_free (SecretsRequestWaiter, waiter);
+	}
+	g_slist_free (req->waiters);
+
+	if (g_hash_table_lookup (req->applet->secrets_reqs_by_key, req->key) == req)
+		g_hash_table_remove (req->applet->secrets_reqs_by_key, req->key);
+	g_free (req->key);
 
 	g_object_unref (req->connection);
 	g_free (req->setting_name);
@@ -2958,10 +3344,23 @@ applet_agent_get_secrets_cb (AppletAgent *agent,
 	NMADeviceClass *dclass;
 	GError *error = NULL;
 	SecretsRequest *req = NULL;
+	char *key;
 
 	s_con = nm_connection_get_setting_connection (connection);
 	g_return_if_fail (s_con != NULL);
 
+	/* If the same secrets are already being asked for (NM retrying, or
+	 * several devices activating the same profile) just wait for that
+	 * request instead of starting another dialog or auth-dialog process.
+	 */
+	key = secrets_request_key (connection, setting_name, hints, flags);
+	req = g_hash_table_lookup (applet->secrets_reqs_by_key, key);
+	g_free (key);
+	if (req) {
+		secrets_request_add_waiter (req, request_id, callback, callback_data);
+		return;
+	}
+
 	/* VPN secrets get handled a bit differently */
 	if (!strcmp (nm_setting_connection_get_connection_type (s_con), NM_SETTING_VPN_SETTING_NAME)) {
 		req = applet_secrets_request_new (applet_vpn_request_get_secrets_size (),
@@ -2975,8 +3374,6 @@ applet_agent_get_secrets_cb (AppletAgent *agent,
 		                                  applet);
 		if (!applet_vpn_request_get_secrets (req, &error))
 			goto error;
-
-		applet->secrets_reqs = g_slist_prepend (applet->secrets_reqs, req);
 		return;
 	}
 
@@ -3007,7 +3404,6 @@ applet_agent_get_secrets_cb (AppletAgent *agent,
 	                                  callback,
 	                                  callback_data,
 	                                  applet);
-	applet->secrets_reqs = g_slist_prepend (applet->secrets_reqs, req);
 
 	/* Get existing secrets, if any */
 	nm_secret_agent_old_get_secrets (NM_SECRET_AGENT_OLD (applet->agent),
@@ -3034,18 +3430,30 @@ applet_agent_cancel_secrets_cb (AppletAgent *agent,
                                 gpointer user_data)
 {
 	NMApplet *applet = NM_APPLET (user_data);
-	GSList *iter, *next;
+	SecretsRequest *req;
+	GSList *iter;
+
+	req = g_hash_table_lookup (applet->secrets_reqs, request_id);
+	if (!req)
+		return;
 
-	for (iter = applet->secrets_reqs; iter; iter = next) {
-		SecretsRequest *req = iter->data;
+	if (!req->waiters->next) {
+		/* cancel and free this password request */
+		applet_secrets_request_free (req);
+		return;
+	}
 
-		next = g_slist_next (iter);
+	/* Others are still waiting for these secrets; just drop this waiter */
+	for (iter = req->waiters; iter; iter = g_slist_next (iter)) {
+		SecretsRequestWaiter *waiter = iter->data;
 
-		if (req->reqid == request_id) {
-			/* cancel and free this password request */
-			applet_secrets_request_free (req);
+		if (waiter->reqid == request_id) {
+			req->waiters = g_slist_delete_link (req->waiters, iter);
+			g_slice_free (SecretsRequestWaiter, waiter);
+			break;
 		}
 	}
+	g_hash_table_remove (applet->secrets_reqs, request_id);
 }
 
 /*****************************************************************************/
@@ -3080,7 +3488,9 @@ nma_icon_check_and_load (const char *name, NMApplet *applet)
 	g_assert (applet != NULL);
 
 	/* icon already loaded successfully */
-	if ((icon = g_hash_table_lookup (applet->icon_cache, name)))
+	icon = g_hash_table_lookup (applet->icon_cache, name);
+	applet_stats_icon_cache_lookup (icon != NULL);
+	if (icon)
 		return icon;
 
 	/* Try to load the icon; if the load fails, log the problem, and set
@@ -3112,6 +3522,7 @@ nma_icons_reload (NMApplet *applet)
 	g_return_val_if_fail (applet->icon_size > 0, FALSE);
 
 	g_hash_table_remove_all (applet->icon_cache);
+	g_hash_table_remove_all (applet->mb_icon_cache);
 	nma_icons_free (applet);
 
 	loader = gdk_pixbuf_loader_new_with_type ("png", &error);
@@ -3292,10 +3703,14 @@ connection_added_cb (NMClient *client, NMRemoteConnection *connection, gpointer
 static void
 applet_embedded_cb (GObject *object, GParamSpec *pspec, gpointer user_data)
 {
+	NMApplet *applet = NM_APPLET (user_data);
 	gboolean embedded = gtk_status_icon_is_embedded (GTK_STATUS_ICON (object));
 
 	g_debug ("applet now %s the notification area",
 	         embedded ? "embedded in" : "removed from");
+
+	/* Nobody sees the connecting animation outside the notification area */
+	update_animation_timeout (applet);
 }
 #endif
 
@@ -3374,19 +3789,24 @@ applet_gsettings_show_changed (GSettings *settings,
 #ifndef ENABLE_INDICATOR
 	gtk_status_icon_set_visible (applet->status_icon, applet->visible);
 #endif
+	update_animation_timeout (applet);
 }
 
 static gboolean
 initable_init (GInitable *initable, GCancellable *cancellable, GError **error)
 {
 	NMApplet *applet = NM_APPLET (initable);
+	gboolean success;
 
 	g_set_application_name (_("NetworkManager Applet"));
 	gtk_window_set_default_icon_name (GTK_STOCK_NETWORK);
 
 	applet->info_dialog_ui = gtk_builder_new ();
 
-	if (!gtk_builder_add_from_file (applet->info_dialog_ui, UIDIR "/info.ui", error)) {
+	stall_trace_begin ("gtk_builder_add_from_file");
+	success = gtk_builder_add_from_file (applet->info_dialog_ui, UIDIR "/info.ui", error);
+	stall_trace_end ();
+	if (!success) {
 		g_prefix_error (error, "Couldn't load info dialog ui file: ");
 		return FALSE;
 	}
@@ -3408,6 +3828,10 @@ initable_init (GInitable *initable, GCancellable *cancellable, GError **error)
 	                                            g_str_equal,
 	                                            g_free,
 	                                            g_object_unref);
+	applet->mb_icon_cache = g_hash_table_new_full (g_str_hash,
+	                                               g_str_equal,
+	                                               g_free,
+	                                               g_object_unref);
 	nma_icons_init (applet);
 
 	if (!notify_is_initted ())
@@ -3442,8 +3866,8 @@ initable_init (GInitable *initable, GCancellable *cancellable, GError **error)
 	 * notification area applet from the panel, and thus nm-applet too.
 	 */
 	g_signal_connect (applet->status_icon, "notify::embedded",
-	                  G_CALLBACK (applet_embedded_cb), NULL);
-	applet_embedded_cb (G_OBJECT (applet->status_icon), NULL, NULL);
+	                  G_CALLBACK (applet_embedded_cb), applet);
+	applet_embedded_cb (G_OBJECT (applet->status_icon), NULL, applet);
 #endif
 
 	if (with_agent)
@@ -3465,6 +3889,8 @@ static void finalize (GObject *object)
 
 	if (applet->update_icon_id)
 		g_source_remove (applet->update_icon_id);
+	if (applet->animation_id)
+		g_source_remove (applet->animation_id);
 
 #ifdef ENABLE_INDICATOR
 	g_clear_object (&applet->app_indicator);
@@ -3478,15 +3904,31 @@ static void finalize (GObject *object)
 	g_free (applet->tip);
 	nma_icons_free (applet);
 #endif
+	g_clear_pointer (&applet->mb_icon_cache, g_hash_table_destroy);
 
-	while (g_slist_length (applet->secrets_reqs))
-		applet_secrets_request_free ((SecretsRequest *) applet->secrets_reqs->data);
+	while (g_hash_table_size (applet->secrets_reqs)) {
+		GHashTableIter iter;
+		SecretsRequest *req;
 
+		g_hash_table_iter_init (&iter, applet->secrets_reqs);
+		g_hash_table_iter_next (&iter, NULL, (gpointer) &req);
+		applet_secrets_request_free (req);
+	}
+	g_hash_table_destroy (applet->secrets_reqs);
+	g_hash_table_destroy (applet->secrets_reqs_by_key);
+
+	if (applet->notify_flush_id)
+		g_source_remove (applet->notify_flush_id);
+	g_queue_free_full (applet->notify_queue, queued_notify_free);
+	g_hash_table_destroy (applet->notify_last_shown);
 	if (applet->notification) {
 		notify_notification_close (applet->notification, NULL);
 		g_object_unref (applet->notification);
 	}
 
+	if (applet->info_dialog_update_id)
+		g_source_remove (applet->info_dialog_update_id);
+	g_clear_pointer (&applet->info_dialog_pages, g_hash_table_destroy);
 	g_clear_object (&applet->info_dialog_ui);
 	g_clear_object (&applet->gsettings);
 	g_clear_object (&applet->nm_client);
@@ -3504,6 +3946,13 @@ static void finalize (GObject *object)
 static void nma_init (NMApplet *applet)
 {
 	applet->icon_size = 16;
+	applet->animation_link_stage = -1;
+
+	applet->secrets_reqs = g_hash_table_new (NULL, NULL);
+	applet->secrets_reqs_by_key = g_hash_table_new (g_str_hash, g_str_equal);
+
+	applet->notify_queue = g_queue_new ();
+	applet->notify_last_shown = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 }
 
 static void nma_class_init (NMAppletClass *klass)
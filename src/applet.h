@@ -114,11 +114,17 @@ typedef struct
 	/* Animation stuff */
 	int				animation_step;
 	guint			animation_id;
+	gboolean		animation_wanted;
+	int				animation_link_stage;	/* -1 unless the link icon is a connecting frame */
+	gboolean		animation_vpn;			/* VPN layer shows a connecting frame */
+	guint			n_activating_devices;
+	guint			n_activating_vpns;
 #define NUM_CONNECTING_FRAMES 11
 #define NUM_VPN_CONNECTING_FRAMES 14
 
 	GtkIconTheme *	icon_theme;
 	GHashTable *	icon_cache;
+	GHashTable *	mb_icon_cache;
 	GdkPixbuf *		fallback_icon;
 	int             icon_size;
 
@@ -150,10 +156,18 @@ typedef struct
 	GtkWidget *		connections_menu_item;
 
 	GtkBuilder *	info_dialog_ui;
+	GHashTable *	info_dialog_pages;
+	guint			info_dialog_update_id;
 	NotifyNotification*	notification;
+	GQueue *		notify_queue;
+	GHashTable *	notify_last_shown;
+	guint			notify_flush_id;
 
-	/* Tracker objects for secrets requests */
-	GSList *        secrets_reqs;
+	/* Tracker objects for secrets requests: request id -> SecretsRequest,
+	 * and request key (see SecretsRequest) -> SecretsRequest.
+	 */
+	GHashTable *    secrets_reqs;
+	GHashTable *    secrets_reqs_by_key;
 } NMApplet;
 
 typedef void (*AppletNewAutoConnectionCallback) (NMConnection *connection,
@@ -166,13 +180,17 @@ typedef void (*SecretsRequestFreeFunc) (SecretsRequest *req);
 
 struct _SecretsRequest {
 	size_t totsize;
-	gpointer reqid;
 	char *setting_name;
 	char **hints;
 	guint32 flags;
 	NMApplet *applet;
-	AppletAgentSecretsCallback callback;
-	gpointer callback_data;
+
+	/* Identical requests (same connection UUID, setting, hints and flags)
+	 * that arrive while this one is in progress are attached as additional
+	 * waiters and completed together with it.
+	 */
+	char *key;
+	GSList *waiters;
 
 	NMConnection *connection;
 
@@ -271,6 +289,7 @@ NMRemoteConnection *applet_get_exported_connection_for_device (NMDevice *device,
 NMDevice *applet_get_device_for_connection (NMApplet *applet, NMConnection *connection);
 
 void applet_do_notify (NMApplet *applet,
+                       const char *subject,
                        NotifyUrgency urgency,
                        const char *summary,
                        const char *message,
@@ -281,6 +300,7 @@ void applet_do_notify (NMApplet *applet,
                        gpointer action1_user_data);
 
 void applet_do_notify_with_pref (NMApplet *applet,
+                                 const char *subject,
                                  const char *summary,
                                  const char *message,
                                  const char *icon,
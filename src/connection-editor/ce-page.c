@@ -30,6 +30,7 @@
 #include <glib/gi18n.h>
 
 #include "ce-page.h"
+#include "stall-detector.h"
 
 G_DEFINE_ABSTRACT_TYPE (CEPage, ce_page, G_TYPE_OBJECT)
 
@@ -280,56 +281,211 @@ ce_page_interface_name_valid (const char *iface, const char *property_name, GErr
 	return TRUE;
 }
 
-static char **
+/* Editor-wide catalogue of devices formatted for the device combos, shared
+ * by every page through the NMClient and kept current from its device
+ * signals, so pages don't each walk and reformat the whole device list.
+ */
+#define DEVICE_CATALOGUE_TAG "ce-page-device-catalogue"
+
+typedef struct {
+	GHashTable *lists;  /* "type/mac-property/ifname-first" -> DeviceList */
+} DeviceCatalogue;
+
+typedef struct {
+	GType device_type;
+	char *mac_property;
+	gboolean ifname_first;
+	GPtrArray *entries;  /* DeviceEntry */
+} DeviceList;
+
+typedef struct {
+	DeviceList *list;
+	NMDevice *device;
+	gulong mac_id;
+	char *ifname;
+	char *mac;
+	char *text;
+} DeviceEntry;
+
+static void
+device_entry_free (DeviceEntry *entry)
+{
+	if (entry->mac_id)
+		g_signal_handler_disconnect (entry->device, entry->mac_id);
+	g_object_unref (entry->device);
+	g_free (entry->ifname);
+	g_free (entry->mac);
+	g_free (entry->text);
+	g_slice_free (DeviceEntry, entry);
+}
+
+static void
+device_entry_update_text (DeviceEntry *entry)
+{
+	g_free (entry->text);
+	if (entry->ifname && entry->mac) {
+		if (entry->list->ifname_first)
+			entry->text = g_strdup_printf ("%s (%s)", entry->ifname, entry->mac);
+		else
+			entry->text = g_strdup_printf ("%s (%s)", entry->mac, entry->ifname);
+	} else
+		entry->text = g_strdup (entry->ifname ? entry->ifname : entry->mac);
+}
+
+/* The MAC can change under us (e.g. MAC randomization); keep the cached
+ * text in step so combos built later don't offer a stale address.
+ */
+static void
+device_entry_mac_changed (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	DeviceEntry *entry = user_data;
+
+	g_free (entry->mac);
+	g_object_get (object, entry->list->mac_property, &entry->mac, NULL);
+	device_entry_update_text (entry);
+}
+
+static DeviceEntry *
+device_entry_new (DeviceList *list, NMDevice *dev)
+{
+	DeviceEntry *entry;
+
+	entry = g_slice_new0 (DeviceEntry);
+	entry->list = list;
+	entry->device = g_object_ref (dev);
+
+	if (list->device_type == NM_TYPE_DEVICE_BT)
+		entry->ifname = g_strdup (nm_device_bt_get_name (NM_DEVICE_BT (dev)));
+	else
+		entry->ifname = g_strdup (nm_device_get_iface (dev));
+	if (list->mac_property) {
+		char *signal = g_strdup_printf ("notify::%s", list->mac_property);
+
+		g_object_get (G_OBJECT (dev), list->mac_property, &entry->mac, NULL);
+		entry->mac_id = g_signal_connect (dev, signal,
+		                                  G_CALLBACK (device_entry_mac_changed), entry);
+		g_free (signal);
+	}
+	device_entry_update_text (entry);
+
+	return entry;
+}
+
+static void
+device_list_free (DeviceList *list)
+{
+	g_free (list->mac_property);
+	g_ptr_array_unref (list->entries);
+	g_slice_free (DeviceList, list);
+}
+
+static void
+device_catalogue_free (DeviceCatalogue *catalogue)
+{
+	g_hash_table_destroy (catalogue->lists);
+	g_slice_free (DeviceCatalogue, catalogue);
+}
+
+static void
+device_catalogue_device_added (NMClient *client, NMDevice *dev, gpointer user_data)
+{
+	DeviceCatalogue *catalogue = user_data;
+	GHashTableIter iter;
+	DeviceList *list;
+
+	g_hash_table_iter_init (&iter, catalogue->lists);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &list)) {
+		if (G_TYPE_CHECK_INSTANCE_TYPE (dev, list->device_type))
+			g_ptr_array_add (list->entries, device_entry_new (list, dev));
+	}
+}
+
+static void
+device_catalogue_device_removed (NMClient *client, NMDevice *dev, gpointer user_data)
+{
+	DeviceCatalogue *catalogue = user_data;
+	GHashTableIter iter;
+	DeviceList *list;
+	int i;
+
+	g_hash_table_iter_init (&iter, catalogue->lists);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &list)) {
+		for (i = 0; i < list->entries->len; i++) {
+			DeviceEntry *entry = g_ptr_array_index (list->entries, i);
+
+			if (entry->device == dev) {
+				g_ptr_array_remove_index (list->entries, i);
+				break;
+			}
+		}
+	}
+}
+
+static DeviceCatalogue *
+device_catalogue_get (NMClient *client)
+{
+	DeviceCatalogue *catalogue;
+
+	catalogue = g_object_get_data (G_OBJECT (client), DEVICE_CATALOGUE_TAG);
+	if (catalogue)
+		return catalogue;
+
+	catalogue = g_slice_new0 (DeviceCatalogue);
+	catalogue->lists = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                          g_free, (GDestroyNotify) device_list_free);
+	g_object_set_data_full (G_OBJECT (client), DEVICE_CATALOGUE_TAG,
+	                        catalogue, (GDestroyNotify) device_catalogue_free);
+
+	g_signal_connect (client, NM_CLIENT_DEVICE_ADDED,
+	                  G_CALLBACK (device_catalogue_device_added), catalogue);
+	g_signal_connect (client, NM_CLIENT_DEVICE_REMOVED,
+	                  G_CALLBACK (device_catalogue_device_removed), catalogue);
+
+	return catalogue;
+}
+
+static const GPtrArray *
 _get_device_list (CEPage *self,
                   GType device_type,
-                  gboolean set_ifname,
                   const char *mac_property,
                   gboolean ifname_first)
 {
+	DeviceCatalogue *catalogue;
+	DeviceList *list;
 	const GPtrArray *devices;
-	GPtrArray *interfaces;
+	char *key;
 	int i;
 
 	g_return_val_if_fail (CE_IS_PAGE (self), NULL);
-	g_return_val_if_fail (set_ifname || mac_property, NULL);
 
 	if (!self->client)
 		return NULL;
 
-	interfaces = g_ptr_array_new ();
-	devices = nm_client_get_devices (self->client);
-	for (i = 0; i < devices->len; i++) {
-		NMDevice *dev = g_ptr_array_index (devices, i);
-		const char *ifname;
-		char *mac = NULL;
-		char *item;
-
-		if (!G_TYPE_CHECK_INSTANCE_TYPE (dev, device_type))
-			continue;
+	catalogue = device_catalogue_get (self->client);
+	key = g_strdup_printf ("%s/%s/%d", g_type_name (device_type),
+	                       mac_property ? mac_property : "", !!ifname_first);
+	list = g_hash_table_lookup (catalogue->lists, key);
+	if (list) {
+		g_free (key);
+		return list->entries;
+	}
 
-		if (device_type == NM_TYPE_DEVICE_BT)
-			ifname = nm_device_bt_get_name (NM_DEVICE_BT (dev));
-		else
-			ifname = nm_device_get_iface (NM_DEVICE (dev));
-		if (mac_property)
-			g_object_get (G_OBJECT (dev), mac_property, &mac, NULL);
+	list = g_slice_new0 (DeviceList);
+	list->device_type = device_type;
+	list->mac_property = g_strdup (mac_property);
+	list->ifname_first = ifname_first;
+	list->entries = g_ptr_array_new_with_free_func ((GDestroyNotify) device_entry_free);
+	g_hash_table_insert (catalogue->lists, key, list);
 
-		if (set_ifname && mac_property) {
-			if (ifname_first)
-				item = g_strdup_printf ("%s (%s)", ifname, mac);
-			else
-				item = g_strdup_printf ("%s (%s)", mac, ifname);
-		} else
-			item = g_strdup (set_ifname ? ifname : mac);
+	devices = nm_client_get_devices (self->client);
+	for (i = 0; devices && i < devices->len; i++) {
+		NMDevice *dev = g_ptr_array_index (devices, i);
 
-		g_ptr_array_add (interfaces, item);
-		if (mac_property)
-			g_free (mac);
+		if (G_TYPE_CHECK_INSTANCE_TYPE (dev, device_type))
+			g_ptr_array_add (list->entries, device_entry_new (list, dev));
 	}
-	g_ptr_array_add (interfaces, NULL);
 
-	return (char **)g_ptr_array_free (interfaces, FALSE);
+	return list->entries;
 }
 
 static gboolean
@@ -362,32 +518,17 @@ _device_entry_parse (const char *entry_text, char **first, char **second)
 }
 
 static gboolean
-_device_entries_match (const char *ifname, const char *mac, const char *entry)
+_device_entries_match (const char *ifname, const char *mac, const DeviceEntry *entry)
 {
-	char *first, *second;
-	gboolean ifname_match = FALSE, mac_match = FALSE;
-	gboolean both;
+	gboolean ifname_match, mac_match;
 
 	if (!ifname && !mac)
 		return FALSE;
 
-	_device_entry_parse (entry, &first, &second);
-	both = first && second;
+	ifname_match = ifname && !g_strcmp0 (ifname, entry->ifname);
+	mac_match = mac && entry->mac && nm_utils_hwaddr_matches (mac, -1, entry->mac, -1);
 
-	if (   ifname
-	    && (   !g_strcmp0 (ifname, first)
-	        || !g_strcmp0 (ifname, second)))
-		ifname_match = TRUE;
-
-	if (   mac
-	    && (   (first && nm_utils_hwaddr_matches (mac, -1, first, -1))
-	        || (second && nm_utils_hwaddr_matches (mac, -1, second, -1))))
-		mac_match = TRUE;
-
-	g_free (first);
-	g_free (second);
-
-	if (both)
+	if (entry->ifname && entry->mac)
 		return ifname_match && mac_match;
 	else {
 		if (ifname)
@@ -407,12 +548,12 @@ ce_page_setup_device_combo (CEPage *self,
                             const char *mac_property,
                             gboolean ifname_first)
 {
-	char **iter, *active_item = NULL;
-	int i, active_idx = -1;
-	char **device_list;
+	const char *active_item = NULL;
+	int i, n = 0, active_idx = -1;
+	const GPtrArray *device_list;
 	char *item;
 
-	device_list = _get_device_list (self, device_type, TRUE, mac_property, ifname_first);
+	device_list = _get_device_list (self, device_type, mac_property, ifname_first);
 
 	if (ifname && mac)
 		item = g_strdup_printf ("%s (%s)", ifname, mac);
@@ -421,17 +562,21 @@ ce_page_setup_device_combo (CEPage *self,
 	else
 		item = g_strdup (ifname ? ifname : mac);
 
-	for (iter = device_list, i = 0; iter && *iter; iter++, i++) {
-		gtk_combo_box_text_append_text (GTK_COMBO_BOX_TEXT (combo), *iter);
-		if (_device_entries_match (ifname, mac, *iter)) {
-			active_item = *iter;
-			active_idx = i;
+	for (i = 0; device_list && i < device_list->len; i++) {
+		const DeviceEntry *entry = g_ptr_array_index (device_list, i);
+
+		if (!entry->text)
+			continue;
+		gtk_combo_box_text_append_text (GTK_COMBO_BOX_TEXT (combo), entry->text);
+		if (_device_entries_match (ifname, mac, entry)) {
+			active_item = entry->text;
+			active_idx = n;
 		}
+		n++;
 	}
 	_set_active_combo_item (combo, item, active_item, active_idx);
 
 	g_free (item);
-	g_strfreev (device_list);
 }
 
 gboolean
@@ -491,41 +636,656 @@ ce_page_device_entry_get (GtkEntry *entry, int type, gboolean check_ifname,
 	return valid;
 }
 
-char *
-ce_page_get_next_available_name (const GPtrArray *connections, const char *format)
+/* Editor-wide index of connections by id, UUID and type, and of which
+ * devices each can be activated on.  It is shared by every page through
+ * the NMClient and kept current from its connection and device signals, so
+ * that generating a unique name or finding a connection or its devices
+ * doesn't walk and compare against everything.
+ */
+#define CONNECTION_INDEX_TAG "ce-page-connection-index"
+
+/* Largest number handed out for a generated name */
+#define MAX_NAME_NUMBER 9999
+
+typedef struct {
+	char *prefix;      /* format split around its %d */
+	char *suffix;
+	GHashTable *used;  /* number -> count of connections named with it */
+	int next;          /* no number below this one is free */
+} NameFormat;
+
+typedef struct {
+	GHashTable *ids;      /* id -> count of connections using it */
+	GHashTable *uuids;    /* uuid -> NMConnection */
+	GHashTable *indexed;  /* NMConnection -> IndexedConnection */
+	GHashTable *by_type;  /* setting GType -> GPtrArray of NMConnection */
+	GHashTable *formats;  /* format -> NameFormat */
+
+	/* Devices by interface name, canonical MAC and setting type, for
+	 * working out which devices a connection can be activated on.
+	 */
+	GHashTable *devices;           /* NMDevice -> IndexedDevice */
+	GHashTable *devices_by_name;
+	GHashTable *devices_by_perm_mac;
+	GHashTable *devices_by_mac;
+	GHashTable *devices_by_type;  /* setting GType -> GPtrArray of NMDevice */
+	GPtrArray *empty;
+} ConnectionIndex;
+
+/* The name and address a device was indexed under, so it can be taken
+ * out again after either has changed.
+ */
+typedef struct {
+	char *iface;
+	char *mac;
+} IndexedDevice;
+
+static void
+indexed_device_free (IndexedDevice *keys)
 {
-	GSList *names = NULL, *iter;
-	char *cname = NULL;
-	int i = 0;
+	g_free (keys->iface);
+	g_free (keys->mac);
+	g_slice_free (IndexedDevice, keys);
+}
 
-	for (i = 0; i < connections->len; i++) {
-		const char *id;
+static void
+name_format_free (NameFormat *fmt)
+{
+	g_free (fmt->prefix);
+	g_free (fmt->suffix);
+	g_hash_table_destroy (fmt->used);
+	g_slice_free (NameFormat, fmt);
+}
 
-		id = nm_connection_get_id (connections->pdata[i]);
-		g_assert (id);
-		names = g_slist_append (names, (gpointer) id);
+/* Split a printf format with a single %d (and possibly %%) into the
+ * literal text around the number; anything else isn't indexable.
+ */
+static NameFormat *
+name_format_parse (const char *format)
+{
+	GString *prefix, *str;
+	NameFormat *fmt;
+	const char *p;
+
+	prefix = NULL;
+	str = g_string_new (NULL);
+	for (p = format; *p; p++) {
+		if (*p != '%') {
+			g_string_append_c (str, *p);
+			continue;
+		}
+		p++;
+		if (*p == '%')
+			g_string_append_c (str, '%');
+		else if (*p == 'd' && !prefix) {
+			prefix = str;
+			str = g_string_new (NULL);
+		} else {
+			if (prefix)
+				g_string_free (prefix, TRUE);
+			g_string_free (str, TRUE);
+			return NULL;
+		}
+	}
+	if (!prefix) {
+		g_string_free (str, TRUE);
+		return NULL;
 	}
 
-	/* Find the next available unique connection name */
-	for (i = 1; !cname && i < 10000; i++) {
-		char *temp;
-		gboolean found = FALSE;
-
-		temp = g_strdup_printf (format, i);
-		for (iter = names; iter; iter = g_slist_next (iter)) {
-			if (!strcmp (iter->data, temp)) {
-				found = TRUE;
-				break;
+	fmt = g_slice_new0 (NameFormat);
+	fmt->prefix = g_string_free (prefix, FALSE);
+	fmt->suffix = g_string_free (str, FALSE);
+	fmt->used = g_hash_table_new (NULL, NULL);
+	fmt->next = 1;
+	return fmt;
+}
+
+/* Whether @id is what the format prints for some number in range */
+static int
+name_format_match (NameFormat *fmt, const char *id)
+{
+	gsize id_len, prefix_len, suffix_len;
+	const char *p, *end;
+	int num = 0;
+
+	id_len = strlen (id);
+	prefix_len = strlen (fmt->prefix);
+	suffix_len = strlen (fmt->suffix);
+	if (   id_len <= prefix_len + suffix_len
+	    || strncmp (id, fmt->prefix, prefix_len) != 0
+	    || strcmp (id + id_len - suffix_len, fmt->suffix) != 0)
+		return 0;
+
+	p = id + prefix_len;
+	end = id + id_len - suffix_len;
+	if (*p == '0' || end - p > 4)
+		return 0;
+	for (; p < end; p++) {
+		if (!g_ascii_isdigit (*p))
+			return 0;
+		num = num * 10 + (*p - '0');
+	}
+	return num;
+}
+
+static void
+name_format_use (NameFormat *fmt, const char *id, int delta)
+{
+	gpointer key;
+	guint count;
+	int num;
+
+	num = name_format_match (fmt, id);
+	if (!num)
+		return;
+
+	key = GINT_TO_POINTER (num);
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (fmt->used, key)) + delta;
+	if (count)
+		g_hash_table_insert (fmt->used, key, GUINT_TO_POINTER (count));
+	else {
+		g_hash_table_remove (fmt->used, key);
+		if (num < fmt->next)
+			fmt->next = num;
+	}
+}
+
+typedef struct {
+	char *id;               /* what the connection is indexed under */
+	GType type;
+	GPtrArray *compatible;  /* NMDevice, or NULL until asked for */
+} IndexedConnection;
+
+static void
+indexed_connection_free (IndexedConnection *entry)
+{
+	g_free (entry->id);
+	if (entry->compatible)
+		g_ptr_array_unref (entry->compatible);
+	g_slice_free (IndexedConnection, entry);
+}
+
+static GType
+connection_setting_type (NMConnection *connection)
+{
+	const char *type = nm_connection_get_connection_type (connection);
+
+	return type ? nm_setting_lookup_type (type) : G_TYPE_INVALID;
+}
+
+static void
+type_list_add (GHashTable *table, GType type, gpointer item)
+{
+	GPtrArray *list;
+
+	list = g_hash_table_lookup (table, GSIZE_TO_POINTER (type));
+	if (!list) {
+		list = g_ptr_array_new ();
+		g_hash_table_insert (table, GSIZE_TO_POINTER (type), list);
+	}
+	g_ptr_array_add (list, item);
+}
+
+static void
+type_list_remove (GHashTable *table, GType type, gpointer item)
+{
+	GPtrArray *list;
+
+	list = g_hash_table_lookup (table, GSIZE_TO_POINTER (type));
+	if (list)
+		g_ptr_array_remove (list, item);
+}
+
+static void
+connection_index_use_id (ConnectionIndex *index, const char *id, int delta)
+{
+	GHashTableIter iter;
+	NameFormat *fmt;
+	guint count;
+
+	if (!id)
+		return;
+
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (index->ids, id)) + delta;
+	if (count)
+		g_hash_table_insert (index->ids, g_strdup (id), GUINT_TO_POINTER (count));
+	else
+		g_hash_table_remove (index->ids, id);
+
+	g_hash_table_iter_init (&iter, index->formats);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &fmt))
+		name_format_use (fmt, id, delta);
+}
+
+static void
+connection_index_connection_changed (NMConnection *connection, gpointer user_data)
+{
+	ConnectionIndex *index = user_data;
+	IndexedConnection *entry;
+	const char *id;
+	GType type;
+
+	entry = g_hash_table_lookup (index->indexed, connection);
+	g_return_if_fail (entry != NULL);
+
+	/* Interface name or MAC may have changed */
+	g_clear_pointer (&entry->compatible, g_ptr_array_unref);
+
+	id = nm_connection_get_id (connection);
+	if (g_strcmp0 (entry->id, id)) {
+		connection_index_use_id (index, entry->id, -1);
+		connection_index_use_id (index, id, 1);
+		g_free (entry->id);
+		entry->id = g_strdup (id);
+	}
+
+	type = connection_setting_type (connection);
+	if (entry->type != type) {
+		type_list_remove (index->by_type, entry->type, connection);
+		type_list_add (index->by_type, type, connection);
+		entry->type = type;
+	}
+}
+
+static void
+connection_index_connection_added (NMClient *client, NMConnection *connection, gpointer user_data)
+{
+	ConnectionIndex *index = user_data;
+	IndexedConnection *entry;
+	const char *uuid;
+
+	if (g_hash_table_contains (index->indexed, connection))
+		return;
+
+	entry = g_slice_new0 (IndexedConnection);
+	entry->id = g_strdup (nm_connection_get_id (connection));
+	entry->type = connection_setting_type (connection);
+	g_hash_table_insert (index->indexed, connection, entry);
+
+	connection_index_use_id (index, entry->id, 1);
+	type_list_add (index->by_type, entry->type, connection);
+	uuid = nm_connection_get_uuid (connection);
+	if (uuid)
+		g_hash_table_insert (index->uuids, g_strdup (uuid), connection);
+
+	g_signal_connect (connection, NM_CONNECTION_CHANGED,
+	                  G_CALLBACK (connection_index_connection_changed), index);
+}
+
+static void
+connection_index_connection_removed (NMClient *client, NMConnection *connection, gpointer user_data)
+{
+	ConnectionIndex *index = user_data;
+	IndexedConnection *entry;
+	GHashTableIter iter;
+	gpointer uuid_conn;
+	const char *uuid;
+
+	entry = g_hash_table_lookup (index->indexed, connection);
+	if (!entry)
+		return;
+
+	g_signal_handlers_disconnect_by_func (connection, connection_index_connection_changed, index);
+
+	connection_index_use_id (index, entry->id, -1);
+	type_list_remove (index->by_type, entry->type, connection);
+	g_hash_table_remove (index->indexed, connection);
+
+	uuid = nm_connection_get_uuid (connection);
+	if (uuid && g_hash_table_lookup (index->uuids, uuid) == connection) {
+		g_hash_table_remove (index->uuids, uuid);
+		return;
+	}
+
+	/* The removed connection may have lost its settings already */
+	g_hash_table_iter_init (&iter, index->uuids);
+	while (g_hash_table_iter_next (&iter, NULL, &uuid_conn)) {
+		if (uuid_conn == connection) {
+			g_hash_table_iter_remove (&iter);
+			break;
+		}
+	}
+}
+
+static void
+index_device_address (GHashTable *table, const char *address, NMDevice *device, gboolean add)
+{
+	char *canonical;
+
+	if (!address)
+		return;
+
+	canonical = nm_utils_hwaddr_canonical (address, -1);
+	if (!canonical)
+		return;
+	if (add && !g_hash_table_contains (table, canonical))
+		g_hash_table_insert (table, canonical, device);
+	else {
+		if (!add && g_hash_table_lookup (table, canonical) == device)
+			g_hash_table_remove (table, canonical);
+		g_free (canonical);
+	}
+}
+
+static void
+connection_index_update_device (ConnectionIndex *index, NMDevice *device, gboolean add)
+{
+	GHashTableIter iter;
+	IndexedConnection *entry;
+	IndexedDevice *keys;
+
+	if (add) {
+		keys = g_slice_new0 (IndexedDevice);
+		keys->iface = g_strdup (nm_device_get_iface (device));
+		keys->mac = g_strdup (nm_device_get_hw_address (device));
+		g_hash_table_insert (index->devices, device, keys);
+	} else {
+		keys = g_hash_table_lookup (index->devices, device);
+		if (!keys)
+			return;
+	}
+
+	if (keys->iface) {
+		if (add && !g_hash_table_contains (index->devices_by_name, keys->iface))
+			g_hash_table_insert (index->devices_by_name, g_strdup (keys->iface), device);
+		else if (!add && g_hash_table_lookup (index->devices_by_name, keys->iface) == device)
+			g_hash_table_remove (index->devices_by_name, keys->iface);
+	}
+
+	index_device_address (index->devices_by_mac, keys->mac, device, add);
+	if (NM_IS_DEVICE_ETHERNET (device)) {
+		index_device_address (index->devices_by_perm_mac,
+		                      nm_device_ethernet_get_permanent_hw_address (NM_DEVICE_ETHERNET (device)),
+		                      device, add);
+	}
+
+	if (add)
+		type_list_add (index->devices_by_type, nm_device_get_setting_type (device), device);
+	else {
+		type_list_remove (index->devices_by_type, nm_device_get_setting_type (device), device);
+		g_hash_table_remove (index->devices, device);
+	}
+
+	/* Device changes are rare; just forget what was worked out */
+	g_hash_table_iter_init (&iter, index->indexed);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer) &entry))
+		g_clear_pointer (&entry->compatible, g_ptr_array_unref);
+}
+
+/* A renamed interface or a changed (e.g. randomized) MAC must not leave
+ * the device filed under its old keys.
+ */
+static void
+connection_index_device_changed (GObject *object, GParamSpec *pspec, gpointer user_data)
+{
+	connection_index_update_device (user_data, NM_DEVICE (object), FALSE);
+	connection_index_update_device (user_data, NM_DEVICE (object), TRUE);
+}
+
+static void
+connection_index_device_added (NMClient *client, NMDevice *device, gpointer user_data)
+{
+	connection_index_update_device (user_data, device, TRUE);
+	g_signal_connect (device, "notify::" NM_DEVICE_INTERFACE,
+	                  G_CALLBACK (connection_index_device_changed), user_data);
+	g_signal_connect (device, "notify::" NM_DEVICE_HW_ADDRESS,
+	                  G_CALLBACK (connection_index_device_changed), user_data);
+}
+
+static void
+connection_index_device_removed (NMClient *client, NMDevice *device, gpointer user_data)
+{
+	g_signal_handlers_disconnect_by_func (device, connection_index_device_changed, user_data);
+	connection_index_update_device (user_data, device, FALSE);
+}
+
+static void
+connection_index_free (ConnectionIndex *index)
+{
+	GHashTableIter iter;
+	gpointer connection, device;
+
+	g_hash_table_iter_init (&iter, index->indexed);
+	while (g_hash_table_iter_next (&iter, &connection, NULL))
+		g_signal_handlers_disconnect_by_func (connection, connection_index_connection_changed, index);
+
+	g_hash_table_iter_init (&iter, index->devices);
+	while (g_hash_table_iter_next (&iter, &device, NULL))
+		g_signal_handlers_disconnect_by_func (device, connection_index_device_changed, index);
+
+	g_hash_table_destroy (index->ids);
+	g_hash_table_destroy (index->uuids);
+	g_hash_table_destroy (index->indexed);
+	g_hash_table_destroy (index->by_type);
+	g_hash_table_destroy (index->formats);
+	g_hash_table_destroy (index->devices);
+	g_hash_table_destroy (index->devices_by_name);
+	g_hash_table_destroy (index->devices_by_perm_mac);
+	g_hash_table_destroy (index->devices_by_mac);
+	g_hash_table_destroy (index->devices_by_type);
+	g_ptr_array_unref (index->empty);
+	g_slice_free (ConnectionIndex, index);
+}
+
+static ConnectionIndex *
+connection_index_get (NMClient *client)
+{
+	ConnectionIndex *index;
+	const GPtrArray *connections, *devices;
+	int i;
+
+	index = g_object_get_data (G_OBJECT (client), CONNECTION_INDEX_TAG);
+	if (index)
+		return index;
+
+	index = g_slice_new0 (ConnectionIndex);
+	index->ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	index->uuids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	index->indexed = g_hash_table_new_full (NULL, NULL, NULL,
+	                                        (GDestroyNotify) indexed_connection_free);
+	index->by_type = g_hash_table_new_full (NULL, NULL, NULL,
+	                                        (GDestroyNotify) g_ptr_array_unref);
+	index->formats = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                        g_free, (GDestroyNotify) name_format_free);
+	index->devices = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify) indexed_device_free);
+	index->devices_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	index->devices_by_perm_mac = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	index->devices_by_mac = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	index->devices_by_type = g_hash_table_new_full (NULL, NULL, NULL,
+	                                                (GDestroyNotify) g_ptr_array_unref);
+	index->empty = g_ptr_array_new ();
+	g_object_set_data_full (G_OBJECT (client), CONNECTION_INDEX_TAG,
+	                        index, (GDestroyNotify) connection_index_free);
+
+	connections = nm_client_get_connections (client);
+	for (i = 0; connections && i < connections->len; i++)
+		connection_index_connection_added (client, connections->pdata[i], index);
+
+	devices = nm_client_get_devices (client);
+	for (i = 0; devices && i < devices->len; i++)
+		connection_index_device_added (client, devices->pdata[i], index);
+
+	g_signal_connect (client, NM_CLIENT_CONNECTION_ADDED,
+	                  G_CALLBACK (connection_index_connection_added), index);
+	g_signal_connect (client, NM_CLIENT_CONNECTION_REMOVED,
+	                  G_CALLBACK (connection_index_connection_removed), index);
+	g_signal_connect (client, NM_CLIENT_DEVICE_ADDED,
+	                  G_CALLBACK (connection_index_device_added), index);
+	g_signal_connect (client, NM_CLIENT_DEVICE_REMOVED,
+	                  G_CALLBACK (connection_index_device_removed), index);
+
+	return index;
+}
+
+gboolean
+ce_page_connection_id_in_use (NMClient *client, const char *id)
+{
+	g_return_val_if_fail (NM_IS_CLIENT (client), FALSE);
+	g_return_val_if_fail (id != NULL, FALSE);
+
+	return g_hash_table_contains (connection_index_get (client)->ids, id);
+}
+
+NMConnection *
+ce_page_get_connection_by_uuid (NMClient *client, const char *uuid)
+{
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+
+	if (!uuid)
+		return NULL;
+	return g_hash_table_lookup (connection_index_get (client)->uuids, uuid);
+}
+
+const GPtrArray *
+ce_page_get_connections_by_type (NMClient *client, GType setting_type)
+{
+	ConnectionIndex *index;
+	GPtrArray *list;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+
+	index = connection_index_get (client);
+	list = g_hash_table_lookup (index->by_type, GSIZE_TO_POINTER (setting_type));
+	return list ? list : index->empty;
+}
+
+const GPtrArray *
+ce_page_get_vpn_connections (NMClient *client)
+{
+	return ce_page_get_connections_by_type (client, NM_TYPE_SETTING_VPN);
+}
+
+NMDevice *
+ce_page_get_device_by_iface_or_mac (NMClient *client, const char *iface, const char *mac)
+{
+	ConnectionIndex *index;
+	NMDevice *device = NULL;
+	char *canonical;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+
+	index = connection_index_get (client);
+	if (iface)
+		device = g_hash_table_lookup (index->devices_by_name, iface);
+	if (!device && mac) {
+		/* A permanent address wins over another device's current one */
+		canonical = nm_utils_hwaddr_canonical (mac, -1);
+		if (canonical) {
+			device = g_hash_table_lookup (index->devices_by_perm_mac, canonical);
+			if (!device)
+				device = g_hash_table_lookup (index->devices_by_mac, canonical);
+		}
+		g_free (canonical);
+	}
+	return device;
+}
+
+/* Devices @connection could be activated on.  Only the device its
+ * interface name or MAC address points at, or failing those the devices
+ * of its type, are asked; the answer is kept until the connection or the
+ * device list changes.
+ */
+const GPtrArray *
+ce_page_get_compatible_devices (NMClient *client, NMConnection *connection)
+{
+	ConnectionIndex *index;
+	IndexedConnection *entry;
+	const GPtrArray *candidates = NULL;
+	GPtrArray *single = NULL, *result;
+	NMSetting *s_hw;
+	NMDevice *device;
+	char *mac = NULL;
+	const char *iface;
+	int i;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
+
+	index = connection_index_get (client);
+	entry = g_hash_table_lookup (index->indexed, connection);
+	if (entry && entry->compatible)
+		return entry->compatible;
+
+	iface = nm_connection_get_interface_name (connection);
+	s_hw = nm_connection_get_setting_by_name (connection, nm_connection_get_connection_type (connection));
+	if (   s_hw
+	    && g_object_class_find_property (G_OBJECT_GET_CLASS (s_hw), "mac-address"))
+		g_object_get (G_OBJECT (s_hw), "mac-address", &mac, NULL);
+
+	if (iface || mac) {
+		device = ce_page_get_device_by_iface_or_mac (client, iface, iface ? NULL : mac);
+		single = g_ptr_array_new ();
+		if (device)
+			g_ptr_array_add (single, device);
+		candidates = single;
+	} else {
+		candidates = g_hash_table_lookup (index->devices_by_type,
+		                                  GSIZE_TO_POINTER (connection_setting_type (connection)));
+	}
+	g_free (mac);
+
+	result = g_ptr_array_new ();
+	for (i = 0; candidates && i < candidates->len; i++) {
+		device = candidates->pdata[i];
+		if (nm_device_connection_valid (device, connection))
+			g_ptr_array_add (result, device);
+	}
+	if (single)
+		g_ptr_array_unref (single);
+
+	if (!entry) {
+		/* Not a known connection, so nothing would keep the answer current */
+		g_object_set_data_full (G_OBJECT (connection), CONNECTION_INDEX_TAG "-devices",
+		                        result, (GDestroyNotify) g_ptr_array_unref);
+		return result;
+	}
+
+	entry->compatible = result;
+	return result;
+}
+
+char *
+ce_page_get_next_available_name (NMClient *client, const char *format)
+{
+	ConnectionIndex *index;
+	NameFormat *fmt;
+	GHashTableIter iter;
+	const char *id;
+	int i;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (format != NULL, NULL);
+
+	index = connection_index_get (client);
+	fmt = g_hash_table_lookup (index->formats, format);
+	if (!fmt) {
+		fmt = name_format_parse (format);
+		if (!fmt) {
+			/* Not a plain "%d" format; try each number in turn */
+			for (i = 1; i <= MAX_NAME_NUMBER; i++) {
+				char *temp = g_strdup_printf (format, i);
+
+				if (!g_hash_table_contains (index->ids, temp))
+					return temp;
+				g_free (temp);
 			}
+			return NULL;
 		}
-		if (!found)
-			cname = temp;
-		else
-			g_free (temp);
+
+		g_hash_table_iter_init (&iter, index->ids);
+		while (g_hash_table_iter_next (&iter, (gpointer) &id, NULL))
+			name_format_use (fmt, id, 1);
+		g_hash_table_insert (index->formats, g_strdup (format), fmt);
 	}
 
-	g_slist_free (names);
-	return cname;
+	/* Find the next available unique connection name */
+	while (   fmt->next <= MAX_NAME_NUMBER
+	       && g_hash_table_contains (fmt->used, GINT_TO_POINTER (fmt->next)))
+		fmt->next++;
+	if (fmt->next > MAX_NAME_NUMBER)
+		return NULL;
+
+	return g_strdup_printf (format, fmt->next);
 }
 
 static void
@@ -761,7 +1521,6 @@ ce_page_new_connection (const char *format,
 	NMConnection *connection;
 	NMSettingConnection *s_con;
 	char *uuid, *id;
-	const GPtrArray *connections;
 
 	connection = nm_simple_connection_new ();
 
@@ -769,9 +1528,7 @@ ce_page_new_connection (const char *format,
 	nm_connection_add_setting (connection, NM_SETTING (s_con));
 
 	uuid = nm_utils_uuid_generate ();
-
-	connections = nm_client_get_connections (client);
-	id = ce_page_get_next_available_name (connections, format);
+	id = ce_page_get_next_available_name (client, format);
 
 	g_object_set (s_con,
 	              NM_SETTING_CONNECTION_UUID, uuid,
@@ -812,7 +1569,12 @@ ce_page_new (GType page_type,
 	self->editor = editor;
 
 	if (ui_file) {
-		if (!gtk_builder_add_from_file (self->builder, ui_file, &error)) {
+		gboolean success;
+
+		stall_trace_begin ("gtk_builder_add_from_file");
+		success = gtk_builder_add_from_file (self->builder, ui_file, &error);
+		stall_trace_end ();
+		if (!success) {
 			g_warning ("Couldn't load builder file: %s", error->message);
 			g_error_free (error);
 			g_object_unref (self);
@@ -143,7 +143,13 @@ void ce_page_complete_init (CEPage *self,
 
 gboolean ce_page_get_initialized (CEPage *self);
 
-char *ce_page_get_next_available_name (const GPtrArray *connections, const char *format);
+char *ce_page_get_next_available_name (NMClient *client, const char *format);
+gboolean ce_page_connection_id_in_use (NMClient *client, const char *id);
+NMConnection *ce_page_get_connection_by_uuid (NMClient *client, const char *uuid);
+const GPtrArray *ce_page_get_connections_by_type (NMClient *client, GType setting_type);
+const GPtrArray *ce_page_get_vpn_connections (NMClient *client);
+NMDevice *ce_page_get_device_by_iface_or_mac (NMClient *client, const char *iface, const char *mac);
+const GPtrArray *ce_page_get_compatible_devices (NMClient *client, NMConnection *connection);
 
 /* Only for subclasses */
 NMConnection *ce_page_new_connection (const char *format,
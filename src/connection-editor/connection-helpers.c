@@ -19,6 +19,7 @@
  */
 
 #include <config.h>
+#include <string.h>
 
 #include <glib/gi18n.h>
 
@@ -541,6 +542,601 @@ delete_connection (GtkWindow *parent_window,
 	nm_remote_connection_delete_async (connection, NULL, delete_cb, info);
 }
 
+/* Bulk operations keep at most this many D-Bus calls in flight */
+#define BULK_MAX_PENDING 8
+
+typedef struct _BulkOp BulkOp;
+
+/* Starts the operation on one item; must complete asynchronously
+ * through bulk_op_complete().
+ */
+typedef void (*BulkStartFunc) (BulkOp *op, gpointer item);
+typedef void (*BulkFinishFunc) (BulkOp *op);
+
+struct _BulkOp {
+	GtkWindow *parent_window;
+	GtkWidget *progress_dialog;
+	GtkWidget *progress_bar;
+
+	GPtrArray *items;  /* connections or filenames, owned */
+	guint next;
+	guint pending;
+	guint done;
+	gboolean cancelled;
+	GString *errors;
+
+	BulkStartFunc start_func;
+	BulkFinishFunc finish_func;
+	gpointer data;
+};
+
+/* Cancelling stops starting new items; those in flight still finish */
+static void
+bulk_op_response_cb (GtkDialog *dialog, gint response, gpointer user_data)
+{
+	BulkOp *op = user_data;
+
+	op->cancelled = TRUE;
+	gtk_dialog_set_response_sensitive (dialog, GTK_RESPONSE_CANCEL, FALSE);
+	gtk_progress_bar_set_text (GTK_PROGRESS_BAR (op->progress_bar), _("Cancelling..."));
+}
+
+/* Escape cancels too, but the dialog must stay until bulk_op_free() */
+static gboolean
+bulk_op_delete_event_cb (GtkWidget *dialog, GdkEvent *event, gpointer user_data)
+{
+	bulk_op_response_cb (GTK_DIALOG (dialog), GTK_RESPONSE_CANCEL, user_data);
+	return TRUE;
+}
+
+static BulkOp *
+bulk_op_new (GtkWindow *parent_window,
+             const char *title,
+             GPtrArray *items,
+             BulkStartFunc start_func,
+             BulkFinishFunc finish_func,
+             gpointer data)
+{
+	BulkOp *op;
+	GtkWidget *content;
+
+	op = g_slice_new0 (BulkOp);
+	op->parent_window = parent_window ? g_object_ref (parent_window) : NULL;
+	op->items = g_ptr_array_ref (items);
+	op->errors = g_string_new (NULL);
+	op->start_func = start_func;
+	op->finish_func = finish_func;
+	op->data = data;
+
+	op->progress_dialog = gtk_dialog_new ();
+	gtk_window_set_title (GTK_WINDOW (op->progress_dialog), title);
+	gtk_window_set_transient_for (GTK_WINDOW (op->progress_dialog), parent_window);
+	gtk_window_set_modal (GTK_WINDOW (op->progress_dialog), TRUE);
+	gtk_window_set_deletable (GTK_WINDOW (op->progress_dialog), FALSE);
+	gtk_window_set_default_size (GTK_WINDOW (op->progress_dialog), 350, -1);
+
+	op->progress_bar = gtk_progress_bar_new ();
+	gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (op->progress_bar), TRUE);
+	content = gtk_dialog_get_content_area (GTK_DIALOG (op->progress_dialog));
+	gtk_container_set_border_width (GTK_CONTAINER (content), 12);
+	gtk_box_pack_start (GTK_BOX (content), op->progress_bar, FALSE, FALSE, 0);
+
+	gtk_dialog_add_button (GTK_DIALOG (op->progress_dialog), GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL);
+	g_signal_connect (op->progress_dialog, "response", G_CALLBACK (bulk_op_response_cb), op);
+	g_signal_connect (op->progress_dialog, "delete-event", G_CALLBACK (bulk_op_delete_event_cb), op);
+
+	return op;
+}
+
+static void
+bulk_op_free (BulkOp *op)
+{
+	gtk_widget_destroy (op->progress_dialog);
+	if (op->parent_window)
+		g_object_unref (op->parent_window);
+	g_ptr_array_unref (op->items);
+	g_string_free (op->errors, TRUE);
+	g_slice_free (BulkOp, op);
+}
+
+static void
+bulk_op_update_progress (BulkOp *op)
+{
+	char *text;
+
+	if (!op->cancelled) {
+		text = g_strdup_printf (_("%u of %u"), op->done, op->items->len);
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (op->progress_bar), text);
+		g_free (text);
+	}
+	gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (op->progress_bar),
+	                               (double) op->done / op->items->len);
+}
+
+static void
+bulk_op_pump (BulkOp *op)
+{
+	while (   !op->cancelled
+	       && op->pending < BULK_MAX_PENDING
+	       && op->next < op->items->len) {
+		op->pending++;
+		op->start_func (op, op->items->pdata[op->next++]);
+	}
+
+	if (!op->pending) {
+		op->finish_func (op);
+		bulk_op_free (op);
+	}
+}
+
+static void
+bulk_op_run (BulkOp *op)
+{
+	bulk_op_update_progress (op);
+	gtk_widget_show_all (op->progress_dialog);
+	bulk_op_pump (op);
+}
+
+static void
+bulk_op_complete (BulkOp *op, const char *name, GError *error)
+{
+	if (error)
+		g_string_append_printf (op->errors, "%s: %s\n", name, error->message);
+
+	op->pending--;
+	op->done++;
+	bulk_op_update_progress (op);
+	bulk_op_pump (op);
+}
+
+typedef struct {
+	GPtrArray *deleted;
+	DeleteConnectionsResultFunc result_func;
+	gpointer user_data;
+} BulkDeleteInfo;
+
+static void
+bulk_delete_cb (GObject *connection,
+                GAsyncResult *result,
+                gpointer user_data)
+{
+	BulkOp *op = user_data;
+	BulkDeleteInfo *info = op->data;
+	NMConnectionEditor *editor;
+	GError *error = NULL;
+
+	if (nm_remote_connection_delete_finish (NM_REMOTE_CONNECTION (connection), result, &error))
+		g_ptr_array_add (info->deleted, g_object_ref (connection));
+
+	editor = nm_connection_editor_get (NM_CONNECTION (connection));
+	if (editor)
+		nm_connection_editor_set_busy (editor, FALSE);
+
+	bulk_op_complete (op, nm_connection_get_id (NM_CONNECTION (connection)), error);
+	g_clear_error (&error);
+}
+
+static void
+bulk_delete_start (BulkOp *op, gpointer connection)
+{
+	NMConnectionEditor *editor;
+
+	editor = nm_connection_editor_get (NM_CONNECTION (connection));
+	if (editor)
+		nm_connection_editor_set_busy (editor, TRUE);
+
+	nm_remote_connection_delete_async (connection, NULL, bulk_delete_cb, op);
+}
+
+static void
+bulk_delete_finish (BulkOp *op)
+{
+	BulkDeleteInfo *info = op->data;
+
+	if (op->errors->len) {
+		nm_connection_editor_error (op->parent_window,
+		                            _("Some connections could not be deleted"),
+		                            "%s", op->errors->str);
+	}
+
+	if (info->result_func)
+		(*info->result_func) (info->deleted, info->user_data);
+
+	g_ptr_array_unref (info->deleted);
+	g_slice_free (BulkDeleteInfo, info);
+}
+
+/* Deletes several connections after a single confirmation, pipelining the
+ * D-Bus calls.  @result_func always runs once, with the connections actually
+ * deleted; cancelling the confirmation or the progress dialog leaves the
+ * rest alone.
+ */
+void
+delete_connections (GtkWindow *parent_window,
+                    GPtrArray *connections,
+                    DeleteConnectionsResultFunc result_func,
+                    gpointer user_data)
+{
+	GPtrArray *to_delete;
+	BulkDeleteInfo *info;
+	GtkWidget *dialog;
+	guint result = GTK_RESPONSE_CANCEL;
+	guint i;
+
+	g_return_if_fail (connections != NULL);
+
+	info = g_slice_new0 (BulkDeleteInfo);
+	info->deleted = g_ptr_array_new_with_free_func (g_object_unref);
+	info->result_func = result_func;
+	info->user_data = user_data;
+
+	/* Leave alone connections whose editor is in the middle of something */
+	to_delete = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < connections->len; i++) {
+		NMConnectionEditor *editor;
+
+		editor = nm_connection_editor_get (connections->pdata[i]);
+		if (editor && nm_connection_editor_get_busy (editor))
+			continue;
+		g_ptr_array_add (to_delete, g_object_ref (connections->pdata[i]));
+	}
+	if (!to_delete->len)
+		goto out;
+
+	dialog = gtk_message_dialog_new (parent_window,
+	                                 GTK_DIALOG_DESTROY_WITH_PARENT,
+	                                 GTK_MESSAGE_QUESTION,
+	                                 GTK_BUTTONS_NONE,
+	                                 ngettext ("Are you sure you wish to delete %u connection?",
+	                                           "Are you sure you wish to delete %u connections?",
+	                                           to_delete->len),
+	                                 to_delete->len);
+	gtk_dialog_add_buttons (GTK_DIALOG (dialog),
+	                        GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+	                        GTK_STOCK_DELETE, GTK_RESPONSE_YES,
+	                        NULL);
+
+	result = gtk_dialog_run (GTK_DIALOG (dialog));
+	gtk_widget_destroy (dialog);
+
+out:
+	if (result == GTK_RESPONSE_YES) {
+		bulk_op_run (bulk_op_new (parent_window, _("Deleting connections"), to_delete,
+		                          bulk_delete_start, bulk_delete_finish, info));
+	} else {
+		if (result_func)
+			(*result_func) (info->deleted, user_data);
+		g_ptr_array_unref (info->deleted);
+		g_slice_free (BulkDeleteInfo, info);
+	}
+	g_ptr_array_unref (to_delete);
+}
+
+static void
+bulk_export_secrets_cb (GObject *connection,
+                        GAsyncResult *result,
+                        gpointer user_data)
+{
+	BulkOp *op = user_data;
+	const char *folder = op->data;
+	NMConnection *tmp;
+	GVariant *secrets;
+	GError *error = NULL;
+
+	/* As with a single export, export without secrets if they can't be had.
+	 * Work on a copy so the secrets don't stay around in the original.
+	 */
+	secrets = nm_remote_connection_get_secrets_finish (NM_REMOTE_CONNECTION (connection),
+	                                                   result, NULL);
+	tmp = nm_simple_connection_new_clone (NM_CONNECTION (connection));
+	if (secrets) {
+		nm_connection_update_secrets (tmp, NM_SETTING_VPN_SETTING_NAME, secrets, NULL);
+		g_variant_unref (secrets);
+	}
+
+	vpn_export_to_folder (tmp, folder, &error);
+	g_object_unref (tmp);
+
+	bulk_op_complete (op, nm_connection_get_id (NM_CONNECTION (connection)), error);
+	g_clear_error (&error);
+}
+
+static void
+bulk_export_start (BulkOp *op, gpointer connection)
+{
+	nm_remote_connection_get_secrets_async (connection,
+	                                        NM_SETTING_VPN_SETTING_NAME,
+	                                        NULL,
+	                                        bulk_export_secrets_cb,
+	                                        op);
+}
+
+static void
+bulk_export_finish (BulkOp *op)
+{
+	if (op->errors->len) {
+		nm_connection_editor_error (op->parent_window,
+		                            _("Some connections could not be exported"),
+		                            "%s", op->errors->str);
+	}
+	g_free (op->data);
+}
+
+/* Exports those of @connections that can be exported (VPNs whose plugin
+ * supports it) into a folder the user picks, one file each.
+ */
+void
+export_connections (GtkWindow *parent_window, GPtrArray *connections)
+{
+	GPtrArray *to_export;
+	GtkWidget *dialog;
+	char *folder = NULL;
+	guint i;
+
+	g_return_if_fail (connections != NULL);
+
+	to_export = g_ptr_array_new_with_free_func (g_object_unref);
+	for (i = 0; i < connections->len; i++) {
+		if (vpn_can_export (connections->pdata[i]))
+			g_ptr_array_add (to_export, g_object_ref (connections->pdata[i]));
+	}
+	if (!to_export->len) {
+		g_ptr_array_unref (to_export);
+		return;
+	}
+
+	dialog = gtk_file_chooser_dialog_new (_("Export connections to folder..."),
+	                                      parent_window,
+	                                      GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER,
+	                                      GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+	                                      GTK_STOCK_SAVE, GTK_RESPONSE_ACCEPT,
+	                                      NULL);
+	gtk_file_chooser_set_current_folder (GTK_FILE_CHOOSER (dialog), g_get_home_dir ());
+	if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT)
+		folder = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+	gtk_widget_destroy (dialog);
+
+	if (folder) {
+		bulk_op_run (bulk_op_new (parent_window, _("Exporting connections"), to_export,
+		                          bulk_export_start, bulk_export_finish, folder));
+	}
+	g_ptr_array_unref (to_export);
+}
+
+typedef struct {
+	NMClient *client;
+	GHashTable *ids;  /* ids handed out in this batch */
+	guint added;
+	ImportVpnFilesResultFunc result_func;
+	gpointer user_data;
+} BulkImportInfo;
+
+typedef struct {
+	BulkOp *op;
+	char *name;
+} BulkImportItem;
+
+static BulkImportItem *
+bulk_import_item_new (BulkOp *op, const char *filename)
+{
+	BulkImportItem *item;
+
+	item = g_slice_new (BulkImportItem);
+	item->op = op;
+	item->name = g_path_get_basename (filename);
+	return item;
+}
+
+static void
+bulk_import_item_complete (BulkImportItem *item, GError *error)
+{
+	bulk_op_complete (item->op, item->name, error);
+	g_free (item->name);
+	g_slice_free (BulkImportItem, item);
+}
+
+static gboolean
+bulk_import_id_taken (BulkImportInfo *info, const char *id)
+{
+	return    ce_page_connection_id_in_use (info->client, id)
+	       || g_hash_table_contains (info->ids, id);
+}
+
+/* Names a connection imported without an id, as a single import does.  The
+ * adds are in flight concurrently, so the client doesn't know the names
+ * taken earlier in the batch yet.
+ */
+static char *
+bulk_import_new_id (BulkImportInfo *info)
+{
+	char *id;
+	int i;
+
+	id = ce_page_get_next_available_name (info->client, _("VPN connection %d"));
+	for (i = 1; !id || bulk_import_id_taken (info, id); i++) {
+		g_free (id);
+		id = g_strdup_printf (_("VPN connection %d"), i);
+	}
+	return id;
+}
+
+static gboolean
+bulk_import_fixup (BulkImportInfo *info, NMConnection *connection, GError **error)
+{
+	NMSettingConnection *s_con;
+	NMSettingVpn *s_vpn;
+	const char *service_type;
+	char *s;
+
+	s_vpn = nm_connection_get_setting_vpn (connection);
+	service_type = s_vpn ? nm_setting_vpn_get_service_type (s_vpn) : NULL;
+	if (!service_type || !strlen (service_type)) {
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC,
+		                     _("no VPN service type"));
+		return FALSE;
+	}
+
+	s_con = nm_connection_get_setting_connection (connection);
+	if (!s_con) {
+		s_con = NM_SETTING_CONNECTION (nm_setting_connection_new ());
+		nm_connection_add_setting (connection, NM_SETTING (s_con));
+	}
+
+	if (nm_setting_connection_get_id (s_con))
+		s = g_strdup (nm_setting_connection_get_id (s_con));
+	else
+		s = bulk_import_new_id (info);
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_ID, s,
+	              NM_SETTING_CONNECTION_TYPE, NM_SETTING_VPN_SETTING_NAME,
+	              NULL);
+	g_hash_table_add (info->ids, s);
+
+	if (!nm_setting_connection_get_uuid (s_con)) {
+		s = nm_utils_uuid_generate ();
+		g_object_set (s_con, NM_SETTING_CONNECTION_UUID, s, NULL);
+		g_free (s);
+	}
+
+	if (!nm_connection_get_setting_ip4_config (connection))
+		nm_connection_add_setting (connection, nm_setting_ip4_config_new ());
+	if (!nm_connection_get_setting_ip6_config (connection))
+		nm_connection_add_setting (connection, nm_setting_ip6_config_new ());
+
+	return TRUE;
+}
+
+static void
+bulk_import_added_cb (GObject *client,
+                      GAsyncResult *result,
+                      gpointer user_data)
+{
+	BulkImportItem *item = user_data;
+	BulkImportInfo *info = item->op->data;
+	NMRemoteConnection *connection;
+	GError *error = NULL;
+
+	connection = nm_client_add_connection_finish (NM_CLIENT (client), result, &error);
+	if (connection) {
+		info->added++;
+		g_object_unref (connection);
+	}
+
+	bulk_import_item_complete (item, error);
+	g_clear_error (&error);
+}
+
+static void
+bulk_import_thread (GTask *task,
+                    gpointer source_object,
+                    gpointer task_data,
+                    GCancellable *cancellable)
+{
+	NMConnection *connection;
+	GError *error = NULL;
+
+	connection = vpn_import_file (task_data, &error);
+	if (connection)
+		g_task_return_pointer (task, connection, g_object_unref);
+	else
+		g_task_return_error (task, error);
+}
+
+static void
+bulk_import_parsed_cb (GObject *source_object,
+                       GAsyncResult *result,
+                       gpointer user_data)
+{
+	BulkImportItem *item = user_data;
+	BulkImportInfo *info = item->op->data;
+	NMConnection *connection;
+	GError *error = NULL;
+
+	connection = g_task_propagate_pointer (G_TASK (result), &error);
+	if (connection && bulk_import_fixup (info, connection, &error)) {
+		nm_client_add_connection_async (info->client, connection, TRUE, NULL,
+		                                bulk_import_added_cb, item);
+	} else
+		bulk_import_item_complete (item, error);
+
+	g_clear_error (&error);
+	g_clear_object (&connection);
+}
+
+static void
+bulk_import_start (BulkOp *op, gpointer filename)
+{
+	GTask *task;
+
+	/* Plugins parse in the thread pool; adding goes back to the main loop */
+	task = g_task_new (NULL, NULL, bulk_import_parsed_cb,
+	                   bulk_import_item_new (op, filename));
+	g_task_set_task_data (task, g_strdup (filename), g_free);
+	g_task_run_in_thread (task, bulk_import_thread);
+	g_object_unref (task);
+}
+
+static void
+bulk_import_finish (BulkOp *op)
+{
+	BulkImportInfo *info = op->data;
+	char *heading;
+
+	heading = g_strdup_printf (ngettext ("Imported %u of %u VPN connection",
+	                                     "Imported %u of %u VPN connections",
+	                                     op->items->len),
+	                           info->added, op->items->len);
+	if (op->errors->len)
+		nm_connection_editor_warning (op->parent_window, heading, "%s", op->errors->str);
+	else
+		nm_connection_editor_info (op->parent_window, heading, "%s", _("All files were imported."));
+	g_free (heading);
+
+	if (info->result_func)
+		(*info->result_func) (info->added, info->user_data);
+
+	g_object_unref (info->client);
+	g_hash_table_destroy (info->ids);
+	g_slice_free (BulkImportInfo, info);
+}
+
+/* Imports each of @filenames as a new VPN connection, parsing in worker
+ * threads and pipelining the adds, then shows one summary.  @result_func
+ * runs once at the end with the number of connections added.
+ */
+void
+import_vpn_files (GtkWindow *parent_window,
+                  NMClient *client,
+                  GPtrArray *filenames,
+                  ImportVpnFilesResultFunc result_func,
+                  gpointer user_data)
+{
+	BulkImportInfo *info;
+
+	g_return_if_fail (NM_IS_CLIENT (client));
+	g_return_if_fail (filenames != NULL);
+
+	if (!filenames->len) {
+		if (result_func)
+			(*result_func) (0, user_data);
+		return;
+	}
+
+	/* The plugin list is loaded lazily and without locking; make sure
+	 * that happens here rather than in a worker thread.
+	 */
+	vpn_get_plugins ();
+
+	info = g_slice_new0 (BulkImportInfo);
+	info->client = g_object_ref (client);
+	info->ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	info->result_func = result_func;
+	info->user_data = user_data;
+
+	bulk_op_run (bulk_op_new (parent_window, _("Importing VPN connections"), filenames,
+	                          bulk_import_start, bulk_import_finish, info));
+}
+
 gboolean
 connection_supports_ip4 (NMConnection *connection)
 {
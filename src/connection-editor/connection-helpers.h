@@ -68,6 +68,26 @@ void delete_connection (GtkWindow *parent_window,
                         DeleteConnectionResultFunc result_func,
                         gpointer user_data);
 
+typedef void (*DeleteConnectionsResultFunc) (GPtrArray *deleted,
+                                             gpointer user_data);
+
+void delete_connections (GtkWindow *parent_window,
+                         GPtrArray *connections,
+                         DeleteConnectionsResultFunc result_func,
+                         gpointer user_data);
+
+void export_connections (GtkWindow *parent_window,
+                         GPtrArray *connections);
+
+typedef void (*ImportVpnFilesResultFunc) (guint added,
+                                          gpointer user_data);
+
+void import_vpn_files (GtkWindow *parent_window,
+                       NMClient *client,
+                       GPtrArray *filenames,
+                       ImportVpnFilesResultFunc result_func,
+                       gpointer user_data);
+
 gboolean connection_supports_ip4 (NMConnection *connection);
 gboolean connection_supports_ip6 (NMConnection *connection);
 
@@ -41,6 +41,21 @@
 #define COL_NEXT_HOP 2
 #define COL_METRIC  3
 #define COL_LAST COL_METRIC
+/* Hidden: the row parsed into an NMIPRoute, or NULL if it doesn't parse */
+#define COL_ROUTE   4
+
+#define ROUTE_TABLE_TAG "route-table"
+
+/* Kept on the list store and updated row by row as routes are added, edited
+ * or removed, so that validating the dialog doesn't re-parse every route.
+ * Overlapping routes are fine, but NM drops exact duplicates, so those are
+ * flagged too.
+ */
+typedef struct {
+	GHashTable *keys;   /* route key -> number of rows with that route */
+	guint n_invalid;    /* rows that don't parse */
+	guint n_duplicate;  /* rows whose route also appears on another row */
+} RouteTable;
 
 /* Variables to temporarily save last edited cell value
  * from routes treeview (cancelling issues) */
@@ -163,14 +178,192 @@ get_one_addr (GtkTreeModel *model,
 	return TRUE;
 }
 
+static NMIPRoute *
+parse_row (GtkTreeModel *model, GtkTreeIter *iter)
+{
+	char *addr = NULL, *next_hop = NULL;
+	guint32 prefix = 0, metric = 0;
+	NMIPRoute *route = NULL;
+
+	/* Address */
+	if (!get_one_addr (model, iter, COL_ADDRESS, TRUE, &addr, NULL))
+		return NULL;
+
+	/* Prefix */
+	if (!get_one_prefix (model, iter, COL_PREFIX, TRUE, &prefix, NULL))
+		goto out;
+	/* Don't allow zero prefix for now - that's not supported in libnm-util */
+	if (prefix == 0)
+		goto out;
+
+	/* Next hop (optional) */
+	if (!get_one_addr (model, iter, COL_NEXT_HOP, FALSE, &next_hop, NULL))
+		goto out;
+
+	/* Metric (optional) */
+	if (!get_one_int (model, iter, COL_METRIC, G_MAXUINT32, FALSE, &metric, NULL))
+		goto out;
+
+	route = nm_ip_route_new (AF_INET, addr, prefix, next_hop, metric, NULL);
+
+out:
+	g_free (addr);
+	g_free (next_hop);
+	return route;
+}
+
+static char *
+route_key (NMIPRoute *route)
+{
+	const char *next_hop = nm_ip_route_get_next_hop (route);
+
+	return g_strdup_printf ("%s/%u %s %" G_GINT64_FORMAT,
+	                        nm_ip_route_get_dest (route),
+	                        nm_ip_route_get_prefix (route),
+	                        next_hop ? next_hop : "",
+	                        nm_ip_route_get_metric (route));
+}
+
+static void
+route_table_free (RouteTable *table)
+{
+	g_hash_table_destroy (table->keys);
+	g_slice_free (RouteTable, table);
+}
+
+static RouteTable *
+route_table_get (GtkTreeModel *model)
+{
+	return g_object_get_data (G_OBJECT (model), ROUTE_TABLE_TAG);
+}
+
+static void
+route_table_add (RouteTable *table, NMIPRoute *route)
+{
+	char *key;
+	guint count;
+
+	if (!route) {
+		table->n_invalid++;
+		return;
+	}
+
+	key = route_key (route);
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (table->keys, key)) + 1;
+	g_hash_table_insert (table->keys, key, GUINT_TO_POINTER (count));
+
+	if (count == 2)
+		table->n_duplicate += 2;
+	else if (count > 2)
+		table->n_duplicate++;
+}
+
+static void
+route_table_remove (RouteTable *table, NMIPRoute *route)
+{
+	char *key;
+	guint count;
+
+	if (!route) {
+		table->n_invalid--;
+		return;
+	}
+
+	key = route_key (route);
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (table->keys, key));
+	if (count == 0) {
+		g_free (key);
+		g_return_if_reached ();
+	}
+
+	if (count == 2)
+		table->n_duplicate -= 2;
+	else if (count > 2)
+		table->n_duplicate--;
+
+	if (count == 1)
+		g_hash_table_remove (table->keys, key);
+	else
+		g_hash_table_insert (table->keys, g_strdup (key), GUINT_TO_POINTER (count - 1));
+	g_free (key);
+}
+
+static gboolean
+route_table_is_duplicate (RouteTable *table, NMIPRoute *route)
+{
+	char *key;
+	guint count;
+
+	key = route_key (route);
+	count = GPOINTER_TO_UINT (g_hash_table_lookup (table->keys, key));
+	g_free (key);
+	return count > 1;
+}
+
+static void
+route_row_append (GtkListStore *store,
+                  GtkTreeIter *iter,
+                  const char *addr,
+                  const char *prefix,
+                  const char *next_hop,
+                  const char *metric)
+{
+	NMIPRoute *route;
+
+	gtk_list_store_insert_with_values (store, iter, -1,
+	                                   COL_ADDRESS, addr,
+	                                   COL_PREFIX, prefix,
+	                                   COL_NEXT_HOP, next_hop,
+	                                   COL_METRIC, metric,
+	                                   -1);
+
+	route = parse_row (GTK_TREE_MODEL (store), iter);
+	route_table_add (route_table_get (GTK_TREE_MODEL (store)), route);
+	if (route) {
+		gtk_list_store_set (store, iter, COL_ROUTE, route, -1);
+		nm_ip_route_unref (route);
+	}
+}
+
+/* Re-parse a single row after one of its cells changed */
+static void
+route_row_update (GtkListStore *store, GtkTreeIter *iter)
+{
+	RouteTable *table = route_table_get (GTK_TREE_MODEL (store));
+	NMIPRoute *old = NULL, *route;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (store), iter, COL_ROUTE, &old, -1);
+	route_table_remove (table, old);
+
+	route = parse_row (GTK_TREE_MODEL (store), iter);
+	route_table_add (table, route);
+	gtk_list_store_set (store, iter, COL_ROUTE, route, -1);
+
+	if (old)
+		nm_ip_route_unref (old);
+	if (route)
+		nm_ip_route_unref (route);
+}
+
+static void
+route_row_remove (GtkListStore *store, GtkTreeIter *iter)
+{
+	NMIPRoute *route = NULL;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (store), iter, COL_ROUTE, &route, -1);
+	route_table_remove (route_table_get (GTK_TREE_MODEL (store)), route);
+	gtk_list_store_remove (store, iter);
+
+	if (route)
+		nm_ip_route_unref (route);
+}
+
 static void
 validate (GtkWidget *dialog)
 {
 	GtkBuilder *builder;
 	GtkWidget *widget;
-	GtkTreeModel *model;
-	GtkTreeIter tree_iter;
-	gboolean valid = FALSE, iter_valid = FALSE;
+	RouteTable *table;
 
 	g_return_if_fail (dialog != NULL);
 
@@ -179,41 +372,13 @@ validate (GtkWidget *dialog)
 	g_return_if_fail (GTK_IS_BUILDER (builder));
 
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_routes"));
-	model = gtk_tree_view_get_model (GTK_TREE_VIEW (widget));
-	iter_valid = gtk_tree_model_get_iter_first (model, &tree_iter);
+	table = route_table_get (gtk_tree_view_get_model (GTK_TREE_VIEW (widget)));
 
-	while (iter_valid) {
-		char *addr = NULL, *next_hop = NULL;
-		guint32 prefix = 0, metric = 0;
+	/* An edit can change whether other rows are duplicates */
+	gtk_widget_queue_draw (widget);
 
-		/* Address */
-		if (!get_one_addr (model, &tree_iter, COL_ADDRESS, TRUE, &addr, NULL))
-			goto done;
-		g_free (addr);
-
-		/* Prefix */
-		if (!get_one_prefix (model, &tree_iter, COL_PREFIX, TRUE, &prefix, NULL))
-			goto done;
-		/* Don't allow zero prefix for now - that's not supported in libnm-util */
-		if (prefix == 0)
-			goto done;
-
-		/* Next hop (optional) */
-		if (!get_one_addr (model, &tree_iter, COL_NEXT_HOP, FALSE, &next_hop, NULL))
-			goto done;
-		g_free (next_hop);
-
-		/* Metric (optional) */
-		if (!get_one_int (model, &tree_iter, COL_METRIC, G_MAXUINT32, FALSE, &metric, NULL))
-			goto done;
-
-		iter_valid = gtk_tree_model_iter_next (model, &tree_iter);
-	}
-	valid = TRUE;
-
-done:
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ok_button"));
-	gtk_widget_set_sensitive (widget, valid);
+	gtk_widget_set_sensitive (widget, table->n_invalid == 0 && table->n_duplicate == 0);
 }
 
 static void
@@ -230,8 +395,7 @@ route_add_clicked (GtkButton *button, gpointer user_data)
 
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_routes"));
 	store = GTK_LIST_STORE (gtk_tree_view_get_model (GTK_TREE_VIEW (widget)));
-	gtk_list_store_append (store, &iter);
-	gtk_list_store_set (store, &iter, COL_ADDRESS, "", -1);
+	route_row_append (store, &iter, "", NULL, NULL, NULL);
 
 	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (widget));
 	gtk_tree_selection_select_iter (selection, &iter);
@@ -274,7 +438,7 @@ route_delete_clicked (GtkButton *button, gpointer user_data)
 		return;
 
 	if (gtk_tree_model_get_iter (model, &iter, (GtkTreePath *) selected_rows->data))
-		gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
+		route_row_remove (GTK_LIST_STORE (model), &iter);
 
 	g_list_foreach (selected_rows, (GFunc) gtk_tree_path_free, NULL);
 	g_list_free (selected_rows);
@@ -315,6 +479,7 @@ cell_editing_canceled (GtkCellRenderer *renderer, gpointer user_data)
 		if (gtk_tree_selection_get_selected (selection, &model, &iter)) {
 			column = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (renderer), "column"));
 			gtk_list_store_set (GTK_LIST_STORE (model), &iter, column, last_edited, -1);
+			route_row_update (GTK_LIST_STORE (model), &iter);
 		}
 
 		g_free (last_edited);
@@ -362,6 +527,7 @@ cell_edited (GtkCellRendererText *cell,
 
 	gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, path);
 	gtk_list_store_set (store, &iter, column, new_text, -1);
+	route_row_update (store, &iter);
 
 	/* Move focus to the next/previous column */
 	can_cycle = g_object_get_data (G_OBJECT (cell), DO_NOT_CYCLE_TAG) == NULL;
@@ -663,6 +829,7 @@ tree_view_button_pressed_cb (GtkWidget *widget,
 
 		gtk_tree_model_get_iter (GTK_TREE_MODEL (store), &iter, last_treepath);
 		gtk_list_store_set (store, &iter, last_column, last_edited, -1);
+		route_row_update (store, &iter);
 		gtk_tree_path_free (last_treepath);
 
 		g_free (last_edited);
@@ -681,6 +848,234 @@ tree_view_button_pressed_cb (GtkWidget *widget,
 	return FALSE;
 }
 
+static void
+routes_error_dialog (GtkBuilder *builder, const char *heading, const char *message)
+{
+	GtkWidget *dialog;
+
+	dialog = gtk_message_dialog_new (GTK_WINDOW (gtk_builder_get_object (builder, "ip4_routes_dialog")),
+	                                 GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT,
+	                                 GTK_MESSAGE_ERROR,
+	                                 GTK_BUTTONS_CLOSE,
+	                                 "%s", heading);
+	gtk_message_dialog_format_secondary_text (GTK_MESSAGE_DIALOG (dialog), "%s", message);
+	gtk_dialog_run (GTK_DIALOG (dialog));
+	gtk_widget_destroy (dialog);
+}
+
+/* Add one row per route in @text (see utils_parse_route_line()).  Lines
+ * that don't give a valid route are left out and reported in @error.
+ */
+static gboolean
+routes_import_text (GtkBuilder *builder, const char *text, GError **error)
+{
+	GtkTreeView *treeview;
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	GString *failed;
+	char **lines;
+	int i;
+
+	treeview = GTK_TREE_VIEW (gtk_builder_get_object (builder, "ip4_routes"));
+	model = g_object_ref (gtk_tree_view_get_model (treeview));
+
+	/* Detach the model so the view doesn't update for every row */
+	gtk_tree_view_set_model (treeview, NULL);
+
+	failed = g_string_new (NULL);
+	lines = g_strsplit (text, "\n", -1);
+	for (i = 0; lines[i]; i++) {
+		char *addr, *prefix, *next_hop, *metric;
+		NMIPRoute *route = NULL;
+
+		if (!utils_parse_route_line (lines[i], AF_INET, &addr, &prefix, &next_hop, &metric))
+			continue;
+
+		route_row_append (GTK_LIST_STORE (model), &iter, addr, prefix, next_hop, metric);
+		gtk_tree_model_get (model, &iter, COL_ROUTE, &route, -1);
+		if (route)
+			nm_ip_route_unref (route);
+		else {
+			route_row_remove (GTK_LIST_STORE (model), &iter);
+			if (failed->len)
+				g_string_append_c (failed, '\n');
+			g_string_append_printf (failed, _("Line %d: “%s” is not a valid route"),
+			                        i + 1, g_strstrip (lines[i]));
+		}
+		g_free (addr);
+		g_free (prefix);
+		g_free (next_hop);
+		g_free (metric);
+	}
+	g_strfreev (lines);
+
+	gtk_tree_view_set_model (treeview, model);
+	g_object_unref (model);
+
+	validate (GTK_WIDGET (gtk_builder_get_object (builder, "ip4_routes_dialog")));
+
+	if (failed->len) {
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, failed->str);
+		g_string_free (failed, TRUE);
+		return FALSE;
+	}
+	g_string_free (failed, TRUE);
+	return TRUE;
+}
+
+static char *
+routes_export_text (GtkBuilder *builder)
+{
+	GtkTreeModel *model;
+	GtkTreeIter iter;
+	gboolean iter_valid;
+	GString *text;
+
+	model = gtk_tree_view_get_model (GTK_TREE_VIEW (gtk_builder_get_object (builder, "ip4_routes")));
+	text = g_string_new (NULL);
+
+	iter_valid = gtk_tree_model_get_iter_first (model, &iter);
+	while (iter_valid) {
+		NMIPRoute *route = NULL;
+
+		gtk_tree_model_get (model, &iter, COL_ROUTE, &route, -1);
+		if (route) {
+			g_string_append_printf (text, "%s/%u",
+			                        nm_ip_route_get_dest (route),
+			                        nm_ip_route_get_prefix (route));
+			if (nm_ip_route_get_next_hop (route))
+				g_string_append_printf (text, " via %s", nm_ip_route_get_next_hop (route));
+			if (nm_ip_route_get_metric (route) > 0)
+				g_string_append_printf (text, " metric %" G_GINT64_FORMAT, nm_ip_route_get_metric (route));
+			g_string_append_c (text, '\n');
+			nm_ip_route_unref (route);
+		}
+
+		iter_valid = gtk_tree_model_iter_next (model, &iter);
+	}
+
+	return g_string_free (text, FALSE);
+}
+
+static void
+route_import_clicked (GtkButton *button, gpointer user_data)
+{
+	GtkBuilder *builder = GTK_BUILDER (user_data);
+	GtkWidget *dialog;
+	char *filename, *contents = NULL;
+	GError *error = NULL;
+
+	dialog = gtk_file_chooser_dialog_new (_("Select file to import"),
+	                                      GTK_WINDOW (gtk_builder_get_object (builder, "ip4_routes_dialog")),
+	                                      GTK_FILE_CHOOSER_ACTION_OPEN,
+	                                      GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+	                                      GTK_STOCK_OPEN, GTK_RESPONSE_ACCEPT,
+	                                      NULL);
+	gtk_window_set_modal (GTK_WINDOW (dialog), TRUE);
+
+	if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+		filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+		if (!filename) {
+			g_warning ("%s: didn't get a filename back from the chooser!", __func__);
+			goto out;
+		}
+
+		if (   !g_file_get_contents (filename, &contents, NULL, &error)
+		    || !routes_import_text (builder, contents, &error)) {
+			char *heading = g_strdup_printf (_("Could not import routes from “%s”"), filename);
+
+			routes_error_dialog (builder, heading, error->message);
+			g_free (heading);
+			g_error_free (error);
+		}
+		g_free (contents);
+		g_free (filename);
+	}
+
+out:
+	gtk_widget_destroy (dialog);
+}
+
+static void
+route_export_clicked (GtkButton *button, gpointer user_data)
+{
+	GtkBuilder *builder = GTK_BUILDER (user_data);
+	GtkWidget *dialog;
+	char *filename, *contents;
+	GError *error = NULL;
+
+	dialog = gtk_file_chooser_dialog_new (_("Export routes..."),
+	                                      GTK_WINDOW (gtk_builder_get_object (builder, "ip4_routes_dialog")),
+	                                      GTK_FILE_CHOOSER_ACTION_SAVE,
+	                                      GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+	                                      GTK_STOCK_SAVE, GTK_RESPONSE_ACCEPT,
+	                                      NULL);
+	gtk_window_set_modal (GTK_WINDOW (dialog), TRUE);
+	gtk_file_chooser_set_do_overwrite_confirmation (GTK_FILE_CHOOSER (dialog), TRUE);
+
+	if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+		filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+		if (!filename) {
+			g_warning ("%s: didn't get a filename back from the chooser!", __func__);
+			goto out;
+		}
+
+		contents = routes_export_text (builder);
+		if (!g_file_set_contents (filename, contents, -1, &error)) {
+			char *heading = g_strdup_printf (_("Could not export routes to “%s”"), filename);
+
+			routes_error_dialog (builder, heading, error->message);
+			g_free (heading);
+			g_error_free (error);
+		}
+		g_free (contents);
+		g_free (filename);
+	}
+
+out:
+	gtk_widget_destroy (dialog);
+}
+
+static void
+routes_paste_received (GtkClipboard *clipboard, const char *text, gpointer user_data)
+{
+	GtkBuilder *builder = GTK_BUILDER (user_data);
+	GError *error = NULL;
+
+	if (text && !routes_import_text (builder, text, &error)) {
+		routes_error_dialog (builder, _("Could not paste routes"), error->message);
+		g_error_free (error);
+	}
+	g_object_unref (builder);
+}
+
+/* Ctrl+C / Ctrl+V on the list copy all routes to, or add routes from,
+ * the clipboard.
+ */
+static gboolean
+tree_view_key_pressed_cb (GtkWidget *widget, GdkEventKey *event, gpointer user_data)
+{
+	GtkBuilder *builder = GTK_BUILDER (user_data);
+	GtkClipboard *clipboard;
+	char *text;
+
+	if ((event->state & gtk_accelerator_get_default_mod_mask ()) != GDK_CONTROL_MASK)
+		return FALSE;
+
+	clipboard = gtk_widget_get_clipboard (widget, GDK_SELECTION_CLIPBOARD);
+	if (event->keyval == GDK_KEY_c || event->keyval == GDK_KEY_C) {
+		text = routes_export_text (builder);
+		gtk_clipboard_set_text (clipboard, text, -1);
+		g_free (text);
+		return TRUE;
+	} else if (event->keyval == GDK_KEY_v || event->keyval == GDK_KEY_V) {
+		gtk_clipboard_request_text (clipboard, routes_paste_received, g_object_ref (builder));
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
 static void
 cell_error_data_func (GtkTreeViewColumn *tree_column,
                       GtkCellRenderer *cell,
@@ -694,8 +1089,20 @@ cell_error_data_func (GtkTreeViewColumn *tree_column,
 	guint32 prefix, metric;
 	const char *color = "red";
 	gboolean invalid = FALSE;
+	NMIPRoute *route = NULL;
 
-	if (col == COL_ADDRESS)
+	/* Rows that parsed are valid, unless the route is repeated; only
+	 * look at individual cells to find what's wrong with the others.
+	 */
+	gtk_tree_model_get (tree_model, iter, COL_ROUTE, &route, -1);
+	if (route) {
+		if (   col == COL_ADDRESS
+		    && route_table_is_duplicate (route_table_get (tree_model), route)) {
+			gtk_tree_model_get (tree_model, iter, COL_ADDRESS, &value, -1);
+			invalid = TRUE;
+		}
+		nm_ip_route_unref (route);
+	} else if (col == COL_ADDRESS)
 		invalid = !get_one_addr (tree_model, iter, COL_ADDRESS, TRUE, &addr, &value);
 	else if (col == COL_PREFIX)
 		invalid =    !get_one_prefix (tree_model, iter, COL_PREFIX, TRUE, &prefix, &value)
@@ -725,6 +1132,7 @@ ip4_routes_dialog_new (NMSettingIPConfig *s_ip4, gboolean automatic)
 	gint offset;
 	GtkTreeViewColumn *column;
 	GtkCellRenderer *renderer;
+	RouteTable *table;
 	int i;
 	GSList *renderers = NULL;
 	GError* error = NULL;
@@ -758,7 +1166,12 @@ ip4_routes_dialog_new (NMSettingIPConfig *s_ip4, gboolean automatic)
 
 	ok_button = GTK_WIDGET (gtk_builder_get_object (builder, "ok_button"));
 
-	store = gtk_list_store_new (4, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+	store = gtk_list_store_new (5, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+	                            NM_TYPE_IP_ROUTE);
+	table = g_slice_new0 (RouteTable);
+	table->keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	g_object_set_data_full (G_OBJECT (store), ROUTE_TABLE_TAG,
+	                        table, (GDestroyNotify) route_table_free);
 
 	/* Add existing routes */
 	for (i = 0; i < nm_setting_ip_config_get_num_routes (s_ip4); i++) {
@@ -779,13 +1192,11 @@ ip4_routes_dialog_new (NMSettingIPConfig *s_ip4, gboolean automatic)
 		g_snprintf (metric, sizeof (metric), "%u",
 		            (guint32) MIN (0, nm_ip_route_get_metric (route)));
 
-		gtk_list_store_append (store, &model_iter);
-		gtk_list_store_set (store, &model_iter,
-		                    COL_ADDRESS, nm_ip_route_get_dest (route),
-		                    COL_PREFIX, netmask,
-		                    COL_NEXT_HOP, nm_ip_route_get_next_hop (route),
-		                    COL_METRIC, metric,
-		                    -1);
+		route_row_append (store, &model_iter,
+		                  nm_ip_route_get_dest (route),
+		                  netmask,
+		                  nm_ip_route_get_next_hop (route),
+		                  metric);
 	}
 
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_routes"));
@@ -875,6 +1286,7 @@ ip4_routes_dialog_new (NMSettingIPConfig *s_ip4, gboolean automatic)
 	                  G_CALLBACK (list_selection_changed),
 	                  GTK_WIDGET (gtk_builder_get_object (builder, "ip4_route_delete_button")));
 	g_signal_connect (widget, "button-press-event", G_CALLBACK (tree_view_button_pressed_cb), builder);
+	g_signal_connect (widget, "key-press-event", G_CALLBACK (tree_view_key_pressed_cb), builder);
 
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_route_add_button"));
 	gtk_widget_set_sensitive (widget, TRUE);
@@ -884,6 +1296,12 @@ ip4_routes_dialog_new (NMSettingIPConfig *s_ip4, gboolean automatic)
 	gtk_widget_set_sensitive (widget, FALSE);
 	g_signal_connect (widget, "clicked", G_CALLBACK (route_delete_clicked), builder);
 
+	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_route_import_button"));
+	g_signal_connect (widget, "clicked", G_CALLBACK (route_import_clicked), builder);
+
+	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_route_export_button"));
+	g_signal_connect (widget, "clicked", G_CALLBACK (route_export_clicked), builder);
+
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_ignore_auto_routes"));
 	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (widget),
 	                              nm_setting_ip_config_get_ignore_auto_routes (s_ip4));
@@ -907,6 +1325,7 @@ ip4_routes_dialog_update_setting (GtkWidget *dialog, NMSettingIPConfig *s_ip4)
 	GtkTreeModel *model;
 	GtkTreeIter tree_iter;
 	gboolean iter_valid;
+	GPtrArray *routes;
 
 	g_return_if_fail (dialog != NULL);
 	g_return_if_fail (s_ip4 != NULL);
@@ -919,52 +1338,26 @@ ip4_routes_dialog_update_setting (GtkWidget *dialog, NMSettingIPConfig *s_ip4)
 	model = gtk_tree_view_get_model (GTK_TREE_VIEW (widget));
 	iter_valid = gtk_tree_model_get_iter_first (model, &tree_iter);
 
-	nm_setting_ip_config_clear_routes (s_ip4);
-
+	routes = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_route_unref);
 	while (iter_valid) {
-		char *addr = NULL, *next_hop = NULL;
-		guint32 prefix = 0, metric = 0;
-		NMIPRoute *route;
-
-		/* Address */
-		if (!get_one_addr (model, &tree_iter, COL_ADDRESS, TRUE, &addr, NULL)) {
-			g_warning ("%s: IPv4 address missing or invalid!", __func__);
-			goto next;
-		}
-
-		/* Prefix */
-		if (!get_one_prefix (model, &tree_iter, COL_PREFIX, TRUE, &prefix, NULL)) {
-			g_warning ("%s: IPv4 prefix/netmask missing or invalid!", __func__);
-			g_free (addr);
-			goto next;
-		}
+		NMIPRoute *route = NULL;
 
-		/* Next hop (optional) */
-		if (!get_one_addr (model, &tree_iter, COL_NEXT_HOP, FALSE, &next_hop, NULL)) {
-			g_warning ("%s: IPv4 next hop invalid!", __func__);
-			g_free (addr);
-			goto next;
-		}
-
-		/* Metric (optional) */
-		if (!get_one_int (model, &tree_iter, COL_METRIC, G_MAXUINT32, FALSE, &metric, NULL)) {
-			g_warning ("%s: IPv4 metric invalid!", __func__);
-			g_free (addr);
-			g_free (next_hop);
-			goto next;
-		}
-
-		route = nm_ip_route_new (AF_INET, addr, prefix, next_hop, metric, NULL);
-		nm_setting_ip_config_add_route (s_ip4, route);
-		nm_ip_route_unref (route);
-
-		g_free (addr);
-		g_free (next_hop);
+		/* Rows were parsed as they were edited */
+		gtk_tree_model_get (model, &tree_iter, COL_ROUTE, &route, -1);
+		if (route)
+			g_ptr_array_add (routes, route);
+		else
+			g_warning ("%s: IPv4 route missing or invalid!", __func__);
 
-	next:
 		iter_valid = gtk_tree_model_iter_next (model, &tree_iter);
 	}
 
+	/* Set them all at once rather than nm_setting_ip_config_add_route(),
+	 * which checks every new route against the existing ones.
+	 */
+	g_object_set (s_ip4, NM_SETTING_IP_CONFIG_ROUTES, routes, NULL);
+	g_ptr_array_unref (routes);
+
 	widget = GTK_WIDGET (gtk_builder_get_object (builder, "ip4_ignore_auto_routes"));
 	g_object_set (s_ip4, NM_SETTING_IP_CONFIG_IGNORE_AUTO_ROUTES,
 	              gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget)),
@@ -975,4 +1368,3 @@ ip4_routes_dialog_update_setting (GtkWidget *dialog, NMSettingIPConfig *s_ip4)
 	              gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget)),
 	              NULL);
 }
-
@@ -38,6 +38,7 @@
 
 #include "nm-connection-list.h"
 #include "nm-connection-editor.h"
+#include "stall-detector.h"
 
 gboolean nm_ce_keep_above;
 
@@ -47,6 +48,7 @@ static GMainLoop *loop = NULL;
 #define ARG_CREATE    "create"
 #define ARG_SHOW      "show"
 #define ARG_UUID      "uuid"
+#define ARG_IMPORT    "import"
 
 #define DBUS_TYPE_G_MAP_OF_VARIANT    (dbus_g_type_get_map ("GHashTable", G_TYPE_STRING, G_TYPE_VALUE))
 
@@ -151,6 +153,7 @@ handle_arguments (NMConnectionList *list,
                   gboolean create,
                   gboolean show,
                   const char *edit_uuid,
+                  const char *import_path,
                   gboolean quit_after)
 {
 	gboolean show_list = TRUE;
@@ -175,6 +178,13 @@ handle_arguments (NMConnectionList *list,
 		return TRUE;
 	}
 
+	/* If only editing a single connection, exit when done with that
+	 * connection.  Connect before acting on the arguments, since an
+	 * import can finish before nm_connection_list_import() returns.
+	 */
+	if (quit_after && !show && (create || edit_uuid || import_path))
+		g_signal_connect_swapped (list, "editing-done", G_CALLBACK (g_main_loop_quit), loop);
+
 	if (show) {
 		/* Just show the given connection type page */
 		nm_connection_list_set_type (list, ctype);
@@ -199,12 +209,12 @@ handle_arguments (NMConnectionList *list,
 		/* Show the edit dialog for the given UUID */
 		nm_connection_list_edit (list, edit_uuid);
 		show_list = FALSE;
+	} else if (import_path) {
+		/* Import the given VPN file, or all files in the given directory */
+		nm_connection_list_import (list, import_path);
+		show_list = FALSE;
 	}
 
-	/* If only editing a single connection, exit when done with that connection */
-	if (show_list == FALSE && quit_after == TRUE)
-		g_signal_connect_swapped (list, "editing-done", G_CALLBACK (g_main_loop_quit), loop);
-
 	g_free (type_tmp);
 	return show_list;
 }
@@ -215,6 +225,7 @@ impl_start (NMCEService *self, GHashTable *table, GError **error)
 	GValue *value;
 	const char *type = NULL;
 	const char *uuid = NULL;
+	const char *import_path = NULL;
 	gboolean create = FALSE;
 	gboolean show = FALSE;
 	gboolean show_list;
@@ -231,6 +242,12 @@ impl_start (NMCEService *self, GHashTable *table, GError **error)
 		g_assert (uuid);
 	}
 
+	value = g_hash_table_lookup (table, ARG_IMPORT);
+	if (value && G_VALUE_HOLDS_STRING (value)) {
+		import_path = g_value_get_string (value);
+		g_assert (import_path);
+	}
+
 	value = g_hash_table_lookup (table, ARG_CREATE);
 	if (value && G_VALUE_HOLDS_BOOLEAN (value))
 		create = g_value_get_boolean (value);
@@ -239,7 +256,7 @@ impl_start (NMCEService *self, GHashTable *table, GError **error)
 	if (value && G_VALUE_HOLDS_BOOLEAN (value))
 		show = g_value_get_boolean (value);
 
-	show_list = handle_arguments (self->list, type, create, show, uuid, FALSE);
+	show_list = handle_arguments (self->list, type, create, show, uuid, import_path, FALSE);
 	if (show_list)
 		nm_connection_list_present (self->list);
 
@@ -252,7 +269,8 @@ try_existing_instance (DBusGConnection *bus,
                        const char *type,
                        gboolean create,
                        gboolean show,
-                       const char *uuid)
+                       const char *uuid,
+                       const char *import_path)
 {
 	gboolean has_owner = FALSE;
 	DBusGProxy *instance;
@@ -261,6 +279,7 @@ try_existing_instance (DBusGConnection *bus,
 	GValue create_value = { 0, };
 	GValue show_value = { 0, };
 	GValue uuid_value = { 0, };
+	GValue import_value = { 0, };
 	gboolean success = FALSE;
 	GError *error = NULL;
 
@@ -301,6 +320,11 @@ try_existing_instance (DBusGConnection *bus,
 		g_value_set_static_string (&uuid_value, uuid);
 		g_hash_table_insert (args, ARG_UUID, &uuid_value);
 	}
+	if (import_path) {
+		g_value_init (&import_value, G_TYPE_STRING);
+		g_value_set_static_string (&import_value, import_path);
+		g_hash_table_insert (args, ARG_IMPORT, &import_value);
+	}
 
 	if (dbus_g_proxy_call (instance, "Start", &error,
 	                       DBUS_TYPE_G_MAP_OF_VARIANT, args, G_TYPE_INVALID,
@@ -347,6 +371,7 @@ main (int argc, char *argv[])
 	gboolean show = FALSE;
 	gboolean success;
 	char *uuid = NULL;
+	char *import_path = NULL;
 	NMCEService *service = NULL;
 	DBusGProxy *proxy = NULL;
 	gboolean show_list;
@@ -356,6 +381,7 @@ main (int argc, char *argv[])
 		{ ARG_CREATE, 'c', 0, G_OPTION_ARG_NONE,   &create, "Create a new connection", NULL },
 		{ ARG_SHOW,   's', 0, G_OPTION_ARG_NONE,   &show,   "Show a given connection type page", NULL },
 		{ "edit",     'e', 0, G_OPTION_ARG_STRING, &uuid,   "Edit an existing connection with a given UUID", "UUID" },
+		{ ARG_IMPORT, 'i', 0, G_OPTION_ARG_FILENAME, &import_path, "Import VPN connections from a file or from all files in a directory", "PATH" },
 
 		/* This is not passed over D-Bus. */
 		{ "keep-above", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &nm_ce_keep_above, NULL, NULL },
@@ -367,6 +393,8 @@ main (int argc, char *argv[])
 	gtk_init (&argc, &argv);
 	textdomain (GETTEXT_PACKAGE);
 
+	stall_detector_init ("nm-connection-editor");
+
 	opt_ctx = g_option_context_new (NULL);
 	g_option_context_set_summary (opt_ctx, "Allows users to view and edit network connection settings");
 	g_option_context_add_main_entries (opt_ctx, entries, NULL);
@@ -383,6 +411,16 @@ main (int argc, char *argv[])
 	if (type && g_strcmp0 (type, NM_SETTING_CDMA_SETTING_NAME) == 0)
 		type = (char *) NM_SETTING_GSM_SETTING_NAME;
 
+	/* An existing instance may be running in another directory */
+	if (import_path && !g_path_is_absolute (import_path)) {
+		char *cwd = g_get_current_dir ();
+		char *tmp = import_path;
+
+		import_path = g_build_filename (cwd, tmp, NULL);
+		g_free (tmp);
+		g_free (cwd);
+	}
+
 	/* Inits the dbus-glib type system too */
 	bus = dbus_g_bus_get (DBUS_BUS_SESSION, NULL);
 	if (bus) {
@@ -396,7 +434,7 @@ main (int argc, char *argv[])
 		 * is one, send the arguments to it and exit instead of opening
 		 * a second instance of the connection editor.
 		 */
-		if (try_existing_instance (bus, proxy, type, create, show, uuid))
+		if (try_existing_instance (bus, proxy, type, create, show, uuid, import_path))
 			return 0;
 	}
 
@@ -417,7 +455,8 @@ main (int argc, char *argv[])
 	g_signal_connect_swapped (list, "done", G_CALLBACK (g_main_loop_quit), loop);
 
 	/* Figure out what page or editor window we'll show initially */
-	show_list = handle_arguments (list, type, create, show, uuid, (create || show || uuid));
+	show_list = handle_arguments (list, type, create, show, uuid, import_path,
+	                              (create || show || uuid || import_path));
 	if (show_list)
 		nm_connection_list_present (list);
 
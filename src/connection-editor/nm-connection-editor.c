@@ -86,6 +86,37 @@ struct GetSecretsInfo {
 
 #define SECRETS_TAG "secrets-setting-name"
 #define ORDER_TAG "page-order"
+#define DEFERRED_TAG "deferred-page"
+
+/* Pages are created up front only for the first EAGER_PAGES tabs (the
+ * general page and the connection-type page shown initially).  The pages
+ * listed in deferrable_pages[] beyond that are represented by a placeholder
+ * tab and only constructed once the tab is first selected.  Until then,
+ * validation falls back to verifying the page's setting directly.  Pages
+ * that hold secrets, add their setting when constructed (Ethernet, team
+ * and bridge ports) or react to other pages (IPv4, IPv6) are never
+ * deferred, since the saved connection would otherwise depend on which
+ * tabs were opened.
+ */
+#define EAGER_PAGES 2
+
+typedef struct {
+	CEPageNewFunc func;
+	const char *title;
+	const char *setting_name;
+} DeferrablePageInfo;
+
+static const DeferrablePageInfo deferrable_pages[] = {
+	{ ce_page_dcb_new,             N_("DCB"),             NM_SETTING_DCB_SETTING_NAME },
+};
+
+typedef struct {
+	const DeferrablePageInfo *info;
+	GtkWidget *placeholder;
+	guint order;
+	CEPage *page;
+	gboolean failed;
+} DeferredPage;
 
 static void
 nm_connection_editor_update_title (NMConnectionEditor *editor)
@@ -215,6 +246,23 @@ connection_editor_validate (NMConnectionEditor *editor)
 		}
 	}
 
+	/* Pages that weren't constructed yet can't have changed their setting */
+	for (iter = editor->deferred_pages; iter; iter = g_slist_next (iter)) {
+		DeferredPage *deferred = iter->data;
+		NMSetting *setting;
+
+		setting = nm_connection_get_setting_by_name (editor->connection,
+		                                             deferred->info->setting_name);
+		if (setting && !nm_setting_verify (setting, editor->connection, &error)) {
+			if (!validation_error) {
+				validation_error = g_strdup_printf (_("Invalid setting %s: %s"),
+				                                    _(deferred->info->title),
+				                                    error->message);
+			}
+			g_clear_error (&error);
+		}
+	}
+
 done:
 	if (g_strcmp0 (validation_error, editor->last_validation_error) != 0) {
 		if (editor->last_validation_error && !validation_error)
@@ -300,6 +348,52 @@ nm_connection_editor_init (NMConnectionEditor *editor)
 	editor->inter_page_hash = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) destroy_inter_page_item);
 }
 
+static void
+deferred_page_free (DeferredPage *deferred)
+{
+	g_slice_free (DeferredPage, deferred);
+}
+
+/* Shows why a page couldn't be built in its own tab, instead of closing
+ * the editor over a page the user may not need.
+ */
+static void
+deferred_page_set_error (NMConnectionEditor *editor,
+                         DeferredPage *deferred,
+                         const char *message)
+{
+	GtkNotebook *notebook;
+	GtkWidget *label;
+	char *text;
+	int num;
+
+	notebook = GTK_NOTEBOOK (gtk_builder_get_object (editor->builder, "notebook"));
+	num = gtk_notebook_page_num (notebook, deferred->placeholder);
+
+	text = g_strdup_printf (_("Error initializing page: %s"), message);
+	label = gtk_label_new (text);
+	g_free (text);
+	gtk_label_set_line_wrap (GTK_LABEL (label), TRUE);
+	g_object_set_data (G_OBJECT (label), ORDER_TAG, GUINT_TO_POINTER (deferred->order));
+	gtk_widget_show (label);
+
+	/* Insert before removing so the current tab never moves to another
+	 * placeholder and builds that page too.
+	 */
+	gtk_notebook_insert_page (notebook, label, gtk_label_new (_(deferred->info->title)), num);
+	gtk_notebook_set_current_page (notebook, num);
+	gtk_notebook_remove_page (notebook, num + 1);
+
+	deferred->placeholder = label;
+	deferred->page = NULL;
+	deferred->failed = TRUE;
+}
+
+static void notebook_switch_page_cb (GtkNotebook *notebook,
+                                     GtkWidget *child,
+                                     guint page_num,
+                                     gpointer user_data);
+
 static void
 get_secrets_info_free (GetSecretsInfo *info)
 {
@@ -328,6 +422,19 @@ dispose (GObject *object)
 	g_slist_free (editor->pages);
 	editor->pages = NULL;
 
+	if (editor->builder) {
+		g_signal_handlers_disconnect_by_func (gtk_builder_get_object (editor->builder, "notebook"),
+		                                      G_CALLBACK (notebook_switch_page_cb), editor);
+	}
+	for (iter = editor->deferred_pages; iter; iter = g_slist_next (iter)) {
+		DeferredPage *deferred = iter->data;
+
+		if (deferred->page)
+			g_object_set_data (G_OBJECT (deferred->page), DEFERRED_TAG, NULL);
+	}
+	g_slist_free_full (editor->deferred_pages, (GDestroyNotify) deferred_page_free);
+	editor->deferred_pages = NULL;
+
 	/* Mark any in-progress secrets call as canceled; it will clean up after itself. */
 	if (editor->secrets_call)
 		editor->secrets_call->canceled = TRUE;
@@ -406,7 +513,7 @@ nm_connection_editor_new (GtkWindow *parent_window,
 
 	g_return_val_if_fail (NM_IS_CONNECTION (connection), NULL);
 
-	is_new = !nm_client_get_connection_by_uuid (client, nm_connection_get_uuid (connection));
+	is_new = !ce_page_get_connection_by_uuid (client, nm_connection_get_uuid (connection));
 
 	editor = g_object_new (NM_TYPE_CONNECTION_EDITOR, NULL);
 	editor->parent_window = parent_window ? g_object_ref (parent_window) : NULL;
@@ -576,8 +683,19 @@ page_initialized (CEPage *page, GError *error, gpointer user_data)
 	GtkWidget *label;
 	GList *children, *iter;
 	gpointer order, child_order;
+	DeferredPage *deferred;
 	int i;
 
+	deferred = g_object_get_data (G_OBJECT (page), DEFERRED_TAG);
+	if (error && deferred) {
+		g_object_set_data (G_OBJECT (page), DEFERRED_TAG, NULL);
+		editor->initializing_pages = g_slist_remove (editor->initializing_pages, page);
+		deferred_page_set_error (editor, deferred, error->message);
+		g_object_unref (page);
+		connection_editor_validate (editor);
+		return;
+	}
+
 	if (error) {
 		gtk_widget_hide (editor->window);
 		nm_connection_editor_error (editor->parent_window,
@@ -606,7 +724,21 @@ page_initialized (CEPage *page, GError *error, gpointer user_data)
 	}
 	g_list_free (children);
 
+	/* Replace the placeholder of a page that was constructed on demand */
 	gtk_notebook_insert_page (notebook, widget, label, i);
+	if (deferred) {
+		int num = gtk_notebook_page_num (notebook, deferred->placeholder);
+
+		/* Switch away from the placeholder before removing it, so the
+		 * notebook doesn't land on another placeholder in between.
+		 */
+		if (num == gtk_notebook_get_current_page (notebook))
+			gtk_notebook_set_current_page (notebook, i);
+		gtk_notebook_remove_page (notebook, num);
+		editor->deferred_pages = g_slist_remove (editor->deferred_pages, deferred);
+		g_object_set_data (G_OBJECT (page), DEFERRED_TAG, NULL);
+		deferred_page_free (deferred);
+	}
 
 	if (CE_IS_PAGE_VPN (page) && ce_page_vpn_can_export (CE_PAGE_VPN (page)))
 		gtk_widget_show (editor->export_button);
@@ -615,6 +747,12 @@ page_initialized (CEPage *page, GError *error, gpointer user_data)
 	editor->initializing_pages = g_slist_remove (editor->initializing_pages, page);
 	editor->pages = g_slist_append (editor->pages, page);
 
+	if (deferred && editor->init_run) {
+		/* Lock the page if the connection can't be modified */
+		update_sensitivity (editor);
+		connection_editor_validate (editor);
+	}
+
 	recheck_initialization (editor);
 }
 
@@ -701,20 +839,42 @@ get_secrets_for_page (NMConnectionEditor *self,
 	}
 }
 
-static gboolean
-add_page (NMConnectionEditor *editor,
-          CEPageNewFunc func,
-          NMConnection *connection,
-          GError **error)
+static void
+page_start_init (NMConnectionEditor *editor, CEPage *page)
+{
+	const char *setting_name = g_object_get_data (G_OBJECT (page), SECRETS_TAG);
+
+	if (!setting_name) {
+		/* page doesn't need any secrets */
+		ce_page_complete_init (page, NULL, NULL, NULL);
+	} else if (!NM_IS_REMOTE_CONNECTION (editor->orig_connection)) {
+		/* We want to get secrets using ->orig_connection, since that's the
+		 * remote connection which can actually respond to secrets requests.
+		 * ->connection is a plain NMConnection copy of ->orig_connection
+		 * which is what gets changed when users modify anything.  But when
+		 * creating or importing, ->orig_connection will be an NMConnection
+		 * since the new connection hasn't been added to NetworkManager yet.
+		 * So basically, skip requesting secrets if the connection can't
+		 * handle a secrets request.
+		 */
+		ce_page_complete_init (page, setting_name, NULL, NULL);
+	} else {
+		/* Page wants secrets, get them */
+		get_secrets_for_page (editor, page, setting_name);
+	}
+	g_object_set_data (G_OBJECT (page), SECRETS_TAG, NULL);
+}
+
+static CEPage *
+create_page (NMConnectionEditor *editor,
+             CEPageNewFunc func,
+             guint order,
+             GError **error)
 {
 	CEPage *page;
 	const char *secrets_setting_name = NULL;
 
-	g_return_val_if_fail (editor != NULL, FALSE);
-	g_return_val_if_fail (func != NULL, FALSE);
-	g_return_val_if_fail (connection != NULL, FALSE);
-
-	page = (*func) (editor, connection, GTK_WINDOW (editor->window), editor->client,
+	page = (*func) (editor, editor->connection, GTK_WINDOW (editor->window), editor->client,
 	                &secrets_setting_name, error);
 	if (page) {
 		g_object_set_data_full (G_OBJECT (page),
@@ -723,13 +883,96 @@ add_page (NMConnectionEditor *editor,
 		                        g_free);
 		g_object_set_data (G_OBJECT (page),
 		                   ORDER_TAG,
-		                   GINT_TO_POINTER (g_slist_length (editor->initializing_pages)));
+		                   GUINT_TO_POINTER (order));
 
 		editor->initializing_pages = g_slist_append (editor->initializing_pages, page);
 		g_signal_connect (page, "changed", G_CALLBACK (page_changed), editor);
 		g_signal_connect (page, "initialized", G_CALLBACK (page_initialized), editor);
 	}
-	return !!page;
+	return page;
+}
+
+static const DeferrablePageInfo *
+find_deferrable_page (CEPageNewFunc func)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (deferrable_pages); i++) {
+		if (deferrable_pages[i].func == func)
+			return &deferrable_pages[i];
+	}
+	return NULL;
+}
+
+static void
+notebook_switch_page_cb (GtkNotebook *notebook,
+                         GtkWidget *child,
+                         guint page_num,
+                         gpointer user_data)
+{
+	NMConnectionEditor *editor = NM_CONNECTION_EDITOR (user_data);
+	DeferredPage *deferred = NULL;
+	GError *error = NULL;
+	GSList *iter;
+
+	/* Tabs get selected while the notebook is being filled too */
+	if (!editor->init_run)
+		return;
+
+	for (iter = editor->deferred_pages; iter; iter = g_slist_next (iter)) {
+		if (((DeferredPage *) iter->data)->placeholder == child) {
+			deferred = iter->data;
+			break;
+		}
+	}
+	if (!deferred || deferred->page || deferred->failed)
+		return;
+
+	deferred->page = create_page (editor, deferred->info->func, deferred->order, &error);
+	if (!deferred->page) {
+		deferred_page_set_error (editor, deferred,
+		                         error ? error->message : _("Unknown error"));
+		g_clear_error (&error);
+		return;
+	}
+
+	g_object_set_data (G_OBJECT (deferred->page), DEFERRED_TAG, deferred);
+	page_start_init (editor, deferred->page);
+}
+
+static gboolean
+add_page (NMConnectionEditor *editor,
+          CEPageNewFunc func,
+          NMConnection *connection,
+          GError **error)
+{
+	const DeferrablePageInfo *info;
+	DeferredPage *deferred;
+	GtkNotebook *notebook;
+	guint order;
+
+	g_return_val_if_fail (editor != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+	g_return_val_if_fail (connection != NULL, FALSE);
+
+	order = g_slist_length (editor->initializing_pages) + g_slist_length (editor->deferred_pages);
+
+	info = find_deferrable_page (func);
+	if (order < EAGER_PAGES || !info)
+		return !!create_page (editor, func, order, error);
+
+	deferred = g_slice_new0 (DeferredPage);
+	deferred->info = info;
+	deferred->order = order;
+	deferred->placeholder = gtk_spinner_new ();
+	g_object_set_data (G_OBJECT (deferred->placeholder), ORDER_TAG, GUINT_TO_POINTER (order));
+	gtk_widget_show (deferred->placeholder);
+
+	notebook = GTK_NOTEBOOK (gtk_builder_get_object (editor->builder, "notebook"));
+	gtk_notebook_append_page (notebook, deferred->placeholder, gtk_label_new (_(info->title)));
+
+	editor->deferred_pages = g_slist_append (editor->deferred_pages, deferred);
+	return TRUE;
 }
 
 static gboolean
@@ -846,32 +1089,14 @@ nm_connection_editor_set_connection (NMConnectionEditor *editor,
 	 * which is why copy the list here.
 	 */
 	copy = g_slist_copy (editor->initializing_pages);
-	for (iter = copy; iter; iter = g_slist_next (iter)) {
-		CEPage *page = CE_PAGE (iter->data);
-		const char *setting_name = g_object_get_data (G_OBJECT (page), SECRETS_TAG);
-
-		if (!setting_name) {
-			/* page doesn't need any secrets */
-			ce_page_complete_init (page, NULL, NULL, NULL);
-		} else if (!NM_IS_REMOTE_CONNECTION (editor->orig_connection)) {
-			/* We want to get secrets using ->orig_connection, since that's the
-			 * remote connection which can actually respond to secrets requests.
-			 * ->connection is a plain NMConnection copy of ->orig_connection
-			 * which is what gets changed when users modify anything.  But when
-			 * creating or importing, ->orig_connection will be an NMConnection
-			 * since the new connection hasn't been added to NetworkManager yet.
-			 * So basically, skip requesting secrets if the connection can't
-			 * handle a secrets request.
-			 */
-			ce_page_complete_init (page, setting_name, NULL, NULL);
-		} else {
-			/* Page wants secrets, get them */
-			get_secrets_for_page (editor, page, setting_name);
-		}
-		g_object_set_data (G_OBJECT (page), SECRETS_TAG, NULL);
-	}
+	for (iter = copy; iter; iter = g_slist_next (iter))
+		page_start_init (editor, CE_PAGE (iter->data));
 	g_slist_free (copy);
 
+	/* Remaining pages are created when their tab is first selected */
+	g_signal_connect_after (gtk_builder_get_object (editor->builder, "notebook"), "switch-page",
+	                  G_CALLBACK (notebook_switch_page_cb), editor);
+
 	/* set the UI */
 	recheck_initialization (editor);
 	success = TRUE;
@@ -1138,6 +1363,16 @@ nm_connection_editor_warning (GtkWindow *parent, const char *heading, const char
 	va_end (args);
 }
 
+void
+nm_connection_editor_info (GtkWindow *parent, const char *heading, const char *format, ...)
+{
+	va_list args;
+
+	va_start (args, format);
+	nm_connection_editor_dialog (parent, GTK_MESSAGE_INFO, heading, format, args);
+	va_end (args);
+}
+
 void
 nm_connection_editor_inter_page_set_value (NMConnectionEditor *editor, InterPageChangeType type, gpointer value)
 {
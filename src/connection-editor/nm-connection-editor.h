@@ -55,6 +55,7 @@ typedef struct {
 
 	GSList *initializing_pages;
 	GSList *pages;
+	GSList *deferred_pages;
 	GtkBuilder *builder;
 	GtkWidget *window;
 	GtkWidget *ok_button;
@@ -104,6 +105,10 @@ void                nm_connection_editor_warning (GtkWindow *parent,
                                                   const char *heading,
                                                   const char *format,
                                                   ...);
+void                nm_connection_editor_info (GtkWindow *parent,
+                                               const char *heading,
+                                               const char *format,
+                                               ...);
 
 void               nm_connection_editor_inter_page_set_value (NMConnectionEditor *editor,
                                                               InterPageChangeType type,
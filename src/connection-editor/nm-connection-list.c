@@ -35,6 +35,8 @@
 #include "nm-connection-list.h"
 #include "ce-polkit-button.h"
 #include "connection-helpers.h"
+#include "vpn-helpers.h"
+#include "stall-detector.h"
 
 extern gboolean nm_ce_keep_above;
 
@@ -57,32 +59,48 @@ static guint list_signals[LIST_LAST_SIGNAL] = { 0 };
 #define COL_GTYPE2     6
 #define COL_ORDER      7
 
-static NMRemoteConnection *
-get_active_connection (GtkTreeView *treeview)
+/* Returns the connections of the selected rows (skipping type headers), referenced */
+static GPtrArray *
+get_selected_connections (GtkTreeView *treeview)
 {
 	GtkTreeSelection *selection;
-	GList *selected_rows;
+	GList *selected_rows, *iter;
 	GtkTreeModel *model = NULL;
-	GtkTreeIter iter;
-	NMRemoteConnection *connection = NULL;
+	GPtrArray *connections;
+
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
 
 	selection = gtk_tree_view_get_selection (treeview);
 	selected_rows = gtk_tree_selection_get_selected_rows (selection, &model);
-	if (!selected_rows)
-		return NULL;
-
-	if (gtk_tree_model_get_iter (model, &iter, (GtkTreePath *) selected_rows->data))
-		gtk_tree_model_get (model, &iter, COL_CONNECTION, &connection, -1);
+	for (iter = selected_rows; iter; iter = iter->next) {
+		NMRemoteConnection *connection = NULL;
+		GtkTreeIter tree_iter;
+
+		if (gtk_tree_model_get_iter (model, &tree_iter, (GtkTreePath *) iter->data))
+			gtk_tree_model_get (model, &tree_iter, COL_CONNECTION, &connection, -1);
+		if (connection)
+			g_ptr_array_add (connections, connection);
+	}
 
 	/* free memory */
-	g_list_foreach (selected_rows, (GFunc) gtk_tree_path_free, NULL);
-	g_list_free (selected_rows);
+	g_list_free_full (selected_rows, (GDestroyNotify) gtk_tree_path_free);
 
-	/* gtk_tree_model_get() will have reffed connection, but we don't
-	 * need that since we know the model will continue to hold a ref.
-	 */
-	if (connection)
-		g_object_unref (connection);
+	return connections;
+}
+
+/* Returns the selected connection if exactly one is selected */
+static NMRemoteConnection *
+get_active_connection (GtkTreeView *treeview)
+{
+	GPtrArray *connections;
+	NMRemoteConnection *connection = NULL;
+
+	connections = get_selected_connections (treeview);
+	if (connections->len == 1)
+		connection = connections->pdata[0];
+
+	/* The model will continue to hold a ref */
+	g_ptr_array_unref (connections);
 
 	return connection;
 }
@@ -92,30 +110,21 @@ get_iter_for_connection (NMConnectionList *list,
                          NMRemoteConnection *connection,
                          GtkTreeIter *iter)
 {
-	GtkTreeIter types_iter;
+	GtkTreeRowReference *row;
+	GtkTreePath *path;
+	gboolean found;
 
-	if (!gtk_tree_model_get_iter_first (list->model, &types_iter))
+	row = g_hash_table_lookup (list->rows, connection);
+	if (!row)
 		return FALSE;
 
-	do {
-		if (!gtk_tree_model_iter_children (list->model, iter, &types_iter))
-			continue;
-
-		do {
-			NMRemoteConnection *candidate = NULL;
-
-			gtk_tree_model_get (list->model, iter,
-			                    COL_CONNECTION, &candidate,
-			                    -1);
-			if (candidate == connection) {
-				g_object_unref (candidate);
-				return TRUE;
-			}
-			g_object_unref (candidate);
-		} while (gtk_tree_model_iter_next (list->model, iter));
-	} while (gtk_tree_model_iter_next (list->model, &types_iter));
+	path = gtk_tree_row_reference_get_path (row);
+	if (!path)
+		return FALSE;
 
-	return FALSE;
+	found = gtk_tree_model_get_iter (list->model, iter, path);
+	gtk_tree_path_free (path);
+	return found;
 }
 
 static char *
@@ -215,17 +224,34 @@ update_connection_row (NMConnectionList *self,
 	gtk_tree_model_filter_refilter (self->filter);
 }
 
+/* Adds to @connections those connections whose master is one of the
+ * first @n_masters in it and that aren't in it already.
+ */
 static void
-delete_slaves_of_connection (NMConnectionList *list, NMConnection *connection)
+add_slaves_of_connections (NMConnectionList *list, GPtrArray *connections, guint n_masters)
 {
-	const char *uuid, *iface;
+	GHashTable *names, *present;
 	GtkTreeIter iter, types_iter;
+	guint i;
 
-	if (!gtk_tree_model_get_iter_first (list->model, &types_iter))
+	if (!n_masters || !gtk_tree_model_get_iter_first (list->model, &types_iter))
 		return;
 
-	uuid = nm_connection_get_uuid (connection);
-	iface = nm_connection_get_interface_name (connection);
+	/* Slaves refer to their master by UUID or by interface name */
+	names = g_hash_table_new (g_str_hash, g_str_equal);
+	present = g_hash_table_new (NULL, NULL);
+	for (i = 0; i < connections->len; i++) {
+		NMConnection *connection = connections->pdata[i];
+		const char *iface;
+
+		g_hash_table_add (present, connection);
+		if (i >= n_masters)
+			continue;
+		g_hash_table_add (names, (gpointer) nm_connection_get_uuid (connection));
+		iface = nm_connection_get_interface_name (connection);
+		if (iface)
+			g_hash_table_add (names, (gpointer) iface);
+	}
 
 	do {
 		if (!gtk_tree_model_iter_children (list->model, &iter, &types_iter))
@@ -241,16 +267,49 @@ delete_slaves_of_connection (NMConnectionList *list, NMConnection *connection)
 			                    -1);
 			s_con = nm_connection_get_setting_connection (NM_CONNECTION (candidate));
 			master = nm_setting_connection_get_master (s_con);
-			if (master) {
-				if (!g_strcmp0 (master, uuid) || !g_strcmp0 (master, iface))
-					nm_remote_connection_delete (candidate, NULL, NULL);
+			if (   master
+			    && g_hash_table_contains (names, master)
+			    && !g_hash_table_contains (present, candidate)) {
+				g_hash_table_add (present, candidate);
+				g_ptr_array_add (connections, g_object_ref (candidate));
 			}
 
 			g_object_unref (candidate);
 		} while (gtk_tree_model_iter_next (list->model, &iter));
 	} while (gtk_tree_model_iter_next (list->model, &types_iter));
+
+	g_hash_table_destroy (present);
+	g_hash_table_destroy (names);
+}
+
+static void
+delete_slaves_of_connection (NMConnectionList *list, NMConnection *connection)
+{
+	GPtrArray *connections;
+	guint i;
+
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+	g_ptr_array_add (connections, g_object_ref (connection));
+	add_slaves_of_connections (list, connections, 1);
+	for (i = 1; i < connections->len; i++)
+		nm_remote_connection_delete (connections->pdata[i], NULL, NULL);
+	g_ptr_array_unref (connections);
 }
 
+static gboolean
+remove_connection_row (NMConnectionList *self, NMRemoteConnection *connection)
+{
+	GtkTreeIter iter;
+	gboolean found;
+
+	found = get_iter_for_connection (self, connection, &iter);
+	if (found)
+		gtk_tree_store_remove (GTK_TREE_STORE (self->model), &iter);
+	if (g_hash_table_remove (self->rows, connection))
+		g_signal_handlers_disconnect_matched (connection, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, self);
+
+	return found;
+}
 
 /**********************************************/
 /* dialog/UI handling stuff */
@@ -362,17 +421,72 @@ delete_connection_cb (NMRemoteConnection *connection, gboolean deleted, gpointer
 		delete_slaves_of_connection (list, NM_CONNECTION (connection));
 }
 
+static void
+delete_connections_cb (GPtrArray *deleted, gpointer user_data)
+{
+	NMConnectionList *list = user_data;
+	guint i;
+
+	/* Drop the rows now rather than one refilter per removal signal */
+	for (i = 0; i < deleted->len; i++)
+		remove_connection_row (list, deleted->pdata[i]);
+
+	list->bulk_ops--;
+	gtk_tree_model_filter_refilter (list->filter);
+	g_object_unref (list);
+}
+
 static void
 delete_clicked (GtkButton *button, gpointer user_data)
 {
 	NMConnectionList *list = user_data;
-	NMRemoteConnection *connection;
+	GPtrArray *connections;
 
-	connection = get_active_connection (list->connection_list);
-	g_return_if_fail (connection != NULL);
+	connections = get_selected_connections (list->connection_list);
+	if (!connections->len) {
+		g_ptr_array_unref (connections);
+		g_return_if_reached ();
+	}
+
+	if (connections->len == 1) {
+		delete_connection (GTK_WINDOW (list->dialog), connections->pdata[0],
+		                   delete_connection_cb, list);
+	} else {
+		/* Slaves go through the same pipeline and error report */
+		add_slaves_of_connections (list, connections, connections->len);
+		list->bulk_ops++;
+		delete_connections (GTK_WINDOW (list->dialog), connections,
+		                    delete_connections_cb, g_object_ref (list));
+	}
+	g_ptr_array_unref (connections);
+}
+
+static void
+export_clicked (GtkButton *button, gpointer user_data)
+{
+	NMConnectionList *list = user_data;
+	GPtrArray *connections;
+
+	connections = get_selected_connections (list->connection_list);
+	export_connections (GTK_WINDOW (list->dialog), connections);
+	g_ptr_array_unref (connections);
+}
+
+static void
+export_button_selection_changed_cb (GtkTreeSelection *selection, gpointer user_data)
+{
+	GtkWidget *button = user_data;
+	NMConnectionList *list = g_object_get_data (G_OBJECT (button), "NMConnectionList");
+	GPtrArray *connections;
+	gboolean sensitive = FALSE;
+	guint i;
+
+	connections = get_selected_connections (list->connection_list);
+	for (i = 0; i < connections->len && !sensitive; i++)
+		sensitive = vpn_can_export (connections->pdata[i]);
+	g_ptr_array_unref (connections);
 
-	delete_connection (GTK_WINDOW (list->dialog), connection,
-	                   delete_connection_cb, list);
+	gtk_widget_set_sensitive (button, sensitive);
 }
 
 static void
@@ -380,21 +494,21 @@ pk_button_selection_changed_cb (GtkTreeSelection *selection, gpointer user_data)
 {
 	CEPolkitButton *button = user_data;
 	NMConnectionList *list = g_object_get_data (G_OBJECT (button), "NMConnectionList");
-	GtkTreeIter iter;
-	GtkTreeModel *model;
-	NMRemoteConnection *connection;
+	gboolean multiple = GPOINTER_TO_UINT (g_object_get_data (G_OBJECT (button), "multiple"));
+	GPtrArray *connections;
 	NMSettingConnection *s_con;
-	gboolean sensitive = FALSE;
+	gboolean sensitive;
+	guint i;
 
-	if (gtk_tree_selection_get_selected (selection, &model, &iter)) {
-		connection = get_active_connection (list->connection_list);
-		if (connection) {
-			s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
-			g_assert (s_con);
+	connections = get_selected_connections (list->connection_list);
+	sensitive = multiple ? connections->len > 0 : connections->len == 1;
+	for (i = 0; i < connections->len && sensitive; i++) {
+		s_con = nm_connection_get_setting_connection (NM_CONNECTION (connections->pdata[i]));
+		g_assert (s_con);
 
-			sensitive = !nm_setting_connection_get_read_only (s_con);
-		}
+		sensitive = !nm_setting_connection_get_read_only (s_con);
 	}
+	g_ptr_array_unref (connections);
 
 	ce_polkit_button_set_validation_error (button, sensitive ? NULL : _("Connection cannot be modified"));
 }
@@ -432,8 +546,21 @@ dispose (GObject *object)
 
 	if (list->gui)
 		g_object_unref (list->gui);
-	if (list->client)
+	if (list->client) {
+		g_signal_handlers_disconnect_matched (list->client, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, list);
 		g_object_unref (list->client);
+		list->client = NULL;
+	}
+	if (list->rows) {
+		GHashTableIter iter;
+		gpointer connection;
+
+		g_hash_table_iter_init (&iter, list->rows);
+		while (g_hash_table_iter_next (&iter, &connection, NULL))
+			g_signal_handlers_disconnect_matched (connection, G_SIGNAL_MATCH_DATA, 0, 0, NULL, NULL, list);
+		g_hash_table_destroy (list->rows);
+		list->rows = NULL;
+	}
 
 	G_OBJECT_CLASS (nm_connection_list_parent_class)->dispose (object);
 }
@@ -603,6 +730,9 @@ initialize_treeview (NMConnectionList *self)
 	                                                     G_TYPE_GTYPE,
 	                                                     G_TYPE_INT));
 
+	self->rows = g_hash_table_new_full (NULL, NULL, NULL,
+	                                    (GDestroyNotify) gtk_tree_row_reference_free);
+
 	/* Filter */
 	self->filter = GTK_TREE_MODEL_FILTER (gtk_tree_model_filter_new (self->model, NULL));
 	gtk_tree_model_filter_set_visible_func (self->filter,
@@ -645,7 +775,7 @@ initialize_treeview (NMConnectionList *self)
 
 	/* Selection */
 	selection = gtk_tree_view_get_selection (self->connection_list);
-	gtk_tree_selection_set_mode (selection, GTK_SELECTION_SINGLE);
+	gtk_tree_selection_set_mode (selection, GTK_SELECTION_MULTIPLE);
 
 	/* Fill in connection types */
 	types = get_connection_type_list ();
@@ -708,10 +838,21 @@ add_connection_buttons (NMConnectionList *self)
 	gtk_button_set_use_underline (GTK_BUTTON (button), TRUE);
 	gtk_box_pack_end (GTK_BOX (box), button, TRUE, TRUE, 0);
 
+	g_object_set_data (G_OBJECT (button), "multiple", GUINT_TO_POINTER (TRUE));
 	g_signal_connect (button, "clicked", G_CALLBACK (delete_clicked), self);
 	g_signal_connect (selection, "changed", G_CALLBACK (pk_button_selection_changed_cb), button);
 	pk_button_selection_changed_cb (selection, button);
 
+	/* Export */
+	button = gtk_button_new_with_mnemonic (_("E_xport"));
+	gtk_widget_set_tooltip_text (button, _("Export the selected connections to files"));
+	g_object_set_data (G_OBJECT (button), "NMConnectionList", self);
+	gtk_box_pack_end (GTK_BOX (box), button, TRUE, TRUE, 0);
+
+	g_signal_connect (button, "clicked", G_CALLBACK (export_clicked), self);
+	g_signal_connect (selection, "changed", G_CALLBACK (export_button_selection_changed_cb), button);
+	export_button_selection_changed_cb (selection, button);
+
 	gtk_widget_show_all (box);
 }
 
@@ -721,13 +862,10 @@ connection_removed (NMClient *client,
                     gpointer user_data)
 {
 	NMConnectionList *self = NM_CONNECTION_LIST (user_data);
-	GtkTreeIter iter, parent_iter;
 
-	if (get_iter_for_connection (self, connection, &iter)) {
-		gtk_tree_model_iter_parent (self->model, &parent_iter, &iter);
-		gtk_tree_store_remove (GTK_TREE_STORE (self->model), &iter);
-	}
-	gtk_tree_model_filter_refilter (self->filter);
+	/* A bulk delete refilters once when it is done */
+	if (remove_connection_row (self, connection) && !self->bulk_ops)
+		gtk_tree_model_filter_refilter (self->filter);
 }
 
 static void
@@ -781,6 +919,7 @@ connection_added (NMClient *client,
 {
 	NMConnectionList *self = NM_CONNECTION_LIST (user_data);
 	GtkTreeIter parent_iter, iter;
+	GtkTreePath *row_path;
 	NMSettingConnection *s_con;
 	char *last_used, *id;
 	gboolean expand = TRUE;
@@ -805,6 +944,11 @@ connection_added (NMClient *client,
 	g_free (id);
 	g_free (last_used);
 
+	row_path = gtk_tree_model_get_path (self->model, &iter);
+	g_hash_table_insert (self->rows, connection,
+	                     gtk_tree_row_reference_new (self->model, row_path));
+	gtk_tree_path_free (row_path);
+
 	if (self->displayed_type) {
 		GType added_type0, added_type1, added_type2;
 
@@ -829,7 +973,6 @@ connection_added (NMClient *client,
 		gtk_tree_path_free (path);
 	}
 
-	g_signal_connect (client, NM_CLIENT_CONNECTION_REMOVED, G_CALLBACK (connection_removed), self);
 	g_signal_connect (connection, NM_CONNECTION_CHANGED, G_CALLBACK (connection_changed), self);
 	gtk_tree_model_filter_refilter (self->filter);
 }
@@ -863,13 +1006,19 @@ nm_connection_list_new (void)
 
 	gtk_window_set_default_icon_name ("preferences-system-network");
 
+	stall_trace_begin ("nm_client_new");
 	list->client = nm_client_new (NULL, NULL);
+	stall_trace_end ();
 	if (!list->client)
 		goto error;
 	g_signal_connect (list->client,
 	                  NM_CLIENT_CONNECTION_ADDED,
 	                  G_CALLBACK (connection_added),
 	                  list);
+	g_signal_connect (list->client,
+	                  NM_CLIENT_CONNECTION_REMOVED,
+	                  G_CALLBACK (connection_removed),
+	                  list);
 
 	list->connection_list = GTK_TREE_VIEW (gtk_builder_get_object (list->gui, "connection_list"));
 	initialize_treeview (list);
@@ -962,6 +1111,75 @@ nm_connection_list_edit (NMConnectionList *self, const gchar *uuid)
 	edit_connection (self, connection);
 }
 
+static void
+import_done_cb (guint added, gpointer user_data)
+{
+	NMConnectionList *self = user_data;
+
+	g_signal_emit (self, list_signals[EDITING_DONE], 0, 0);
+	g_object_unref (self);
+}
+
+static gint
+sort_filenames (gconstpointer a, gconstpointer b)
+{
+	return g_utf8_collate (*(const char **) a, *(const char **) b);
+}
+
+void
+nm_connection_list_import (NMConnectionList *self, const char *path)
+{
+	GPtrArray *filenames;
+	GError *error = NULL;
+
+	g_return_if_fail (NM_IS_CONNECTION_LIST (self));
+	g_return_if_fail (path != NULL);
+
+	filenames = g_ptr_array_new_with_free_func (g_free);
+
+	/* A directory imports every regular file in it */
+	if (g_file_test (path, G_FILE_TEST_IS_DIR)) {
+		GDir *dir;
+		const char *name;
+
+		dir = g_dir_open (path, 0, &error);
+		if (!dir) {
+			nm_connection_editor_error (NULL,
+			                            _("Error importing connections"),
+			                            "%s", error->message);
+			g_error_free (error);
+			g_ptr_array_unref (filenames);
+			g_signal_emit (self, list_signals[EDITING_DONE], 0, 0);
+			return;
+		}
+
+		while ((name = g_dir_read_name (dir))) {
+			char *filename = g_build_filename (path, name, NULL);
+
+			if (g_file_test (filename, G_FILE_TEST_IS_REGULAR))
+				g_ptr_array_add (filenames, filename);
+			else
+				g_free (filename);
+		}
+		g_dir_close (dir);
+		g_ptr_array_sort (filenames, sort_filenames);
+	} else
+		g_ptr_array_add (filenames, g_strdup (path));
+
+	if (!filenames->len) {
+		nm_connection_editor_info (NULL,
+		                           _("No files to import"),
+		                           _("The folder “%s” contains no files."), path);
+		g_ptr_array_unref (filenames);
+		g_signal_emit (self, list_signals[EDITING_DONE], 0, 0);
+		return;
+	}
+
+	import_vpn_files (GTK_WINDOW (self->dialog), self->client, filenames,
+	                  import_done_cb, g_object_ref (self));
+	g_ptr_array_unref (filenames);
+}
+
 static void
 list_response_cb (GtkDialog *dialog, gint response, gpointer user_data)
 {
@@ -44,6 +44,8 @@ typedef struct {
 	GType displayed_type;
 
 	NMClient *client;
+	GHashTable *rows;  /* NMRemoteConnection -> GtkTreeRowReference */
+	guint bulk_ops;
 
 	GtkBuilder *gui;
 	GtkWidget *dialog;
@@ -67,5 +69,6 @@ void              nm_connection_list_set_type (NMConnectionList *list, GType cty
 void              nm_connection_list_present (NMConnectionList *list);
 void              nm_connection_list_create (NMConnectionList *list, GType ctype, const char *detail);
 void              nm_connection_list_edit (NMConnectionList *list, const gchar *uuid);
+void              nm_connection_list_import (NMConnectionList *list, const char *path);
 
 #endif
@@ -260,15 +260,12 @@ populate_ui (CEPageGeneral *self)
 
 	/* Secondary UUID (VPN) */
 	vpn_uuid = nm_setting_connection_get_secondary (setting, 0);
-	con_list = nm_client_get_connections (CE_PAGE (self)->client);
+	con_list = ce_page_get_vpn_connections (CE_PAGE (self)->client);
 	for (i = 0, idx = 0, combo_idx = 0; i < con_list->len; i++) {
 		NMConnection *conn = con_list->pdata[i];
 		const char *uuid = nm_connection_get_uuid (conn);
 		const char *id = nm_connection_get_id (conn);
 
-		if (!nm_connection_is_type (conn, NM_SETTING_VPN_SETTING_NAME))
-			continue;
-
 		gtk_list_store_append (priv->dependent_vpn_store, &iter);
 		gtk_list_store_set (priv->dependent_vpn_store, &iter, COL_ID, id, COL_UUID, uuid, -1);
 		if (g_strcmp0 (vpn_uuid, uuid) == 0)
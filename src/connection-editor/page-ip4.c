@@ -46,6 +46,16 @@ G_DEFINE_TYPE (CEPageIP4, ce_page_ip4, CE_TYPE_PAGE)
 #define COL_PREFIX 1
 #define COL_GATEWAY 2
 #define COL_LAST COL_GATEWAY
+/* Hidden columns caching the parsed row, see addr_row_changed_cb() */
+#define COL_PARSED 3
+#define COL_ERROR 4
+
+typedef enum {
+	ADDR_ROW_OK = 0,
+	ADDR_ROW_BAD_ADDRESS,
+	ADDR_ROW_BAD_PREFIX,
+	ADDR_ROW_BAD_GATEWAY,
+} AddrRowError;
 
 typedef struct {
 	NMSettingIPConfig *setting;
@@ -92,6 +102,15 @@ typedef struct {
 	char *last_edited; /* cell text */
 	char *last_path;   /* row in treeview */
 	int last_column;   /* column in treeview */
+
+	/* Addresses, DNS servers and search domains are only pushed to the
+	 * setting again after they change; the error is kept until then.
+	 */
+	gboolean addresses_dirty;
+	char *addresses_error;
+	gboolean dns_servers_dirty;
+	char *dns_servers_error;
+	gboolean dns_searches_dirty;
 } CEPageIP4Private;
 
 #define METHOD_COL_NAME 0
@@ -345,6 +364,14 @@ set_method (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer
 	return FALSE;
 }
 
+static void addr_row_changed_cb (GtkTreeModel *model,
+                                 GtkTreePath *path,
+                                 GtkTreeIter *iter,
+                                 gpointer user_data);
+static void addresses_changed_cb (GtkTreeModel *model,
+                                  GtkTreePath *path,
+                                  gpointer user_data);
+
 static void
 populate_ui (CEPageIP4 *self)
 {
@@ -380,7 +407,10 @@ populate_ui (CEPageIP4 *self)
 	gtk_tree_model_foreach (GTK_TREE_MODEL (priv->method_store), set_method, &info);
 
 	/* Addresses */
-	store = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+	store = gtk_list_store_new (5, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+	                            NM_TYPE_IP_ADDRESS, G_TYPE_INT);
+	g_signal_connect (store, "row-changed", G_CALLBACK (addr_row_changed_cb), self);
+	g_signal_connect (store, "row-deleted", G_CALLBACK (addresses_changed_cb), self);
 	for (i = 0; i < nm_setting_ip_config_get_num_addresses (setting); i++) {
 		NMIPAddress *addr = nm_setting_ip_config_get_address (setting, i);
 		char buf[32];
@@ -728,6 +758,66 @@ is_address_unspecified (const char *str)
 	        && addr.s_addr == INADDR_ANY);
 }
 
+/* Parse a row of the address list whenever it changes, and keep the result
+ * in the hidden columns so that validating the page doesn't need to parse
+ * every address again.
+ */
+static void
+addr_row_changed_cb (GtkTreeModel *model,
+                     GtkTreePath *path,
+                     GtkTreeIter *iter,
+                     gpointer user_data)
+{
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (user_data);
+	char *addr = NULL, *netmask = NULL, *addr_gw = NULL;
+	NMIPAddress *nm_addr = NULL;
+	AddrRowError err = ADDR_ROW_OK;
+	guint32 prefix;
+
+	gtk_tree_model_get (model, iter,
+	                    COL_ADDRESS, &addr,
+	                    COL_PREFIX, &netmask,
+	                    COL_GATEWAY, &addr_gw,
+	                    -1);
+
+	if (   !addr
+	    || !nm_utils_ipaddr_valid (AF_INET, addr)
+	    || is_address_unspecified (addr))
+		err = ADDR_ROW_BAD_ADDRESS;
+	else if (!parse_netmask (netmask, &prefix))
+		err = ADDR_ROW_BAD_PREFIX;
+	else if (addr_gw && *addr_gw && !nm_utils_ipaddr_valid (AF_INET, addr_gw))
+		err = ADDR_ROW_BAD_GATEWAY;
+	else
+		nm_addr = nm_ip_address_new (AF_INET, addr, prefix, NULL);
+
+	/* Don't come back here for the hidden columns */
+	g_signal_handlers_block_by_func (model, addr_row_changed_cb, user_data);
+	gtk_list_store_set (GTK_LIST_STORE (model), iter,
+	                    COL_PARSED, nm_addr,
+	                    COL_ERROR, err,
+	                    -1);
+	g_signal_handlers_unblock_by_func (model, addr_row_changed_cb, user_data);
+
+	priv->addresses_dirty = TRUE;
+
+	if (nm_addr)
+		nm_ip_address_unref (nm_addr);
+	g_free (addr);
+	g_free (netmask);
+	g_free (addr_gw);
+}
+
+static void
+addresses_changed_cb (GtkTreeModel *model,
+                      GtkTreePath *path,
+                      gpointer user_data)
+{
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (user_data);
+
+	priv->addresses_dirty = TRUE;
+}
+
 static gboolean
 gateway_matches_address (const char *gw_str, const char *addr_str, guint32 prefix)
 {
@@ -1045,6 +1135,22 @@ cell_error_data_func (GtkTreeViewColumn *tree_column,
 	g_free (value);
 }
 
+static void
+dns_servers_changed_cb (GtkEditable *editable, gpointer user_data)
+{
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (user_data);
+
+	priv->dns_servers_dirty = TRUE;
+}
+
+static void
+dns_searches_changed_cb (GtkEditable *editable, gpointer user_data)
+{
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (user_data);
+
+	priv->dns_searches_dirty = TRUE;
+}
+
 static void
 finish_setup (CEPageIP4 *self, gpointer unused, GError *error, gpointer user_data)
 {
@@ -1126,8 +1232,10 @@ finish_setup (CEPageIP4 *self, gpointer unused, GError *error, gpointer user_dat
 	selection = gtk_tree_view_get_selection (priv->addr_list);
 	g_signal_connect (selection, "changed", G_CALLBACK (list_selection_changed), priv->addr_delete);
 
+	g_signal_connect (priv->dns_servers, "changed", G_CALLBACK (dns_servers_changed_cb), self);
 	g_signal_connect_swapped (priv->dns_servers, "changed", G_CALLBACK (ce_page_changed), self);
 	g_signal_connect (priv->dns_servers, "insert-text", G_CALLBACK (dns_servers_filter_cb), self);
+	g_signal_connect (priv->dns_searches, "changed", G_CALLBACK (dns_searches_changed_cb), self);
 	g_signal_connect_swapped (priv->dns_searches, "changed", G_CALLBACK (ce_page_changed), self);
 
 	method_changed (priv->method, self);
@@ -1182,30 +1290,151 @@ ce_page_ip4_new (NMConnectionEditor *editor,
 	return CE_PAGE (self);
 }
 
+static char *
+addr_row_error_message (GtkTreeModel *model, GtkTreeIter *iter, AddrRowError err)
+{
+	char *text = NULL, *message;
+
+	switch (err) {
+	case ADDR_ROW_BAD_PREFIX:
+		gtk_tree_model_get (model, iter, COL_PREFIX, &text, -1);
+		message = g_strdup_printf (_("IPv4 address netmask \"%s\" invalid"), text ? text : "");
+		break;
+	case ADDR_ROW_BAD_GATEWAY:
+		gtk_tree_model_get (model, iter, COL_GATEWAY, &text, -1);
+		message = g_strdup_printf (_("IPv4 gateway \"%s\" invalid"), text ? text : "");
+		break;
+	default:
+		gtk_tree_model_get (model, iter, COL_ADDRESS, &text, -1);
+		message = g_strdup_printf (_("IPv4 address \"%s\" invalid"), text ? text : "");
+		break;
+	}
+
+	g_free (text);
+	return message;
+}
+
+/* Rows are already parsed (see addr_row_changed_cb()), just collect them */
+static void
+update_addresses (CEPageIP4 *self)
+{
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (self);
+	GtkTreeModel *model;
+	GtkTreeIter tree_iter;
+	gboolean iter_valid;
+	GPtrArray *addresses;
+	char *gateway = NULL;
+
+	priv->addresses_dirty = FALSE;
+	g_clear_pointer (&priv->addresses_error, g_free);
+
+	addresses = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_address_unref);
+	model = gtk_tree_view_get_model (priv->addr_list);
+	iter_valid = gtk_tree_model_get_iter_first (model, &tree_iter);
+	while (iter_valid) {
+		NMIPAddress *addr = NULL;
+		int err = ADDR_ROW_OK;
+
+		gtk_tree_model_get (model, &tree_iter,
+		                    COL_PARSED, &addr,
+		                    COL_ERROR, &err,
+		                    -1);
+		if (!addr) {
+			priv->addresses_error = addr_row_error_message (model, &tree_iter, err);
+			goto out;
+		}
+		g_ptr_array_add (addresses, addr);
+
+		if (addresses->len == 1)
+			gtk_tree_model_get (model, &tree_iter, COL_GATEWAY, &gateway, -1);
+
+		iter_valid = gtk_tree_model_iter_next (model, &tree_iter);
+	}
+
+	/* Don't pass empty array to the setting */
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_ADDRESSES, addresses->len ? addresses : NULL,
+	              NM_SETTING_IP_CONFIG_GATEWAY, gateway && *gateway ? gateway : NULL,
+	              NULL);
+
+out:
+	g_ptr_array_unref (addresses);
+	g_free (gateway);
+}
+
+static void
+update_dns_servers (CEPageIP4 *self)
+{
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (self);
+	GPtrArray *dns_servers;
+	char **items, **iter;
+
+	priv->dns_servers_dirty = FALSE;
+	g_clear_pointer (&priv->dns_servers_error, g_free);
+
+	dns_servers = g_ptr_array_new ();
+	items = g_strsplit_set (gtk_entry_get_text (priv->dns_servers), ", ;:", 0);
+	for (iter = items; *iter; iter++) {
+		struct in_addr tmp_addr;
+		char *stripped = g_strstrip (*iter);
+
+		if (!*stripped)
+			continue;
+
+		if (!inet_pton (AF_INET, stripped, &tmp_addr)) {
+			priv->dns_servers_error = g_strdup_printf (_("IPv4 DNS server \"%s\" invalid"), stripped);
+			goto out;
+		}
+		g_ptr_array_add (dns_servers, stripped);
+	}
+	g_ptr_array_add (dns_servers, NULL);
+
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_DNS, dns_servers->pdata,
+	              NULL);
+
+out:
+	g_ptr_array_free (dns_servers, TRUE);
+	g_strfreev (items);
+}
+
 static void
-free_one_addr (gpointer data)
+update_dns_searches (CEPageIP4 *self)
 {
-	nm_ip_address_unref ((NMIPAddress *) data);
+	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (self);
+	GPtrArray *search_domains;
+	char **items, **iter;
+
+	priv->dns_searches_dirty = FALSE;
+
+	search_domains = g_ptr_array_new ();
+	items = g_strsplit_set (gtk_entry_get_text (priv->dns_searches), ", ;:", 0);
+	for (iter = items; *iter; iter++) {
+		char *stripped = g_strstrip (*iter);
+
+		if (*stripped)
+			g_ptr_array_add (search_domains, stripped);
+	}
+	g_ptr_array_add (search_domains, NULL);
+
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_DNS_SEARCH, search_domains->pdata,
+	              NULL);
+
+	g_ptr_array_free (search_domains, TRUE);
+	g_strfreev (items);
 }
 
 static gboolean
 ui_to_setting (CEPageIP4 *self, GError **error)
 {
 	CEPageIP4Private *priv = CE_PAGE_IP4_GET_PRIVATE (self);
-	GtkTreeModel *model;
 	GtkTreeIter tree_iter;
 	int int_method = IP4_METHOD_AUTO;
 	const char *method;
-	GPtrArray *tmp_array = NULL;
-	char **dns_servers = NULL;
-	char **search_domains = NULL;
-	GPtrArray *addresses = NULL;
-	char *gateway = NULL;
-	gboolean valid = FALSE, iter_valid;
-	const char *text;
+	gboolean valid = FALSE;
 	gboolean ignore_auto_dns = FALSE;
 	const char *dhcp_client_id = NULL;
-	char **items = NULL, **iter;
 	gboolean may_fail = FALSE;
 
 	/* Method */
@@ -1235,111 +1464,24 @@ ui_to_setting (CEPageIP4 *self, GError **error)
 		break;
 	}
 
-	/* IP addresses */
-	model = gtk_tree_view_get_model (priv->addr_list);
-	iter_valid = gtk_tree_model_get_iter_first (model, &tree_iter);
-
-	addresses = g_ptr_array_sized_new (1);
-	while (iter_valid) {
-		char *addr = NULL, *netmask = NULL, *addr_gw = NULL;
-		NMIPAddress *nm_addr;
-		guint32 prefix;
-
-		gtk_tree_model_get (model, &tree_iter,
-		                    COL_ADDRESS, &addr,
-		                    COL_PREFIX, &netmask,
-		                    COL_GATEWAY, &addr_gw,
-		                    -1);
-
-		if (   !addr
-		    || !nm_utils_ipaddr_valid (AF_INET, addr)
-		    || is_address_unspecified (addr)) {
-			g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv4 address \"%s\" invalid"), addr ? addr : "");
-			g_free (addr);
-			g_free (netmask);
-			g_free (addr_gw);
-			goto out;
-		}
-
-		if (!parse_netmask (netmask, &prefix)) {
-			g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv4 address netmask \"%s\" invalid"), netmask ? netmask : "");
-			g_free (addr);
-			g_free (netmask);
-			g_free (addr_gw);
-			goto out;
-		}
-
-		/* Gateway is optional... */
-		if (addr_gw && *addr_gw && !nm_utils_ipaddr_valid (AF_INET, addr_gw)) {
-			g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv4 gateway \"%s\" invalid"), addr_gw);
-			g_free (addr);
-			g_free (netmask);
-			g_free (addr_gw);
-			goto out;
-		}
-
-		nm_addr = nm_ip_address_new (AF_INET, addr, prefix, NULL);
-		g_ptr_array_add (addresses, nm_addr);
-
-		if (addresses->len == 1 && addr_gw && *addr_gw) {
-			gateway = addr_gw;
-			addr_gw = NULL;
-		}
+	g_object_freeze_notify (G_OBJECT (priv->setting));
 
-		g_free (addr);
-		g_free (netmask);
-		g_free (addr_gw);
-
-		iter_valid = gtk_tree_model_iter_next (model, &tree_iter);
-	}
-
-	/* Don't pass empty array to the setting */
-	if (!addresses->len) {
-		g_ptr_array_free (addresses, TRUE);
-		addresses = NULL;
-	}
+	/* Only re-read what was edited since the last time */
+	if (priv->addresses_dirty)
+		update_addresses (self);
+	if (priv->dns_servers_dirty)
+		update_dns_servers (self);
+	if (priv->dns_searches_dirty)
+		update_dns_searches (self);
 
-	/* DNS servers */
-	tmp_array = g_ptr_array_new ();
-	text = gtk_entry_get_text (GTK_ENTRY (priv->dns_servers));
-	if (text && strlen (text)) {
-		items = g_strsplit_set (text, ", ;:", 0);
-		for (iter = items; *iter; iter++) {
-			struct in_addr tmp_addr;
-			char *stripped = g_strstrip (*iter);
-
-			if (!*stripped)
-				continue;
-
-			if (inet_pton (AF_INET, stripped, &tmp_addr))
-				g_ptr_array_add (tmp_array, g_strdup (stripped));
-			else {
-				g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv4 DNS server \"%s\" invalid"), stripped);
-				g_strfreev (items);
-				g_ptr_array_free (tmp_array, TRUE);
-				goto out;
-			}
-		}
-		g_strfreev (items);
+	if (priv->addresses_error) {
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, priv->addresses_error);
+		goto out;
 	}
-	g_ptr_array_add (tmp_array, NULL);
-	dns_servers = (char **) g_ptr_array_free (tmp_array, FALSE);
-
-	/* Search domains */
-	tmp_array = g_ptr_array_new ();
-	text = gtk_entry_get_text (GTK_ENTRY (priv->dns_searches));
-	if (text && strlen (text)) {
-		items = g_strsplit_set (text, ", ;:", 0);
-		for (iter = items; *iter; iter++) {
-			char *stripped = g_strstrip (*iter);
-
-			if (strlen (stripped))
-				g_ptr_array_add (tmp_array, g_strdup (stripped));
-		}
-		g_strfreev (items);
+	if (priv->dns_servers_error) {
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, priv->dns_servers_error);
+		goto out;
 	}
-	g_ptr_array_add (tmp_array, NULL);
-	search_domains = (char **) g_ptr_array_free (tmp_array, FALSE);
 
 	/* DHCP client ID */
 	if (!strcmp (method, NM_SETTING_IP4_CONFIG_METHOD_AUTO)) {
@@ -1353,10 +1495,6 @@ ui_to_setting (CEPageIP4 *self, GError **error)
 	/* Update setting */
 	g_object_set (priv->setting,
 	              NM_SETTING_IP_CONFIG_METHOD, method,
-	              NM_SETTING_IP_CONFIG_ADDRESSES, addresses,
-	              NM_SETTING_IP_CONFIG_GATEWAY, gateway,
-	              NM_SETTING_IP_CONFIG_DNS, dns_servers,
-	              NM_SETTING_IP_CONFIG_DNS_SEARCH, search_domains,
 	              NM_SETTING_IP_CONFIG_IGNORE_AUTO_DNS, ignore_auto_dns,
 	              NM_SETTING_IP4_CONFIG_DHCP_CLIENT_ID, dhcp_client_id,
 	              NM_SETTING_IP_CONFIG_MAY_FAIL, may_fail,
@@ -1364,14 +1502,7 @@ ui_to_setting (CEPageIP4 *self, GError **error)
 	valid = TRUE;
 
 out:
-	if (addresses) {
-		g_ptr_array_foreach (addresses, (GFunc) free_one_addr, NULL);
-		g_ptr_array_free (addresses, TRUE);
-	}
-	g_free (gateway);
-
-	g_strfreev (dns_servers);
-	g_strfreev (search_domains);
+	g_object_thaw_notify (G_OBJECT (priv->setting));
 
 	return valid;
 }
@@ -1484,6 +1615,10 @@ ce_page_ip4_init (CEPageIP4 *self)
 	priv->last_column = -1;
 	priv->normal_method_idx = -1;
 	priv->hotspot_method_idx = -1;
+
+	priv->addresses_dirty = TRUE;
+	priv->dns_servers_dirty = TRUE;
+	priv->dns_searches_dirty = TRUE;
 }
 
 static void
@@ -1500,6 +1635,8 @@ dispose (GObject *object)
 		g_object_set_data (G_OBJECT (priv->addr_cells[i]), "ce-page-not-valid", GUINT_TO_POINTER (1));
 
 	g_clear_pointer (&priv->connection_id, g_free);
+	g_clear_pointer (&priv->addresses_error, g_free);
+	g_clear_pointer (&priv->dns_servers_error, g_free);
 
 	G_OBJECT_CLASS (ce_page_ip4_parent_class)->dispose (object);
 }
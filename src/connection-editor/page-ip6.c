@@ -45,6 +45,16 @@ G_DEFINE_TYPE (CEPageIP6, ce_page_ip6, CE_TYPE_PAGE)
 #define COL_PREFIX 1
 #define COL_GATEWAY 2
 #define COL_LAST COL_GATEWAY
+/* Hidden columns caching the parsed row, see addr_row_changed_cb() */
+#define COL_PARSED 3
+#define COL_ERROR 4
+
+typedef enum {
+	ADDR_ROW_OK = 0,
+	ADDR_ROW_BAD_ADDRESS,
+	ADDR_ROW_BAD_PREFIX,
+	ADDR_ROW_BAD_GATEWAY,
+} AddrRowError;
 
 typedef struct {
 	NMSettingIPConfig *setting;
@@ -91,6 +101,15 @@ typedef struct {
 	char *last_edited; /* cell text */
 	char *last_path;   /* row in treeview */
 	int last_column;   /* column in treeview */
+
+	/* Addresses, DNS servers and search domains are only pushed to the
+	 * setting again after they change; the error is kept until then.
+	 */
+	gboolean addresses_dirty;
+	char *addresses_error;
+	gboolean dns_servers_dirty;
+	char *dns_servers_error;
+	gboolean dns_searches_dirty;
 } CEPageIP6Private;
 
 #define METHOD_COL_NAME 0
@@ -341,6 +360,14 @@ set_method (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter, gpointer
 	return FALSE;
 }
 
+static void addr_row_changed_cb (GtkTreeModel *model,
+                                 GtkTreePath *path,
+                                 GtkTreeIter *iter,
+                                 gpointer user_data);
+static void addresses_changed_cb (GtkTreeModel *model,
+                                  GtkTreePath *path,
+                                  gpointer user_data);
+
 static void
 populate_ui (CEPageIP6 *self)
 {
@@ -382,7 +409,10 @@ populate_ui (CEPageIP6 *self)
 	gtk_tree_model_foreach (GTK_TREE_MODEL (priv->method_store), set_method, &info);
 
 	/* Addresses */
-	store = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING);
+	store = gtk_list_store_new (5, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_STRING,
+	                            NM_TYPE_IP_ADDRESS, G_TYPE_INT);
+	g_signal_connect (store, "row-changed", G_CALLBACK (addr_row_changed_cb), self);
+	g_signal_connect (store, "row-deleted", G_CALLBACK (addresses_changed_cb), self);
 	for (i = 0; i < nm_setting_ip_config_get_num_addresses (setting); i++) {
 		NMIPAddress *addr = nm_setting_ip_config_get_address (setting, i);
 		char buf[32];
@@ -715,6 +745,66 @@ delete_text_cb (GtkEditable *editable,
 	priv->last_edited = gtk_editable_get_chars (editable, 0, -1);
 }
 
+/* Parse a row of the address list whenever it changes, and keep the result
+ * in the hidden columns so that validating the page doesn't need to parse
+ * every address again.
+ */
+static void
+addr_row_changed_cb (GtkTreeModel *model,
+                     GtkTreePath *path,
+                     GtkTreeIter *iter,
+                     gpointer user_data)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (user_data);
+	char *addr = NULL, *prefix_str = NULL, *addr_gw = NULL;
+	NMIPAddress *nm_addr = NULL;
+	AddrRowError err = ADDR_ROW_OK;
+	guint32 prefix;
+
+	gtk_tree_model_get (model, iter,
+	                    COL_ADDRESS, &addr,
+	                    COL_PREFIX, &prefix_str,
+	                    COL_GATEWAY, &addr_gw,
+	                    -1);
+
+	if (   !addr
+	    || !nm_utils_ipaddr_valid (AF_INET6, addr)
+	    || is_address_unspecified (addr))
+		err = ADDR_ROW_BAD_ADDRESS;
+	else if (!is_prefix_valid (prefix_str, &prefix))
+		err = ADDR_ROW_BAD_PREFIX;
+	else if (addr_gw && *addr_gw && !nm_utils_ipaddr_valid (AF_INET6, addr_gw))
+		err = ADDR_ROW_BAD_GATEWAY;
+	else
+		nm_addr = nm_ip_address_new (AF_INET6, addr, prefix, NULL);
+
+	/* Don't come back here for the hidden columns */
+	g_signal_handlers_block_by_func (model, addr_row_changed_cb, user_data);
+	gtk_list_store_set (GTK_LIST_STORE (model), iter,
+	                    COL_PARSED, nm_addr,
+	                    COL_ERROR, err,
+	                    -1);
+	g_signal_handlers_unblock_by_func (model, addr_row_changed_cb, user_data);
+
+	priv->addresses_dirty = TRUE;
+
+	if (nm_addr)
+		nm_ip_address_unref (nm_addr);
+	g_free (addr);
+	g_free (prefix_str);
+	g_free (addr_gw);
+}
+
+static void
+addresses_changed_cb (GtkTreeModel *model,
+                      GtkTreePath *path,
+                      gpointer user_data)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (user_data);
+
+	priv->addresses_dirty = TRUE;
+}
+
 static gboolean
 gateway_matches_address (const char *gw_str, const char *addr_str, guint32 prefix)
 {
@@ -1043,6 +1133,22 @@ cell_error_data_func (GtkTreeViewColumn *tree_column,
 	g_free (value);
 }
 
+static void
+dns_servers_changed_cb (GtkEditable *editable, gpointer user_data)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (user_data);
+
+	priv->dns_servers_dirty = TRUE;
+}
+
+static void
+dns_searches_changed_cb (GtkEditable *editable, gpointer user_data)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (user_data);
+
+	priv->dns_searches_dirty = TRUE;
+}
+
 static void
 finish_setup (CEPageIP6 *self, gpointer unused, GError *error, gpointer user_data)
 {
@@ -1124,8 +1230,10 @@ finish_setup (CEPageIP6 *self, gpointer unused, GError *error, gpointer user_dat
 	selection = gtk_tree_view_get_selection (priv->addr_list);
 	g_signal_connect (selection, "changed", G_CALLBACK (list_selection_changed), priv->addr_delete);
 
+	g_signal_connect (priv->dns_servers, "changed", G_CALLBACK (dns_servers_changed_cb), self);
 	g_signal_connect_swapped (priv->dns_servers, "changed", G_CALLBACK (ce_page_changed), self);
 	g_signal_connect (priv->dns_servers, "insert-text", G_CALLBACK (dns_servers_filter_cb), self);
+	g_signal_connect (priv->dns_searches, "changed", G_CALLBACK (dns_searches_changed_cb), self);
 	g_signal_connect_swapped (priv->dns_searches, "changed", G_CALLBACK (ce_page_changed), self);
 	g_signal_connect_swapped (priv->ip6_privacy_combo, "changed", G_CALLBACK (ce_page_changed), self);
 
@@ -1179,19 +1287,150 @@ ce_page_ip6_new (NMConnectionEditor *editor,
 	return CE_PAGE (self);
 }
 
+static char *
+addr_row_error_message (GtkTreeModel *model, GtkTreeIter *iter, AddrRowError err)
+{
+	char *text = NULL, *message;
+
+	switch (err) {
+	case ADDR_ROW_BAD_PREFIX:
+		gtk_tree_model_get (model, iter, COL_PREFIX, &text, -1);
+		message = g_strdup_printf (_("IPv6 prefix \"%s\" invalid"), text ? text : "");
+		break;
+	case ADDR_ROW_BAD_GATEWAY:
+		gtk_tree_model_get (model, iter, COL_GATEWAY, &text, -1);
+		message = g_strdup_printf (_("IPv6 gateway \"%s\" invalid"), text ? text : "");
+		break;
+	default:
+		gtk_tree_model_get (model, iter, COL_ADDRESS, &text, -1);
+		message = g_strdup_printf (_("IPv6 address \"%s\" invalid"), text ? text : "");
+		break;
+	}
+
+	g_free (text);
+	return message;
+}
+
+/* Rows are already parsed (see addr_row_changed_cb()), just collect them */
+static void
+update_addresses (CEPageIP6 *self)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (self);
+	GtkTreeModel *model;
+	GtkTreeIter tree_iter;
+	gboolean iter_valid;
+	GPtrArray *addresses;
+	char *gateway = NULL;
+
+	priv->addresses_dirty = FALSE;
+	g_clear_pointer (&priv->addresses_error, g_free);
+
+	addresses = g_ptr_array_new_with_free_func ((GDestroyNotify) nm_ip_address_unref);
+	model = gtk_tree_view_get_model (priv->addr_list);
+	iter_valid = gtk_tree_model_get_iter_first (model, &tree_iter);
+	while (iter_valid) {
+		NMIPAddress *addr = NULL;
+		int err = ADDR_ROW_OK;
+
+		gtk_tree_model_get (model, &tree_iter,
+		                    COL_PARSED, &addr,
+		                    COL_ERROR, &err,
+		                    -1);
+		if (!addr) {
+			priv->addresses_error = addr_row_error_message (model, &tree_iter, err);
+			goto out;
+		}
+		g_ptr_array_add (addresses, addr);
+
+		if (addresses->len == 1)
+			gtk_tree_model_get (model, &tree_iter, COL_GATEWAY, &gateway, -1);
+
+		iter_valid = gtk_tree_model_iter_next (model, &tree_iter);
+	}
+
+	/* Don't pass empty array to the setting */
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_ADDRESSES, addresses->len ? addresses : NULL,
+	              NM_SETTING_IP_CONFIG_GATEWAY, gateway && *gateway ? gateway : NULL,
+	              NULL);
+
+out:
+	g_ptr_array_unref (addresses);
+	g_free (gateway);
+}
+
+static void
+update_dns_servers (CEPageIP6 *self)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (self);
+	GPtrArray *dns_servers;
+	char **items, **iter;
+
+	priv->dns_servers_dirty = FALSE;
+	g_clear_pointer (&priv->dns_servers_error, g_free);
+
+	dns_servers = g_ptr_array_new ();
+	items = g_strsplit_set (gtk_entry_get_text (priv->dns_servers), ", ;", 0);
+	for (iter = items; *iter; iter++) {
+		struct in6_addr tmp_addr;
+		char *stripped = g_strstrip (*iter);
+
+		if (!*stripped)
+			continue;
+
+		if (!inet_pton (AF_INET6, stripped, &tmp_addr)) {
+			priv->dns_servers_error = g_strdup_printf (_("IPv6 DNS server \"%s\" invalid"), stripped);
+			goto out;
+		}
+		g_ptr_array_add (dns_servers, stripped);
+	}
+	g_ptr_array_add (dns_servers, NULL);
+
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_DNS, dns_servers->pdata,
+	              NULL);
+
+out:
+	g_ptr_array_free (dns_servers, TRUE);
+	g_strfreev (items);
+}
+
+static void
+update_dns_searches (CEPageIP6 *self)
+{
+	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (self);
+	GPtrArray *search_domains;
+	char **items, **iter;
+
+	priv->dns_searches_dirty = FALSE;
+
+	search_domains = g_ptr_array_new ();
+	items = g_strsplit_set (gtk_entry_get_text (priv->dns_searches), ", ;:", 0);
+	for (iter = items; *iter; iter++) {
+		char *stripped = g_strstrip (*iter);
+
+		if (*stripped)
+			g_ptr_array_add (search_domains, stripped);
+	}
+	g_ptr_array_add (search_domains, NULL);
+
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_DNS_SEARCH, search_domains->pdata,
+	              NULL);
+
+	g_ptr_array_free (search_domains, TRUE);
+	g_strfreev (items);
+}
+
 static gboolean
 ui_to_setting (CEPageIP6 *self, GError **error)
 {
 	CEPageIP6Private *priv = CE_PAGE_IP6_GET_PRIVATE (self);
-	GtkTreeModel *model;
 	GtkTreeIter tree_iter;
 	int int_method = IP6_METHOD_AUTO;
 	const char *method;
-	char *gateway = NULL;
-	gboolean valid = FALSE, iter_valid;
-	const char *text;
+	gboolean valid = FALSE;
 	gboolean ignore_auto_dns = FALSE;
-	char **items = NULL, **iter;
 	gboolean may_fail;
 	NMSettingIP6ConfigPrivacy ip6_privacy;
 
@@ -1226,109 +1465,28 @@ ui_to_setting (CEPageIP6 *self, GError **error)
 	}
 
 	g_object_freeze_notify (G_OBJECT (priv->setting));
-	g_object_set (priv->setting,
-	              NM_SETTING_IP_CONFIG_METHOD, method,
-	              NM_SETTING_IP_CONFIG_IGNORE_AUTO_DNS, ignore_auto_dns,
-	              NULL);
-
-	/* IP addresses */
-	nm_setting_ip_config_clear_addresses (priv->setting);
-	model = gtk_tree_view_get_model (priv->addr_list);
-	iter_valid = gtk_tree_model_get_iter_first (model, &tree_iter);
-	while (iter_valid) {
-		char *addr_str = NULL, *prefix_str = NULL, *addr_gw_str = NULL;
-		NMIPAddress *addr;
-		guint32 prefix;
-
-		gtk_tree_model_get (model, &tree_iter,
-		                    COL_ADDRESS, &addr_str,
-		                    COL_PREFIX, &prefix_str,
-		                    COL_GATEWAY, &addr_gw_str,
-		                    -1);
-
-		if (   !addr_str
-		    || !nm_utils_ipaddr_valid (AF_INET6, addr_str)
-		    || is_address_unspecified (addr_str)) {
-			g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv6 address \"%s\" invalid"), addr_str ? addr_str : "");
-			g_free (addr_str);
-			g_free (prefix_str);
-			g_free (addr_gw_str);
-			goto out;
-		}
-
-		if (!is_prefix_valid (prefix_str, &prefix)) {
-			g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv6 prefix \"%s\" invalid"), prefix_str ? prefix_str : "");
-			g_free (addr_str);
-			g_free (prefix_str);
-			g_free (addr_gw_str);
-			goto out;
-		}
-
-		/* Gateway is optional... */
-		if (addr_gw_str && *addr_gw_str && !nm_utils_ipaddr_valid (AF_INET6, addr_gw_str)) {
-			g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv6 gateway \"%s\" invalid"), addr_gw_str);
-			g_free (addr_str);
-			g_free (prefix_str);
-			g_free (addr_gw_str);
-			goto out;
-		}
-
-		addr = nm_ip_address_new (AF_INET6, addr_str, prefix, NULL);
-		nm_setting_ip_config_add_address (priv->setting, addr);
-		nm_ip_address_unref (addr);
 
-		if (nm_setting_ip_config_get_num_addresses (priv->setting) == 1 && addr_gw_str && *addr_gw_str) {
-			gateway = addr_gw_str;
-			addr_gw_str = NULL;
-		}
-
-		g_free (addr_str);
-		g_free (prefix_str);
-		g_free (addr_gw_str);
-
-		iter_valid = gtk_tree_model_iter_next (model, &tree_iter);
+	/* Only re-read what was edited since the last time */
+	if (priv->addresses_dirty)
+		update_addresses (self);
+	if (priv->dns_servers_dirty)
+		update_dns_servers (self);
+	if (priv->dns_searches_dirty)
+		update_dns_searches (self);
+
+	if (priv->addresses_error) {
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, priv->addresses_error);
+		goto out;
 	}
-
-	g_object_set (G_OBJECT (priv->setting),
-	              NM_SETTING_IP_CONFIG_GATEWAY, gateway,
-	              NULL);
-
-	/* DNS servers */
-	nm_setting_ip_config_clear_dns (priv->setting);
-	text = gtk_entry_get_text (GTK_ENTRY (priv->dns_servers));
-	if (text && strlen (text)) {
-		items = g_strsplit_set (text, ", ;", 0);
-		for (iter = items; *iter; iter++) {
-			struct in6_addr tmp_addr;
-			char *stripped = g_strstrip (*iter);
-
-			if (!strlen (stripped))
-				continue;
-
-			if (inet_pton (AF_INET6, stripped, &tmp_addr)) {
-				nm_setting_ip_config_add_dns (priv->setting, stripped);
-			} else {
-				g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("IPv6 DNS server \"%s\" invalid"), stripped);
-				g_strfreev (items);
-				goto out;
-			}
-		}
-		g_strfreev (items);
+	if (priv->dns_servers_error) {
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, priv->dns_servers_error);
+		goto out;
 	}
 
-	/* Search domains */
-	nm_setting_ip_config_clear_dns_searches (priv->setting);
-	text = gtk_entry_get_text (GTK_ENTRY (priv->dns_searches));
-	if (text && strlen (text)) {
-		items = g_strsplit_set (text, ", ;:", 0);
-		for (iter = items; *iter; iter++) {
-			char *stripped = g_strstrip (*iter);
-
-			if (strlen (stripped))
-				nm_setting_ip_config_add_dns_search (priv->setting, stripped);
-		}
-		g_strfreev (items);
-	}
+	g_object_set (priv->setting,
+	              NM_SETTING_IP_CONFIG_METHOD, method,
+	              NM_SETTING_IP_CONFIG_IGNORE_AUTO_DNS, ignore_auto_dns,
+	              NULL);
 
 	/* IPv6 Privacy */
 	switch (gtk_combo_box_get_active (priv->ip6_privacy_combo)) {
@@ -1465,6 +1623,10 @@ ce_page_ip6_init (CEPageIP6 *self)
 	priv->last_column = -1;
 	priv->normal_method_idx = -1;
 	priv->hotspot_method_idx = -1;
+
+	priv->addresses_dirty = TRUE;
+	priv->dns_servers_dirty = TRUE;
+	priv->dns_searches_dirty = TRUE;
 }
 
 static void
@@ -1481,6 +1643,8 @@ dispose (GObject *object)
 		g_object_set_data (G_OBJECT (priv->addr_cells[i]), "ce-page-not-valid", GUINT_TO_POINTER (1));
 
 	g_clear_pointer (&priv->connection_id, g_free);
+	g_clear_pointer (&priv->addresses_error, g_free);
+	g_clear_pointer (&priv->dns_servers_error, g_free);
 
 	G_OBJECT_CLASS (ce_page_ip6_parent_class)->dispose (object);
 }
@@ -46,6 +46,14 @@ typedef struct {
 
 	GHashTable *new_slaves;  /* track whether some slave(s) were added */
 
+	/* Lazily built lookup tables for the duplicate slave checks; thrown
+	 * away whenever the set of devices or slaves changes under us.  Devices
+	 * are found through the editor's shared index.
+	 */
+	gboolean index_valid;
+	GHashTable *slave_devices;    /* NMDevice -> slave NMConnection */
+	GHashTable *slave_ports;      /* physical port id -> NMDevice */
+
 } CEPageMasterPrivate;
 
 enum {
@@ -114,7 +122,9 @@ dispose (GObject *object)
 		} while (gtk_tree_model_iter_next (priv->connections_model, &iter));
 	}
 
-	g_hash_table_destroy (priv->new_slaves);
+	g_clear_pointer (&priv->new_slaves, g_hash_table_destroy);
+	g_clear_pointer (&priv->slave_devices, g_hash_table_destroy);
+	g_clear_pointer (&priv->slave_ports, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (ce_page_master_parent_class)->dispose (object);
 }
@@ -125,6 +135,12 @@ stuff_changed (GtkWidget *widget, gpointer user_data)
 	ce_page_changed (CE_PAGE (user_data));
 }
 
+static void
+invalidate_index (CEPageMaster *self)
+{
+	CE_PAGE_MASTER_GET_PRIVATE (self)->index_valid = FALSE;
+}
+
 static gboolean
 find_connection (CEPageMaster *self, NMRemoteConnection *connection, GtkTreeIter *iter)
 {
@@ -159,6 +175,7 @@ connection_removed (NMClient *client,
 		return;
 
 	gtk_list_store_remove (GTK_LIST_STORE (priv->connections_model), &iter);
+	invalidate_index (self);
 	ce_page_changed (CE_PAGE (self));
 
 	g_signal_emit (self, signals[CONNECTION_REMOVED], 0, connection);
@@ -175,6 +192,9 @@ connection_changed (NMRemoteConnection *connection, gpointer user_data)
 	if (!find_connection (self, connection, &iter))
 		return;
 
+	/* The interface name or MAC the slave is locked to may have changed too */
+	invalidate_index (self);
+
 	/* Name might have changed */
 	s_con = nm_connection_get_setting_connection (NM_CONNECTION (connection));
 	gtk_list_store_set (GTK_LIST_STORE (priv->connections_model), &iter,
@@ -183,23 +203,21 @@ connection_changed (NMRemoteConnection *connection, gpointer user_data)
 }
 
 static NMDevice *
-get_device_for_connection (NMClient *client, NMConnection *conn)
+get_device_for_connection (CEPageMaster *self, NMConnection *conn)
 {
-	const GPtrArray *devices;
 	NMSettingConnection *s_con;
-	int i;
-
-	devices = nm_client_get_devices (client);
-	if (!devices)
-		return NULL;
+	NMDevice *device = NULL;
+	const char *iface;
 
 	/* Make sure the connection is actually locked to a specific device */
-	s_con = nm_connection_get_setting_connection (conn);
-	if (   !nm_setting_connection_get_interface_name (s_con)
-	       && !nm_connection_get_interface_name (conn)) {
+	iface = nm_connection_get_interface_name (conn);
+	if (iface)
+		device = ce_page_get_device_by_iface_or_mac (CE_PAGE (self)->client, iface, NULL);
+	else {
 		NMSetting *s_hw;
-		GByteArray *mac_address;
+		char *mac_address = NULL;
 
+		s_con = nm_connection_get_setting_connection (conn);
 		s_hw = nm_connection_get_setting_by_name (conn, nm_setting_connection_get_connection_type (s_con));
 		if (!s_hw || !g_object_class_find_property (G_OBJECT_GET_CLASS (s_hw), "mac-address"))
 			return NULL;
@@ -207,67 +225,113 @@ get_device_for_connection (NMClient *client, NMConnection *conn)
 		g_object_get (G_OBJECT (s_hw), "mac-address", &mac_address, NULL);
 		if (!mac_address)
 			return NULL;
-		g_byte_array_unref (mac_address);
+		device = ce_page_get_device_by_iface_or_mac (CE_PAGE (self)->client, NULL, mac_address);
+		g_free (mac_address);
 	}
 
-	/* OK, now find that device */
-	for (i = 0; i < devices->len; i++) {
-		NMDevice *device = devices->pdata[i];
-
-		if (nm_device_connection_compatible (device, conn, NULL))
-			return device;
-	}
+	/* OK, now make sure that device can really take the connection */
+	if (device && nm_device_connection_compatible (device, conn, NULL))
+		return device;
 
 	return NULL;
 }
 
+static void
+index_slave (CEPageMaster *self, NMConnection *conn)
+{
+	CEPageMasterPrivate *priv = CE_PAGE_MASTER_GET_PRIVATE (self);
+	NMDevice *dev;
+	const char *id;
+
+	if (!priv->index_valid)
+		return;
+
+	dev = get_device_for_connection (self, conn);
+	if (!dev)
+		return;
+
+	if (!g_hash_table_contains (priv->slave_devices, dev))
+		g_hash_table_insert (priv->slave_devices, dev, conn);
+
+	id = nm_device_get_physical_port_id (dev);
+	if (id && !g_hash_table_contains (priv->slave_ports, id))
+		g_hash_table_insert (priv->slave_ports, (gpointer) id, dev);
+}
+
+static void
+ensure_index (CEPageMaster *self)
+{
+	CEPageMasterPrivate *priv = CE_PAGE_MASTER_GET_PRIVATE (self);
+	GtkTreeIter iter;
+
+	if (priv->index_valid)
+		return;
+
+	g_hash_table_remove_all (priv->slave_devices);
+	g_hash_table_remove_all (priv->slave_ports);
+
+	priv->index_valid = TRUE;
+
+	if (!gtk_tree_model_get_iter_first (priv->connections_model, &iter))
+		return;
+	do {
+		NMConnection *conn = NULL;
+
+		gtk_tree_model_get (priv->connections_model, &iter, COL_CONNECTION, &conn, -1);
+		g_object_unref (conn); /* gtk_tree_model_get() adds a ref */
+		index_slave (self, conn);
+	} while (gtk_tree_model_iter_next (priv->connections_model, &iter));
+}
+
 static void
 check_new_slave_physical_port (CEPageMaster *self, NMConnection *conn)
 {
 	CEPageMasterPrivate *priv = CE_PAGE_MASTER_GET_PRIVATE (self);
 	NMConnection *conn2;
 	NMDevice *dev, *dev2;
-	const char *id, *id2;
-	GtkTreeIter iter;
+	const char *id;
 
-	dev = get_device_for_connection (CE_PAGE (self)->client, conn);
+	ensure_index (self);
+
+	dev = get_device_for_connection (self, conn);
 	if (!dev)
 		return;
 	id = nm_device_get_physical_port_id (dev);
 	if (!id)
 		return;
 
-	if (!gtk_tree_model_get_iter_first (priv->connections_model, &iter))
+	conn2 = g_hash_table_lookup (priv->slave_devices, dev);
+	if (conn2) {
+		nm_connection_editor_warning (CE_PAGE (self)->parent_window,
+		                              _("Duplicate slaves"),
+		                              _("Slaves '%s' and '%s' both apply to device '%s'"),
+		                              nm_connection_get_id (conn),
+		                              nm_connection_get_id (conn2),
+		                              nm_device_get_iface (dev));
 		return;
-	do {
-		gtk_tree_model_get (priv->connections_model, &iter, 0, &conn2, -1);
-		g_object_unref (conn2); /* gtk_tree_model_get() adds a ref */
-		dev2 = get_device_for_connection (CE_PAGE (self)->client, conn2);
-		if (!dev2)
-			continue;
-		if (dev == dev2) {
-			nm_connection_editor_warning (CE_PAGE (self)->parent_window,
-			                              _("Duplicate slaves"),
-			                              _("Slaves '%s' and '%s' both apply to device '%s'"),
-			                              nm_connection_get_id (conn),
-			                              nm_connection_get_id (conn2),
-			                              nm_device_get_iface (dev));
-			return;
-		}
-
-		id2 = nm_device_get_physical_port_id (dev2);
-		if (self->aggregating && id && id2 && !strcmp (id, id2)) {
-			nm_connection_editor_warning (CE_PAGE (self)->parent_window,
-			                              _("Duplicate slaves"),
-			                              _("Slaves '%s' and '%s' apply to different virtual "
-			                                "ports ('%s' and '%s') of the same physical device."),
-			                              nm_connection_get_id (conn),
-			                              nm_connection_get_id (conn2),
-			                              nm_device_get_iface (dev),
-			                              nm_device_get_iface (dev2));
-			return;
-		}
-	} while (gtk_tree_model_iter_next (priv->connections_model, &iter));
+	}
+
+	if (!self->aggregating)
+		return;
+
+	dev2 = g_hash_table_lookup (priv->slave_ports, id);
+	conn2 = dev2 ? g_hash_table_lookup (priv->slave_devices, dev2) : NULL;
+	if (conn2) {
+		nm_connection_editor_warning (CE_PAGE (self)->parent_window,
+		                              _("Duplicate slaves"),
+		                              _("Slaves '%s' and '%s' apply to different virtual "
+		                                "ports ('%s' and '%s') of the same physical device."),
+		                              nm_connection_get_id (conn),
+		                              nm_connection_get_id (conn2),
+		                              nm_device_get_iface (dev),
+		                              nm_device_get_iface (dev2));
+	}
+}
+
+static void
+devices_changed (NMClient *client, NMDevice *device, gpointer user_data)
+{
+	invalidate_index (CE_PAGE_MASTER (user_data));
 }
 
 static void
@@ -309,6 +373,7 @@ connection_added (NMClient *client,
 	                    COL_CONNECTION, connection,
 	                    COL_NAME, nm_setting_connection_get_id (s_con),
 	                    -1);
+	index_slave (self, NM_CONNECTION (connection));
 	ce_page_changed (CE_PAGE (self));
 
 	g_signal_connect (client, NM_CLIENT_CONNECTION_REMOVED,
@@ -368,6 +433,7 @@ add_connection (NMConnection *connection,
 	NMConnectionEditor *editor;
 	const char *iface_name, *master_type;
 	char *name;
+	int num;
 
 	if (!connection)
 		return;
@@ -384,8 +450,13 @@ add_connection (NMConnection *connection,
 		iface_name = nm_connection_get_interface_name (connection);
 	if (!iface_name || !nm_utils_iface_valid_name (iface_name))
 		iface_name = nm_connection_get_id (connection);
-	name = g_strdup_printf (_("%s slave %d"), iface_name,
-	                        gtk_tree_model_iter_n_children (priv->connections_model, NULL) + 1);
+	/* Skip numbers already taken by other connections */
+	num = gtk_tree_model_iter_n_children (priv->connections_model, NULL) + 1;
+	name = g_strdup_printf (_("%s slave %d"), iface_name, num);
+	while (ce_page_connection_id_in_use (CE_PAGE (self)->client, name)) {
+		g_free (name);
+		name = g_strdup_printf (_("%s slave %d"), iface_name, ++num);
+	}
 
 	g_object_set (G_OBJECT (s_con),
 	              NM_SETTING_CONNECTION_ID, name,
@@ -572,6 +643,10 @@ finish_setup (CEPageMaster *self, gpointer unused, GError *error, gpointer user_
 
 	g_signal_connect (CE_PAGE (self)->client, NM_CLIENT_CONNECTION_ADDED,
 	                  G_CALLBACK (connection_added), self);
+	g_signal_connect (CE_PAGE (self)->client, NM_CLIENT_DEVICE_ADDED,
+	                  G_CALLBACK (devices_changed), self);
+	g_signal_connect (CE_PAGE (self)->client, NM_CLIENT_DEVICE_REMOVED,
+	                  G_CALLBACK (devices_changed), self);
 
 	g_signal_connect (priv->interface_name, "changed", G_CALLBACK (stuff_changed), self);
 
@@ -664,6 +739,8 @@ ce_page_master_init (CEPageMaster *self)
 	CEPageMasterPrivate *priv = CE_PAGE_MASTER_GET_PRIVATE (self);
 
 	priv->new_slaves = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	priv->slave_devices = g_hash_table_new (NULL, NULL);
+	priv->slave_ports = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 static void
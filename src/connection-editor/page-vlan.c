@@ -216,8 +216,8 @@ edit_parent_cb (NMConnectionEditor *editor, GtkResponseType response, gpointer u
 		goto finish;
 
 	connection = nm_connection_editor_get_connection (editor);
-	parent = (NMConnection *)nm_client_get_connection_by_uuid (CE_PAGE (self)->client,
-	                                                           nm_connection_get_uuid (connection));
+	parent = ce_page_get_connection_by_uuid (CE_PAGE (self)->client,
+	                                         nm_connection_get_uuid (connection));
 
 	s_con = nm_connection_get_setting_connection (parent);
 	gtk_entry_set_text (priv->parent_entry, nm_setting_connection_get_interface_name (s_con));
@@ -359,6 +359,7 @@ build_vlan_parent_list (CEPageVlan *self, GSList *devices)
 	const GPtrArray *connections;
 	GSList *d_iter;
 	GPtrArray *parents;
+	GHashTable *types;
 	VlanParent *parent;
 	NMDevice *device;
 	const char *iface, *mac, *id;
@@ -386,24 +387,32 @@ build_vlan_parent_list (CEPageVlan *self, GSList *devices)
 		g_ptr_array_add (parents, parent);
 	}
 
-	/* Otherwise, VLANs have to be built on top of configured connections */
-	connections = nm_client_get_connections (CE_PAGE (self)->client);
-	for (i = 0; i < connections->len; i++) {
-		NMConnection *candidate = connections->pdata[i];
-		NMSettingConnection *s_con = nm_connection_get_setting_connection (candidate);
-		GType connection_gtype;
+	/* Otherwise, VLANs have to be built on top of configured connections.
+	 * Only connections of the parent devices' types can qualify, and the
+	 * shared index knows which devices each of those applies to.
+	 */
+	types = g_hash_table_new (NULL, NULL);
+	for (d_iter = devices; d_iter; d_iter = d_iter->next) {
+		GType device_gtype = nm_device_get_setting_type (d_iter->data);
 
-		if (nm_setting_connection_get_master (s_con))
+		if (g_hash_table_contains (types, GSIZE_TO_POINTER (device_gtype)))
 			continue;
+		g_hash_table_add (types, GSIZE_TO_POINTER (device_gtype));
 
-		connection_gtype = nm_setting_lookup_type (nm_setting_connection_get_connection_type (s_con));
-		if (!nm_utils_check_virtual_device_compatibility (NM_TYPE_SETTING_VLAN, connection_gtype))
-			continue;
+		connections = ce_page_get_connections_by_type (CE_PAGE (self)->client, device_gtype);
+		for (i = 0; i < connections->len; i++) {
+			NMConnection *candidate = connections->pdata[i];
+			NMSettingConnection *s_con = nm_connection_get_setting_connection (candidate);
+			const GPtrArray *compatible;
+			int j;
 
-		for (d_iter = devices; d_iter; d_iter = d_iter->next) {
-			device = d_iter->data;
+			if (nm_setting_connection_get_master (s_con))
+				continue;
+
+			compatible = ce_page_get_compatible_devices (CE_PAGE (self)->client, candidate);
+			for (j = 0; j < compatible->len; j++) {
+				device = compatible->pdata[j];
 
-			if (nm_device_connection_valid (device, candidate)) {
 				parent = g_slice_new (VlanParent);
 				parent->device = device;
 				parent->connection = candidate;
@@ -416,10 +425,11 @@ build_vlan_parent_list (CEPageVlan *self, GSList *devices)
 				 */
 				parent->label = g_strdup_printf (_("%s (via \"%s\")"), iface, id);
 				g_ptr_array_add (parents, parent);
-				/* no break here; the connection may apply to multiple devices */
+				/* the connection may apply to multiple devices */
 			}
 		}
 	}
+	g_hash_table_destroy (types);
 
 	g_ptr_array_sort (parents, sort_parents);
 
@@ -444,7 +454,7 @@ static void
 populate_ui (CEPageVlan *self)
 {
 	CEPageVlanPrivate *priv = CE_PAGE_VLAN_GET_PRIVATE (self);
-	GSList *devices, *d_iter;
+	GSList *devices;
 	NMConnection *parent_connection = NULL;
 	NMDevice *device, *parent_device = NULL;
 	const char *parent, *iface, *current_parent;
@@ -459,17 +469,12 @@ populate_ui (CEPageVlan *self)
 	parent = nm_setting_vlan_get_parent (priv->setting);
 	if (parent) {
 		/* UUID? */
-		parent_connection = (NMConnection *)nm_client_get_connection_by_uuid (CE_PAGE (self)->client, parent);
+		parent_connection = ce_page_get_connection_by_uuid (CE_PAGE (self)->client, parent);
 		if (!parent_connection) {
 			/* Interface name? */
-			for (d_iter = devices; d_iter; d_iter = d_iter->next) {
-				device = d_iter->data;
-
-				if (!g_strcmp0 (parent, nm_device_get_iface (device))) {
-					parent_device = device;
-					break;
-				}
-			}
+			device = ce_page_get_device_by_iface_or_mac (CE_PAGE (self)->client, parent, NULL);
+			if (device && g_slist_find (devices, device))
+				parent_device = device;
 		}
 	}
 
@@ -486,18 +491,11 @@ populate_ui (CEPageVlan *self)
 			mac = NULL;
 
 		if (mac) {
-			for (d_iter = devices; d_iter; d_iter = d_iter->next) {
-				device = d_iter->data;
-
-				if (NM_IS_DEVICE_ETHERNET (device))
-					device_mac = nm_device_ethernet_get_permanent_hw_address (NM_DEVICE_ETHERNET (device));
-				else
-					device_mac = NULL;
-
-				if (device_mac && nm_utils_hwaddr_matches (mac, -1, device_mac, -1)) {
+			device = ce_page_get_device_by_iface_or_mac (CE_PAGE (self)->client, NULL, mac);
+			if (device && NM_IS_DEVICE_ETHERNET (device)) {
+				device_mac = nm_device_ethernet_get_permanent_hw_address (NM_DEVICE_ETHERNET (device));
+				if (device_mac && nm_utils_hwaddr_matches (mac, -1, device_mac, -1))
 					parent_device = device;
-					break;
-				}
 			}
 		}
 	}
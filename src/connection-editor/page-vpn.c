@@ -179,11 +179,21 @@ ce_page_vpn_class_init (CEPageVpnClass *vpn_class)
 }
 
 typedef struct {
+	GtkWindow *parent;
 	NMClient *client;
 	PageNewConnectionResultFunc result_func;
 	gpointer user_data;
 } NewVpnInfo;
 
+static void
+new_vpn_info_free (NewVpnInfo *info)
+{
+	if (info->parent)
+		g_object_unref (info->parent);
+	g_object_unref (info->client);
+	g_slice_free (NewVpnInfo, info);
+}
+
 static void
 import_cb (NMConnection *connection, gpointer user_data)
 {
@@ -203,10 +213,7 @@ import_cb (NMConnection *connection, gpointer user_data)
 
 	s = (char *) nm_setting_connection_get_id (s_con);
 	if (!s) {
-		const GPtrArray *connections;
-
-		connections = nm_client_get_connections (info->client);
-		s = ce_page_get_next_available_name (connections, _("VPN connection %d"));
+		s = ce_page_get_next_available_name (info->client, _("VPN connection %d"));
 		g_object_set (s_con, NM_SETTING_CONNECTION_ID, s, NULL);
 		g_free (s);
 	}
@@ -235,8 +242,25 @@ import_cb (NMConnection *connection, gpointer user_data)
 
 	info->result_func (connection, FALSE, error, info->user_data);
 	g_clear_error (&error);
-	g_object_unref (info->client);
-	g_slice_free (NewVpnInfo, info);
+	new_vpn_info_free (info);
+}
+
+static void
+import_batch_done (guint added, gpointer user_data)
+{
+	NewVpnInfo *info = user_data;
+
+	/* The batch has been added already; there is nothing left to edit */
+	info->result_func (NULL, TRUE, NULL, info->user_data);
+	new_vpn_info_free (info);
+}
+
+static void
+import_batch_cb (GPtrArray *filenames, gpointer user_data)
+{
+	NewVpnInfo *info = user_data;
+
+	import_vpn_files (info->parent, info->client, filenames, import_batch_done, info);
 }
 
 void
@@ -249,10 +273,12 @@ vpn_connection_import (GtkWindow *parent,
 	NewVpnInfo *info;
 
 	info = g_slice_new (NewVpnInfo);
+	/* The batch may outlive the window that started it */
+	info->parent = parent ? g_object_ref (parent) : NULL;
 	info->result_func = result_func;
 	info->client = g_object_ref (client);
 	info->user_data = user_data;
-	vpn_import (import_cb, info);
+	vpn_import (import_cb, import_batch_cb, info);
 }
 
 #define NEW_VPN_CONNECTION_PRIMARY_LABEL _("Choose a VPN Connection Type")
@@ -97,8 +97,140 @@ vpn_get_plugins ()
 	return plugins;
 }
 
+/* Guess which plugin a file belongs to from its name and first lines, so
+ * that importing needn't ask each plugin in turn.
+ */
+static const struct {
+	const char *service;
+	const char *extension;
+	const char *line_prefix[3];
+} sniff_rules[] = {
+	{ "org.freedesktop.NetworkManager.openvpn", ".ovpn", { "client", "remote ", "<ca>" } },
+	{ "org.freedesktop.NetworkManager.vpnc",    ".pcf",  { "[main]", NULL } },
+};
+
+#define SNIFF_LINES 50
+
+static const char *
+vpn_sniff_service (const char *filename)
+{
+	char *contents = NULL;
+	char **lines = NULL;
+	const char *service = NULL;
+	guint i, j, k;
+
+	for (i = 0; i < G_N_ELEMENTS (sniff_rules); i++) {
+		if (g_str_has_suffix (filename, sniff_rules[i].extension))
+			return sniff_rules[i].service;
+	}
+
+	if (!g_file_get_contents (filename, &contents, NULL, NULL))
+		return NULL;
+	lines = g_strsplit (contents, "\n", SNIFF_LINES + 1);
+
+	for (j = 0; lines[j] && j < SNIFF_LINES && !service; j++) {
+		const char *line = lines[j];
+
+		while (g_ascii_isspace (*line))
+			line++;
+		for (i = 0; i < G_N_ELEMENTS (sniff_rules) && !service; i++) {
+			for (k = 0; k < G_N_ELEMENTS (sniff_rules[i].line_prefix); k++) {
+				const char *prefix = sniff_rules[i].line_prefix[k];
+
+				if (prefix && !g_ascii_strncasecmp (line, prefix, strlen (prefix))) {
+					service = sniff_rules[i].service;
+					break;
+				}
+			}
+		}
+	}
+
+	g_strfreev (lines);
+	g_free (contents);
+	return service;
+}
+
+/* Third-party editor plugins make no thread-safety promise, so at most
+ * one import runs in each plugin at a time.
+ */
+static NMConnection *
+plugin_import_locked (NMVpnEditorPlugin *plugin, const char *filename, GError **error)
+{
+	static GMutex table_lock;
+	static GHashTable *locks = NULL;
+	NMConnection *connection;
+	GMutex *lock;
+
+	g_mutex_lock (&table_lock);
+	if (!locks)
+		locks = g_hash_table_new (NULL, NULL);
+	lock = g_hash_table_lookup (locks, plugin);
+	if (!lock) {
+		lock = g_new0 (GMutex, 1);
+		g_mutex_init (lock);
+		g_hash_table_insert (locks, plugin, lock);
+	}
+	g_mutex_unlock (&table_lock);
+
+	g_mutex_lock (lock);
+	connection = nm_vpn_editor_plugin_import (plugin, filename, error);
+	g_mutex_unlock (lock);
+
+	return connection;
+}
+
+NMConnection *
+vpn_import_file (const char *filename, GError **error)
+{
+	NMVpnPluginInfo *sniffed = NULL;
+	NMVpnEditorPlugin *plugin;
+	NMConnection *connection = NULL;
+	const char *service;
+	GSList *iter;
+	GError *first_error = NULL;
+	GError *local = NULL;
+
+	service = vpn_sniff_service (filename);
+	if (service)
+		sniffed = nm_vpn_plugin_info_list_find_by_service (vpn_get_plugins (), service);
+
+	if (sniffed) {
+		plugin = nm_vpn_plugin_info_get_editor_plugin (sniffed);
+		if (plugin) {
+			connection = plugin_import_locked (plugin, filename, &first_error);
+			if (connection)
+				return connection;
+		}
+	}
+
+	/* Unknown type, or a wrong guess; see if any other plugin takes it */
+	for (iter = vpn_get_plugins (); !connection && iter; iter = iter->next) {
+		if (iter->data == sniffed)
+			continue;
+		plugin = nm_vpn_plugin_info_get_editor_plugin (iter->data);
+		if (!plugin)
+			continue;
+		g_clear_error (&local);
+		connection = plugin_import_locked (plugin, filename, &local);
+	}
+
+	if (connection) {
+		g_clear_error (&first_error);
+		g_clear_error (&local);
+	} else if (first_error) {
+		g_propagate_error (error, first_error);
+		g_clear_error (&local);
+	} else if (local)
+		g_propagate_error (error, local);
+	else
+		g_set_error_literal (error, NMA_ERROR, NMA_ERROR_GENERIC, _("unknown error"));
+
+	return connection;
+}
+
 typedef struct {
 	VpnImportSuccessCallback callback;
+	VpnImportBatchCallback batch_callback;
 	gpointer user_data;
 } ActionInfo;
 
@@ -107,27 +239,39 @@ import_vpn_from_file_cb (GtkWidget *dialog, gint response, gpointer user_data)
 {
 	char *filename = NULL;
 	ActionInfo *info = (ActionInfo *) user_data;
-	GSList *iter;
+	GSList *filenames = NULL;
 	NMConnection *connection = NULL;
 	GError *error = NULL;
 
 	if (response != GTK_RESPONSE_ACCEPT)
 		goto out;
 
-	filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
-	if (!filename) {
+	filenames = gtk_file_chooser_get_filenames (GTK_FILE_CHOOSER (dialog));
+	if (!filenames) {
 		g_warning ("%s: didn't get a filename back from the chooser!", __func__);
 		goto out;
 	}
 
-	for (iter = vpn_get_plugins (); !connection && iter; iter = iter->next) {
-		NMVpnEditorPlugin *plugin;
+	/* Several files are imported in one go, without an editor for each */
+	if (filenames->next) {
+		GPtrArray *batch;
+		GSList *iter;
 
-		plugin = nm_vpn_plugin_info_get_editor_plugin (iter->data);
-		g_clear_error (&error);
-		connection = nm_vpn_editor_plugin_import (plugin, filename, &error);
+		batch = g_ptr_array_new_with_free_func (g_free);
+		for (iter = filenames; iter; iter = iter->next)
+			g_ptr_array_add (batch, iter->data);
+		g_slist_free (filenames);
+
+		info->batch_callback (batch, info->user_data);
+		g_ptr_array_unref (batch);
+		goto out;
 	}
 
+	filename = filenames->data;
+	g_slist_free (filenames);
+
+	connection = vpn_import_file (filename, &error);
+
 	if (connection)
 		info->callback (connection, info->user_data);
 	else {
@@ -159,7 +303,9 @@ out:
 }
 
 void
-vpn_import (VpnImportSuccessCallback callback, gpointer user_data)
+vpn_import (VpnImportSuccessCallback callback,
+            VpnImportBatchCallback batch_callback,
+            gpointer user_data)
 {
 	GtkWidget *dialog;
 	ActionInfo *info;
@@ -173,9 +319,11 @@ vpn_import (VpnImportSuccessCallback callback, gpointer user_data)
 	                                      NULL);
 	home_folder = g_get_home_dir ();
 	gtk_file_chooser_set_current_folder (GTK_FILE_CHOOSER (dialog), home_folder);
+	gtk_file_chooser_set_select_multiple (GTK_FILE_CHOOSER (dialog), TRUE);
 
 	info = g_malloc0 (sizeof (ActionInfo));
 	info->callback = callback;
+	info->batch_callback = batch_callback;
 	info->user_data = user_data;
 
 	g_signal_connect (G_OBJECT (dialog), "response", G_CALLBACK (import_vpn_from_file_cb), info);
@@ -317,6 +465,69 @@ vpn_export (NMConnection *connection)
 	gtk_window_present (GTK_WINDOW (dialog));
 }
 
+/* Whether @connection is a VPN connection its plugin can export */
+gboolean
+vpn_can_export (NMConnection *connection)
+{
+	NMSettingVpn *s_vpn;
+	const char *service_type;
+	NMVpnEditorPlugin *plugin;
+
+	s_vpn = nm_connection_get_setting_vpn (connection);
+	service_type = s_vpn ? nm_setting_vpn_get_service_type (s_vpn) : NULL;
+	if (!service_type)
+		return FALSE;
+
+	plugin = vpn_get_plugin_by_service (service_type);
+	return    plugin
+	       && (nm_vpn_editor_plugin_get_capabilities (plugin) & NM_VPN_EDITOR_PLUGIN_CAPABILITY_EXPORT);
+}
+
+/* Export @connection into @folder under the plugin's suggested file name,
+ * numbering it if a file of that name is already there.
+ */
+gboolean
+vpn_export_to_folder (NMConnection *connection, const char *folder, GError **error)
+{
+	NMVpnEditorPlugin *plugin;
+	NMSettingVpn *s_vpn;
+	char *suggested, *filename, *ext;
+	gboolean success;
+	int i;
+
+	s_vpn = nm_connection_get_setting_vpn (connection);
+	plugin = s_vpn ? vpn_get_plugin_by_service (nm_setting_vpn_get_service_type (s_vpn)) : NULL;
+	if (!plugin) {
+		g_set_error (error, NMA_ERROR, NMA_ERROR_GENERIC, _("no VPN plugin"));
+		return FALSE;
+	}
+
+	suggested = nm_vpn_editor_plugin_get_suggested_filename (plugin, connection);
+	if (!suggested && nm_connection_get_id (connection))
+		suggested = g_strdup (nm_connection_get_id (connection));
+	if (!suggested)
+		suggested = g_strdup ("vpn");
+	g_strdelimit (suggested, G_DIR_SEPARATOR_S, '_');
+
+	filename = g_build_filename (folder, suggested, NULL);
+	ext = strrchr (suggested, '.');
+	for (i = 2; g_file_test (filename, G_FILE_TEST_EXISTS); i++) {
+		char *numbered;
+
+		g_free (filename);
+		numbered = g_strdup_printf ("%.*s (%d)%s",
+		                            (int) (ext ? ext - suggested : strlen (suggested)),
+		                            suggested, i, ext ? ext : "");
+		filename = g_build_filename (folder, numbered, NULL);
+		g_free (numbered);
+	}
+
+	success = nm_vpn_editor_plugin_export (plugin, filename, connection, error);
+	g_free (filename);
+	g_free (suggested);
+	return success;
+}
+
 gboolean
 vpn_supports_ipv6 (NMConnection *connection)
 {
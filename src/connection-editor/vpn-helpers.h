@@ -33,10 +33,20 @@ GSList *vpn_get_plugins (void);
 NMVpnEditorPlugin *vpn_get_plugin_by_service (const char *service);
 
 typedef void (*VpnImportSuccessCallback) (NMConnection *connection, gpointer user_data);
-void vpn_import (VpnImportSuccessCallback callback, gpointer user_data);
+typedef void (*VpnImportBatchCallback) (GPtrArray *filenames, gpointer user_data);
+void vpn_import (VpnImportSuccessCallback callback,
+                 VpnImportBatchCallback batch_callback,
+                 gpointer user_data);
+
+NMConnection *vpn_import_file (const char *filename, GError **error);
 
 void vpn_export (NMConnection *connection);
 
+gboolean vpn_can_export (NMConnection *connection);
+gboolean vpn_export_to_folder (NMConnection *connection,
+                               const char *folder,
+                               GError **error);
+
 gboolean vpn_supports_ipv6 (NMConnection *connection);
 
 #endif  /* _VPN_HELPERS_H_ */
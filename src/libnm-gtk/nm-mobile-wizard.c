@@ -37,6 +37,7 @@
 
 #include "nm-mobile-wizard.h"
 #include "nm-mobile-providers.h"
+#include "nm-mobile-providers-private.h"
 #include "nm-ui-utils.h"
 #include "utils.h"
 
@@ -71,6 +72,8 @@ struct NMAMobileWizard {
 	GtkTreeStore *country_store;
 	GtkTreeModelSort *country_sort;
 	guint32 country_focus_id;
+	char *country_search_query;
+	GHashTable *country_search_matches; /* NMACountryInfo -> NMAMobileProvider or NULL */
 
 	/* Providers page */
 	guint32 providers_idx;
@@ -80,6 +83,8 @@ struct NMAMobileWizard {
 	GtkTreeModelSort *providers_sort;
 	guint32 providers_focus_id;
 	GtkWidget *providers_view_radio;
+	char *providers_search_query;
+	char *providers_search_key;
 
 	GtkWidget *provider_unlisted_radio;
 	GtkWidget *provider_unlisted_entry;
@@ -586,21 +591,56 @@ providers_search_func (GtkTreeModel *model,
                        GtkTreeIter *iter,
                        gpointer search_data)
 {
+	NMAMobileWizard *self = search_data;
 	gboolean unmatched = TRUE;
-	char *provider = NULL;
+	NMAMobileProvider *provider = NULL;
 
 	if (!key)
 		return TRUE;
 
-	gtk_tree_model_get (model, iter, column, &provider, -1);
+	/* Called once per row; fold the query only when it changes */
+	if (g_strcmp0 (self->providers_search_query, key)) {
+		g_free (self->providers_search_query);
+		g_free (self->providers_search_key);
+		self->providers_search_query = g_strdup (key);
+		self->providers_search_key = nma_mobile_providers_search_key (key);
+	}
+
+	gtk_tree_model_get (model, iter, PROVIDER_COL_PROVIDER, &provider, -1);
 	if (!provider)
 		return TRUE;
 
-	unmatched = !!g_ascii_strncasecmp (provider, key, strlen (key));
-	g_free (provider);
+	unmatched = !g_str_has_prefix (nma_mobile_provider_get_search_key (provider),
+	                               self->providers_search_key);
+	nma_mobile_provider_unref (provider);
 	return unmatched;
 }
 
+static gint
+providers_sort_func (GtkTreeModel *model,
+                     GtkTreeIter *a,
+                     GtkTreeIter *b,
+                     gpointer user_data)
+{
+	NMAMobileProvider *a_provider = NULL, *b_provider = NULL;
+	gint ret;
+
+	gtk_tree_model_get (model, a, PROVIDER_COL_PROVIDER, &a_provider, -1);
+	gtk_tree_model_get (model, b, PROVIDER_COL_PROVIDER, &b_provider, -1);
+
+	if (a_provider && b_provider) {
+		ret = strcmp (nma_mobile_provider_get_collate_key (a_provider),
+		              nma_mobile_provider_get_collate_key (b_provider));
+	} else
+		ret = !!a_provider - !!b_provider;
+
+	if (a_provider)
+		nma_mobile_provider_unref (a_provider);
+	if (b_provider)
+		nma_mobile_provider_unref (b_provider);
+	return ret;
+}
+
 static NMAMobileProvider *
 get_selected_provider (NMAMobileWizard *self)
 {
@@ -720,6 +760,11 @@ providers_setup (NMAMobileWizard *self)
 	self->providers_store = gtk_tree_store_new (2, G_TYPE_STRING, NMA_TYPE_MOBILE_PROVIDER);
 
 	self->providers_sort = GTK_TREE_MODEL_SORT (gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (self->providers_store)));
+	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (self->providers_sort),
+	                                 PROVIDER_COL_NAME,
+	                                 providers_sort_func,
+	                                 NULL,
+	                                 NULL);
 	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->providers_sort),
 	                                      PROVIDER_COL_NAME, GTK_SORT_ASCENDING);
 
@@ -806,6 +851,9 @@ providers_prepare (NMAMobileWizard *self)
 {
 	GtkTreeSelection *selection;
 	NMACountryInfo *country_info;
+	NMAMobileProvider *search_match = NULL;
+	GtkTreeIter match_iter;
+	gboolean have_match = FALSE;
 	GSList *piter;
 
 	gtk_tree_store_clear (self->providers_store);
@@ -819,6 +867,10 @@ providers_prepare (NMAMobileWizard *self)
 	}
 	gtk_widget_set_sensitive (GTK_WIDGET (self->providers_view_radio), TRUE);
 
+	/* If the country was found through one of its providers, preselect it */
+	if (self->country_search_matches)
+		search_match = g_hash_table_lookup (self->country_search_matches, country_info);
+
 	for (piter = nma_country_info_get_providers (country_info);
 	     piter;
 	     piter = g_slist_next (piter)) {
@@ -841,14 +893,17 @@ providers_prepare (NMAMobileWizard *self)
 				continue;
 		}
 
-		gtk_tree_store_append (GTK_TREE_STORE (self->providers_store), &provider_iter, NULL);
-		gtk_tree_store_set (GTK_TREE_STORE (self->providers_store),
-		                    &provider_iter,
-		                    PROVIDER_COL_NAME,
-		                    nma_mobile_provider_get_name (provider),
-		                    PROVIDER_COL_PROVIDER,
-		                    provider,
-		                    -1);
+		gtk_tree_store_insert_with_values (GTK_TREE_STORE (self->providers_store),
+		                                   &provider_iter, NULL, -1,
+		                                   PROVIDER_COL_NAME,
+		                                   nma_mobile_provider_get_name (provider),
+		                                   PROVIDER_COL_PROVIDER,
+		                                   provider,
+		                                   -1);
+		if (provider == search_match) {
+			match_iter = provider_iter;
+			have_match = TRUE;
+		}
 	}
 
 	nma_country_info_unref (country_info);
@@ -864,7 +919,17 @@ providers_prepare (NMAMobileWizard *self)
 	 */
 	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (self->providers_view));
 	g_assert (selection);
-	if (!gtk_tree_selection_count_selected_rows (selection)) {
+	if (have_match) {
+		GtkTreeIter sort_iter;
+		GtkTreePath *match_path;
+
+		gtk_tree_model_sort_convert_child_iter_to_iter (self->providers_sort, &sort_iter, &match_iter);
+		match_path = gtk_tree_model_get_path (GTK_TREE_MODEL (self->providers_sort), &sort_iter);
+		gtk_tree_selection_select_path (selection, match_path);
+		gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (self->providers_view),
+		                              match_path, NULL, TRUE, 0, 0);
+		gtk_tree_path_free (match_path);
+	} else if (!gtk_tree_selection_count_selected_rows (selection)) {
 		GtkTreeIter first_iter;
 		GtkTreePath *first_path;
 
@@ -897,6 +962,46 @@ done:
 #define COUNTRIES_COL_NAME 0
 #define COUNTRIES_COL_INFO 1
 
+/* Countries match the query by name or, failing that, through one of their
+ * providers' names, APNs or MCC/MNC codes.  The result is computed from the
+ * database's prefix index once per query rather than once per row.
+ */
+static void
+country_search_update (NMAMobileWizard *self, const char *query)
+{
+	const NMAMobileSearchEntry *entries;
+	gboolean by_name = FALSE;
+	guint len, i;
+
+	if (!g_strcmp0 (self->country_search_query, query))
+		return;
+
+	g_free (self->country_search_query);
+	self->country_search_query = g_strdup (query);
+	g_hash_table_remove_all (self->country_search_matches);
+
+	if (!self->mobile_providers_database)
+		return;
+
+	entries = nma_mobile_providers_database_search (self->mobile_providers_database, query, &len);
+	for (i = 0; i < len; i++) {
+		if (!entries[i].provider) {
+			g_hash_table_insert (self->country_search_matches, entries[i].country_info, NULL);
+			by_name = TRUE;
+		}
+	}
+	if (by_name)
+		return;
+
+	for (i = 0; i < len; i++) {
+		if (!g_hash_table_contains (self->country_search_matches, entries[i].country_info)) {
+			g_hash_table_insert (self->country_search_matches,
+			                     entries[i].country_info,
+			                     entries[i].provider);
+		}
+	}
+}
+
 static gboolean
 country_search_func (GtkTreeModel *model,
                      gint column,
@@ -904,64 +1009,75 @@ country_search_func (GtkTreeModel *model,
                      GtkTreeIter *iter,
                      gpointer search_data)
 {
+	NMAMobileWizard *self = search_data;
 	gboolean unmatched = TRUE;
-	char *country = NULL;
+	NMACountryInfo *country_info = NULL;
 
 	if (!key)
 		return TRUE;
 
-	gtk_tree_model_get (model, iter, column, &country, -1);
-	if (!country)
+	country_search_update (self, key);
+
+	gtk_tree_model_get (model, iter, COUNTRIES_COL_INFO, &country_info, -1);
+	if (!country_info)
 		return TRUE;
 
-	unmatched = !!g_ascii_strncasecmp (country, key, strlen (key));
-	g_free (country);
+	unmatched = !g_hash_table_contains (self->country_search_matches, country_info);
+	nma_country_info_unref (country_info);
 	return unmatched;
 }
 
-static void
-add_one_country (gpointer key, gpointer value, gpointer user_data)
+static gint
+country_info_cmp (gconstpointer a, gconstpointer b)
 {
-	NMAMobileWizard *self = user_data;
-	NMACountryInfo *country_info = value;
-	GtkTreeIter country_iter;
-	GtkTreePath *country_path, *country_view_path;
-
-	g_assert (key);
-
-	gtk_tree_store_append (GTK_TREE_STORE (self->country_store), &country_iter, NULL);
-	gtk_tree_store_set (GTK_TREE_STORE (self->country_store),
-	                    &country_iter,
-	                    COUNTRIES_COL_NAME,
-	                    nma_country_info_get_country_name (country_info),
-	                    COUNTRIES_COL_INFO,
-	                    country_info,
-	                    -1);
-
-	/* If this country is the same country as the user's current locale,
-	 * select it by default.
-	 */
-	if (self->country != country_info)
-		return;
-
-	country_path = gtk_tree_model_get_path (GTK_TREE_MODEL (self->country_store), &country_iter);
-	if (!country_path)
-		return;
-
-	country_view_path = gtk_tree_model_sort_convert_child_path_to_path (self->country_sort, country_path);
-	if (country_view_path) {
-		GtkTreeSelection *selection;
+	NMACountryInfo *a_country_info = *(NMACountryInfo **) a;
+	NMACountryInfo *b_country_info = *(NMACountryInfo **) b;
 
-		gtk_tree_view_expand_row (GTK_TREE_VIEW (self->country_view), country_view_path, TRUE);
+	return strcmp (nma_country_info_get_collate_key (a_country_info),
+	               nma_country_info_get_collate_key (b_country_info));
+}
 
-		selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (self->country_view));
-		g_assert (selection);
-		gtk_tree_selection_select_path (selection, country_view_path);
-		gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (self->country_view),
-		                              country_view_path, NULL, TRUE, 0, 0);
-		gtk_tree_path_free (country_view_path);
+/* Appends all countries in display order; returns TRUE and sets @locale_iter
+ * if the country of the user's current locale is among them.
+ */
+static gboolean
+add_countries (NMAMobileWizard *self, GtkTreeIter *locale_iter)
+{
+	GHashTable *countries;
+	GHashTableIter iter;
+	GPtrArray *sorted;
+	gpointer value;
+	gboolean found = FALSE;
+	guint i;
+
+	countries = nma_mobile_providers_database_get_countries (self->mobile_providers_database);
+
+	sorted = g_ptr_array_sized_new (g_hash_table_size (countries));
+	g_hash_table_iter_init (&iter, countries);
+	while (g_hash_table_iter_next (&iter, NULL, &value))
+		g_ptr_array_add (sorted, value);
+	g_ptr_array_sort (sorted, country_info_cmp);
+
+	for (i = 0; i < sorted->len; i++) {
+		NMACountryInfo *country_info = g_ptr_array_index (sorted, i);
+		GtkTreeIter country_iter;
+
+		gtk_tree_store_insert_with_values (GTK_TREE_STORE (self->country_store),
+		                                   &country_iter, NULL, -1,
+		                                   COUNTRIES_COL_NAME,
+		                                   nma_country_info_get_country_name (country_info),
+		                                   COUNTRIES_COL_INFO,
+		                                   country_info,
+		                                   -1);
+
+		if (self->country == country_info) {
+			*locale_iter = country_iter;
+			found = TRUE;
+		}
 	}
-	gtk_tree_path_free (country_path);
+
+	g_ptr_array_free (sorted, TRUE);
+	return found;
 }
 
 NMACountryInfo *
@@ -1011,37 +1127,23 @@ country_sort_func (GtkTreeModel *model,
                    GtkTreeIter *b,
                    gpointer user_data)
 {
-	char *a_str = NULL, *b_str = NULL;
 	NMACountryInfo *a_country_info = NULL, *b_country_info = NULL;
-	gint ret = 0;
+	gint ret;
 
-	gtk_tree_model_get (model, a, COUNTRIES_COL_NAME, &a_str, COUNTRIES_COL_INFO, &a_country_info, -1);
-	gtk_tree_model_get (model, b, COUNTRIES_COL_NAME, &b_str, COUNTRIES_COL_INFO, &b_country_info, -1);
+	gtk_tree_model_get (model, a, COUNTRIES_COL_INFO, &a_country_info, -1);
+	gtk_tree_model_get (model, b, COUNTRIES_COL_INFO, &b_country_info, -1);
 
-	if (!a_country_info) {
-		ret = -1;
-		goto out;
-	} else if (!b_country_info) {
-		ret = 1;
-		goto out;
-	}
-
-	if (a_str && !b_str)
-		ret = -1;
-	else if (!a_str && b_str)
-		ret = 1;
-	else if (!a_str && !b_str)
-		ret = 0;
-	else
-		ret = g_utf8_collate (a_str, b_str);
+	/* "My country is not listed" goes first */
+	if (a_country_info && b_country_info) {
+		ret = strcmp (nma_country_info_get_collate_key (a_country_info),
+		              nma_country_info_get_collate_key (b_country_info));
+	} else
+		ret = !!a_country_info - !!b_country_info;
 
-out:
 	if (a_country_info)
 		nma_country_info_unref (a_country_info);
 	if (b_country_info)
 		nma_country_info_unref (b_country_info);
-	g_free (a_str);
-	g_free (b_str);
 	return ret;
 }
 
@@ -1052,7 +1154,8 @@ country_setup (NMAMobileWizard *self)
 	GtkCellRenderer *renderer;
 	GtkTreeViewColumn *column;
 	GtkTreeSelection *selection;
-	GtkTreeIter unlisted_iter;
+	GtkTreeIter unlisted_iter, locale_iter;
+	gboolean have_locale = FALSE;
 
 	vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 6);
 	gtk_container_set_border_width (GTK_CONTAINER (vbox), 12);
@@ -1061,8 +1164,29 @@ country_setup (NMAMobileWizard *self)
 	gtk_box_pack_start (GTK_BOX (vbox), label, FALSE, TRUE, 0);
 
 	self->country_store = gtk_tree_store_new (2, G_TYPE_STRING, NMA_TYPE_COUNTRY_INFO);
+	self->country_search_matches = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	/* Fill the store in display order before any sort model watches it, so
+	 * the rows get sorted once rather than on every insertion.
+	 */
+
+	/* My country is not listed... */
+	gtk_tree_store_append (GTK_TREE_STORE (self->country_store), &unlisted_iter, NULL);
+	gtk_tree_store_set (GTK_TREE_STORE (self->country_store), &unlisted_iter,
+	                    PROVIDER_COL_NAME, _("My country is not listed"),
+	                    PROVIDER_COL_PROVIDER, NULL,
+	                    -1);
+
+	/* Add the rest of the providers */
+	if (self->mobile_providers_database)
+		have_locale = add_countries (self, &locale_iter);
 
 	self->country_sort = GTK_TREE_MODEL_SORT (gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (self->country_store)));
+	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (self->country_sort),
+	                                 COUNTRIES_COL_NAME,
+	                                 country_sort_func,
+	                                 NULL,
+	                                 NULL);
 	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->country_sort),
 	                                      COUNTRIES_COL_NAME, GTK_SORT_ASCENDING);
 
@@ -1076,32 +1200,29 @@ country_setup (NMAMobileWizard *self)
 	gtk_tree_view_append_column (GTK_TREE_VIEW (self->country_view), column);
 	gtk_tree_view_column_set_clickable (column, TRUE);
 
-	/* My country is not listed... */
-	gtk_tree_store_append (GTK_TREE_STORE (self->country_store), &unlisted_iter, NULL);
-	gtk_tree_store_set (GTK_TREE_STORE (self->country_store), &unlisted_iter,
-	                    PROVIDER_COL_NAME, _("My country is not listed"),
-	                    PROVIDER_COL_PROVIDER, NULL,
-	                    -1);
-	gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (self->country_sort),
-	                                 COUNTRIES_COL_NAME,
-	                                 country_sort_func,
-	                                 NULL,
-	                                 NULL);
+	g_object_set (G_OBJECT (self->country_view), "enable-search", TRUE, NULL);
 
-	/* Add the rest of the providers */
-	if (self->mobile_providers_database) {
-		GHashTable *countries;
+	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (self->country_view));
+	g_assert (selection);
+
+	/* If this country is the same country as the user's current locale,
+	 * select it by default.
+	 */
+	if (have_locale) {
+		GtkTreeIter sort_iter;
+		GtkTreePath *locale_path;
 
-		countries = nma_mobile_providers_database_get_countries (self->mobile_providers_database);
-		g_hash_table_foreach (countries, add_one_country, self);
+		gtk_tree_model_sort_convert_child_iter_to_iter (self->country_sort, &sort_iter, &locale_iter);
+		locale_path = gtk_tree_model_get_path (GTK_TREE_MODEL (self->country_sort), &sort_iter);
+		gtk_tree_selection_select_path (selection, locale_path);
+		gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (self->country_view),
+		                              locale_path, NULL, TRUE, 0, 0);
+		gtk_tree_path_free (locale_path);
 	}
-	g_object_set (G_OBJECT (self->country_view), "enable-search", TRUE, NULL);
 
 	/* If no row has focus yet, focus the first row so that the user can start
 	 * incremental search without clicking.
 	 */
-	selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (self->country_view));
-	g_assert (selection);
 	if (!gtk_tree_selection_count_selected_rows (selection)) {
 		GtkTreeIter first_iter;
 		GtkTreePath *first_path;
@@ -1657,6 +1778,11 @@ nma_mobile_wizard_destroy (NMAMobileWizard *self)
 	g_return_if_fail (self != NULL);
 
 	g_free (self->dev_desc);
+	g_free (self->country_search_query);
+	g_free (self->providers_search_query);
+	g_free (self->providers_search_key);
+	if (self->country_search_matches)
+		g_hash_table_destroy (self->country_search_matches);
 
 	if (self->assistant) {
 		gtk_widget_hide (self->assistant);
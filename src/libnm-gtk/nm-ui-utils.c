@@ -375,52 +375,168 @@ get_device_generic_type_name_with_iface (NMDevice *device)
 	}
 }
 
-#define BUS_TAG "nm-ui-utils.c:get_bus_name"
+/* Process-wide cache of udev metadata, so that disambiguating names
+ * doesn't set up a udev client and query it on every call.  Entries are
+ * keyed by sysfs path where the device has one, and dropped when udev
+ * reports an event for them; an interface rename drops everything.
+ */
+typedef struct {
+	char *bus;  /* display name of the bus, or NULL */
+} UdevInfo;
 
-static const char *
-get_bus_name (GUdevClient *uclient, NMDevice *device)
+static GUdevClient *udev_client;
+static GHashTable *udev_cache;  /* sysfs path (or ifname) -> UdevInfo */
+static guint udev_generation;   /* bumped on every uevent */
+
+static void
+udev_info_free (UdevInfo *info)
+{
+	g_free (info->bus);
+	g_slice_free (UdevInfo, info);
+}
+
+static void
+udev_uevent_cb (GUdevClient *client,
+                const char *action,
+                GUdevDevice *udevice,
+                gpointer user_data)
 {
-	GUdevDevice *udevice;
-	const char *ifname, *bus;
-	char *display_bus;
+	const char *path = g_udev_device_get_sysfs_path (udevice);
+	const char *name = g_udev_device_get_name (udevice);
 
-	bus = g_object_get_data (G_OBJECT (device), BUS_TAG);
-	if (bus) {
-		if (*bus)
-			return bus;
-		else
-			return NULL;
+	if (!g_strcmp0 (action, "move"))
+		g_hash_table_remove_all (udev_cache);
+	else {
+		if (path)
+			g_hash_table_remove (udev_cache, path);
+		if (name)
+			g_hash_table_remove (udev_cache, name);
 	}
+	udev_generation++;
+}
+
+static void
+udev_cache_init (void)
+{
+	static const char *subsys[3] = { "net", "tty", NULL };
+
+	if (udev_client)
+		return;
+
+	udev_client = g_udev_client_new (subsys);
+	udev_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                    g_free, (GDestroyNotify) udev_info_free);
+	g_signal_connect (udev_client, "uevent", G_CALLBACK (udev_uevent_cb), NULL);
+}
+
+static const char *
+get_bus_name (NMDevice *device)
+{
+	GUdevDevice *udevice = NULL;
+	const char *ifname, *udi, *key, *bus;
+	UdevInfo *info;
 
 	ifname = nm_device_get_iface (device);
 	if (!ifname)
 		return NULL;
 
-	udevice = g_udev_client_query_by_subsystem_and_name (uclient, "net", ifname);
+	/* Kernel devices have their sysfs path as UDI; modems and the like
+	 * don't, so fall back to the interface name for those.
+	 */
+	udi = nm_device_get_udi (device);
+	key = udi && g_str_has_prefix (udi, "/sys/") ? udi : ifname;
+
+	udev_cache_init ();
+	info = g_hash_table_lookup (udev_cache, key);
+	if (info)
+		return info->bus;
+
+	info = g_slice_new0 (UdevInfo);
+	if (key == udi)
+		udevice = g_udev_client_query_by_sysfs_path (udev_client, udi);
 	if (!udevice)
-		udevice = g_udev_client_query_by_subsystem_and_name (uclient, "tty", ifname);
+		udevice = g_udev_client_query_by_subsystem_and_name (udev_client, "net", ifname);
 	if (!udevice)
-		return NULL;
+		udevice = g_udev_client_query_by_subsystem_and_name (udev_client, "tty", ifname);
+	if (udevice) {
+		bus = g_udev_device_get_property (udevice, "ID_BUS");
+		if (!g_strcmp0 (bus, "pci"))
+			info->bus = g_strdup (_("PCI"));
+		else if (!g_strcmp0 (bus, "usb"))
+			info->bus = g_strdup (_("USB"));
+		g_object_unref (udevice);
+	}
 
-	bus = g_udev_device_get_property (udevice, "ID_BUS");
-	if (!g_strcmp0 (bus, "pci"))
-		display_bus = g_strdup (_("PCI"));
-	else if (!g_strcmp0 (bus, "usb"))
-		display_bus = g_strdup (_("USB"));
-	else {
-		/* Use "" instead of NULL so we can tell later that we've
-		 * already tried.
-		 */
-		display_bus = g_strdup ("");
+	g_hash_table_insert (udev_cache, g_strdup (key), info);
+	return info->bus;
+}
+
+/* The names from the last call, reused while the same devices are asked
+ * about and udev hasn't reported any change.
+ */
+static struct {
+	GPtrArray *devices;  /* weak references */
+	char **names;
+	guint generation;
+} last_names;
+
+static void last_names_device_gone (gpointer data, GObject *where_the_object_was);
+
+static void
+last_names_clear (void)
+{
+	int i;
+
+	if (!last_names.devices)
+		return;
+
+	for (i = 0; i < last_names.devices->len; i++) {
+		g_object_weak_unref (last_names.devices->pdata[i],
+		                     last_names_device_gone, NULL);
 	}
+	g_clear_pointer (&last_names.devices, g_ptr_array_unref);
+	g_clear_pointer (&last_names.names, g_strfreev);
+}
 
-	g_object_set_data_full (G_OBJECT (device),
-	                        BUS_TAG, display_bus,
-	                        (GDestroyNotify) g_free);
-	if (*display_bus)
-		return display_bus;
-	else
-		return NULL;
+static void
+last_names_device_gone (gpointer data, GObject *where_the_object_was)
+{
+	/* Don't weak_unref the device that is going away */
+	g_ptr_array_remove (last_names.devices, where_the_object_was);
+	last_names_clear ();
+}
+
+static gboolean
+last_names_match (NMDevice **devices, int num_devices)
+{
+	int i;
+
+	if (   !last_names.devices
+	    || last_names.devices->len != num_devices
+	    || last_names.generation != udev_generation)
+		return FALSE;
+
+	for (i = 0; i < num_devices; i++) {
+		if (last_names.devices->pdata[i] != devices[i])
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static void
+last_names_set (NMDevice **devices, int num_devices, char **names)
+{
+	int i;
+
+	last_names_clear ();
+
+	last_names.devices = g_ptr_array_sized_new (num_devices);
+	for (i = 0; i < num_devices; i++) {
+		g_ptr_array_add (last_names.devices, devices[i]);
+		g_object_weak_ref (G_OBJECT (devices[i]), last_names_device_gone, NULL);
+	}
+	last_names.names = g_strdupv (names);
+	last_names.generation = udev_generation;
 }
 
 /**
@@ -437,12 +553,14 @@ char **
 nma_utils_disambiguate_device_names (NMDevice **devices,
                                      int        num_devices)
 {
-	static const char *subsys[3] = { "net", "tty", NULL };
-	GUdevClient *uclient;
 	char **names;
 	gboolean *duplicates;
 	int i;
 
+	/* Callers asking again about the same devices get a copy */
+	if (last_names_match (devices, num_devices))
+		return g_strdupv (last_names.names);
+
 	names = g_new (char *, num_devices + 1);
 	duplicates = g_new (gboolean, num_devices);
 
@@ -465,10 +583,9 @@ nma_utils_disambiguate_device_names (NMDevice **devices,
 		goto done;
 
 	/* Try prefixing bus name (eg, "PCI Ethernet" vs "USB Ethernet") */
-	uclient = g_udev_client_new (subsys);
 	for (i = 0; i < num_devices; i++) {
 		if (duplicates[i]) {
-			const char *bus = get_bus_name (uclient, devices[i]);
+			const char *bus = get_bus_name (devices[i]);
 			char *name;
 
 			if (!bus)
@@ -487,7 +604,6 @@ nma_utils_disambiguate_device_names (NMDevice **devices,
 			g_free (name);
 		}
 	}
-	g_object_unref (uclient);
 	if (!find_duplicates (names, duplicates, num_devices))
 		goto done;
 
@@ -550,6 +666,7 @@ nma_utils_disambiguate_device_names (NMDevice **devices,
  done:
 	g_free (duplicates);
 	names[num_devices] = NULL;
+	last_names_set (devices, num_devices, names);
 	return names;
 }
 
@@ -974,6 +974,12 @@ security_combo_init (NMAWifiDialog *self, gboolean secrets_only)
 
 		ws_wpa_psk = ws_wpa_psk_new (priv->connection, secrets_only);
 		if (ws_wpa_psk) {
+			if (!priv->connection && priv->ap) {
+				const GByteArray *ssid = nm_access_point_get_ssid (priv->ap);
+
+				if (ssid)
+					ws_wpa_psk_set_ssid (ws_wpa_psk, ssid->data, ssid->len);
+			}
 			add_security_item (self, WIRELESS_SECURITY (ws_wpa_psk), sec_model,
 			                   &iter, _("WPA & WPA2 Personal"));
 			if ((active < 0) && ((default_type == NMU_SEC_WPA_PSK) || (default_type == NMU_SEC_WPA2_PSK)))
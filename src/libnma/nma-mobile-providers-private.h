@@ -0,0 +1,49 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ * Copyright (C) 2016 Red Hat, Inc.
+ */
+
+/* Internal to the library; neither installed nor exported. */
+
+#ifndef NMA_MOBILE_PROVIDERS_PRIVATE_H
+#define NMA_MOBILE_PROVIDERS_PRIVATE_H
+
+#include "nma-mobile-providers.h"
+
+/* One entry of the database's sorted prefix index.  @provider is NULL
+ * when @key was derived from the country name itself; otherwise @key is
+ * the provider's name, one of its APNs or one of its MCC/MNC codes.
+ */
+typedef struct {
+	char *key;
+	NMACountryInfo *country_info;
+	NMAMobileProvider *provider;
+} NMAMobileSearchEntry;
+
+char *nma_mobile_providers_search_key (const char *str);
+
+const char *nma_country_info_get_collate_key   (NMACountryInfo *country_info);
+const char *nma_country_info_get_search_key    (NMACountryInfo *country_info);
+const char *nma_mobile_provider_get_collate_key (NMAMobileProvider *provider);
+const char *nma_mobile_provider_get_search_key  (NMAMobileProvider *provider);
+
+const NMAMobileSearchEntry *nma_mobile_providers_database_search (NMAMobileProvidersDatabase *self,
+                                                                  const char *query,
+                                                                  guint *out_len);
+
+#endif /* NMA_MOBILE_PROVIDERS_PRIVATE_H */
@@ -31,6 +31,7 @@
 #include <glib/gi18n-lib.h>
 
 #include "nma-mobile-providers.h"
+#include "nma-mobile-providers-private.h"
 
 #ifndef MOBILE_BROADBAND_PROVIDER_INFO
 #define MOBILE_BROADBAND_PROVIDER_INFO DATADIR"/mobile-broadband-provider-info/serviceproviders.xml"
@@ -221,6 +222,10 @@ struct _NMAMobileProvider {
 
 	GPtrArray *mcc_mnc;  /* GPtrArray of strings */
 	GArray *cdma_sid; /* GArray of guint32 */
+
+	/* Filled in once the database is loaded */
+	char *collate_key;
+	char *search_key;
 };
 
 static NMAMobileProvider *
@@ -264,6 +269,9 @@ nma_mobile_provider_unref (NMAMobileProvider *provider)
 		if (provider->cdma_sid)
 			g_array_unref (provider->cdma_sid);
 
+		g_free (provider->collate_key);
+		g_free (provider->search_key);
+
 		g_slice_free (NMAMobileProvider, provider);
 	}
 }
@@ -326,6 +334,26 @@ nma_mobile_provider_get_cdma_sid (NMAMobileProvider *provider)
 	return provider->cdma_sid ? (const guint32 *)provider->cdma_sid->data : NULL;
 }
 
+const char *
+nma_mobile_provider_get_collate_key (NMAMobileProvider *provider)
+{
+	g_return_val_if_fail (provider != NULL, NULL);
+
+	if (!provider->collate_key)
+		provider->collate_key = g_utf8_collate_key (provider->name ? provider->name : "", -1);
+	return provider->collate_key;
+}
+
+const char *
+nma_mobile_provider_get_search_key (NMAMobileProvider *provider)
+{
+	g_return_val_if_fail (provider != NULL, NULL);
+
+	if (!provider->search_key)
+		provider->search_key = nma_mobile_providers_search_key (provider->name);
+	return provider->search_key;
+}
+
 /******************************************************************************/
 /* Country Info type */
 
@@ -340,6 +368,10 @@ struct _NMACountryInfo {
 	char *country_code;
 	char *country_name;
 	GSList *providers;
+
+	/* Filled in once the database is loaded */
+	char *collate_key;
+	char *search_key;
 };
 
 static NMACountryInfo *
@@ -372,6 +404,8 @@ nma_country_info_unref (NMACountryInfo *country_info)
 	if (g_atomic_int_dec_and_test (&country_info->refs)) {
 		g_free (country_info->country_code);
 		g_free (country_info->country_name);
+		g_free (country_info->collate_key);
+		g_free (country_info->search_key);
 		g_slist_free_full (country_info->providers,
 		                   (GDestroyNotify) nma_mobile_provider_unref);
 		g_slice_free (NMACountryInfo, country_info);
@@ -418,6 +452,28 @@ nma_country_info_get_providers (NMACountryInfo *country_info)
 	return country_info->providers;
 }
 
+const char *
+nma_country_info_get_collate_key (NMACountryInfo *country_info)
+{
+	g_return_val_if_fail (country_info != NULL, NULL);
+
+	if (!country_info->collate_key) {
+		country_info->collate_key = g_utf8_collate_key (country_info->country_name
+		                                                ? country_info->country_name : "", -1);
+	}
+	return country_info->collate_key;
+}
+
+const char *
+nma_country_info_get_search_key (NMACountryInfo *country_info)
+{
+	g_return_val_if_fail (country_info != NULL, NULL);
+
+	if (!country_info->search_key)
+		country_info->search_key = nma_mobile_providers_search_key (country_info->country_name);
+	return country_info->search_key;
+}
+
 /******************************************************************************/
 /* XML Parser for iso_3166.xml */
 
@@ -1012,6 +1068,144 @@ mobile_providers_parse_sync (const gchar *country_codes,
 	return countries;
 }
 
+/******************************************************************************/
+/* Search index */
+
+/* Case-folded, decomposed and stripped of combining marks, so that e.g.
+ * "cote" finds "Côte d'Ivoire" and "telefonica" finds "Telefónica".
+ */
+char *
+nma_mobile_providers_search_key (const char *str)
+{
+	char *folded, *decomposed;
+	const char *p;
+	GString *key;
+
+	if (!str || !g_utf8_validate (str, -1, NULL))
+		return g_strdup ("");
+
+	folded = g_utf8_casefold (str, -1);
+	decomposed = g_utf8_normalize (folded, -1, G_NORMALIZE_NFD);
+	g_free (folded);
+
+	key = g_string_sized_new (strlen (decomposed));
+	for (p = decomposed; *p; p = g_utf8_next_char (p)) {
+		gunichar c = g_utf8_get_char (p);
+
+		if (!g_unichar_ismark (c))
+			g_string_append_unichar (key, c);
+	}
+	g_free (decomposed);
+
+	return g_string_free (key, FALSE);
+}
+
+static void
+search_index_add (GArray *index,
+                  char *key,
+                  NMACountryInfo *country_info,
+                  NMAMobileProvider *provider)
+{
+	NMAMobileSearchEntry entry;
+
+	if (!key[0]) {
+		g_free (key);
+		return;
+	}
+
+	entry.key = key;
+	entry.country_info = country_info;
+	entry.provider = provider;
+	g_array_append_val (index, entry);
+}
+
+static gint
+search_entry_cmp (gconstpointer a, gconstpointer b)
+{
+	const NMAMobileSearchEntry *entry_a = a;
+	const NMAMobileSearchEntry *entry_b = b;
+
+	return strcmp (entry_a->key, entry_b->key);
+}
+
+/* Returns an array of NMAMobileSearchEntry sorted by key.  Built on the
+ * first search rather than at load time, so that users of the database
+ * that never search don't pay for folding every name; the sort keys are
+ * likewise computed by their getters on first use.
+ */
+static GArray *
+search_index_build (GHashTable *countries)
+{
+	GArray *index;
+	GHashTableIter iter;
+	gpointer value;
+	GSList *piter, *miter;
+
+	index = g_array_sized_new (FALSE, FALSE, sizeof (NMAMobileSearchEntry),
+	                           g_hash_table_size (countries) * 4);
+
+	g_hash_table_iter_init (&iter, countries);
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		NMACountryInfo *country_info = value;
+
+		search_index_add (index, g_strdup (nma_country_info_get_search_key (country_info)),
+		                  country_info, NULL);
+
+		for (piter = country_info->providers; piter; piter = g_slist_next (piter)) {
+			NMAMobileProvider *provider = piter->data;
+			guint i;
+
+			search_index_add (index, g_strdup (nma_mobile_provider_get_search_key (provider)),
+			                  country_info, provider);
+
+			for (miter = provider->methods; miter; miter = g_slist_next (miter)) {
+				NMAMobileAccessMethod *method = miter->data;
+
+				if (method->apn)
+					search_index_add (index, nma_mobile_providers_search_key (method->apn), country_info, provider);
+			}
+
+			for (i = 0; provider->mcc_mnc && g_ptr_array_index (provider->mcc_mnc, i); i++) {
+				search_index_add (index, g_strdup (g_ptr_array_index (provider->mcc_mnc, i)),
+				                  country_info, provider);
+			}
+		}
+	}
+
+	g_array_sort (index, search_entry_cmp);
+	return index;
+}
+
+static void
+search_index_free (GArray *index)
+{
+	guint i;
+
+	for (i = 0; i < index->len; i++)
+		g_free (g_array_index (index, NMAMobileSearchEntry, i).key);
+	g_array_free (index, TRUE);
+}
+
+/* First entry whose key, truncated to @len bytes, compares >= @query
+ * (or > @query if @past is set).
+ */
+static guint
+search_index_bound (GArray *index, const char *query, gsize len, gboolean past)
+{
+	guint lo = 0, hi = index->len;
+
+	while (lo < hi) {
+		guint mid = lo + (hi - lo) / 2;
+		int cmp = strncmp (g_array_index (index, NMAMobileSearchEntry, mid).key, query, len);
+
+		if (cmp < 0 || (past && cmp == 0))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
 /******************************************************************************/
 /* Dump to stdout contents */
 
@@ -1127,6 +1321,9 @@ struct _NMAMobileProvidersDatabasePrivate {
 
 	/* The HT with country code as key and NMACountryInfo as value. */
 	GHashTable *countries;
+
+	/* NMAMobileSearchEntry array sorted by key */
+	GArray *search_index;
 };
 
 /**********************************/
@@ -1330,6 +1527,47 @@ nma_mobile_providers_database_lookup_cdma_sid (NMAMobileProvidersDatabase *self,
 	return NULL;
 }
 
+/* Returns the run of index entries whose key starts with the search key
+ * of @query; the entries are owned by the database.
+ */
+const NMAMobileSearchEntry *
+nma_mobile_providers_database_search (NMAMobileProvidersDatabase *self,
+                                      const char *query,
+                                      guint *out_len)
+{
+	GArray *index;
+	char *key;
+	gsize len;
+	guint first, last;
+
+	g_return_val_if_fail (NMA_IS_MOBILE_PROVIDERS_DATABASE (self), NULL);
+	g_return_val_if_fail (out_len != NULL, NULL);
+	/* Warn if the object hasn't been initialized */
+	g_return_val_if_fail (self->priv->countries != NULL, NULL);
+
+	*out_len = 0;
+	if (!self->priv->search_index)
+		self->priv->search_index = search_index_build (self->priv->countries);
+	index = self->priv->search_index;
+
+	key = nma_mobile_providers_search_key (query);
+	len = strlen (key);
+	if (!len) {
+		g_free (key);
+		return NULL;
+	}
+
+	first = search_index_bound (index, key, len, FALSE);
+	last = search_index_bound (index, key, len, TRUE);
+	g_free (key);
+
+	if (first == last)
+		return NULL;
+
+	*out_len = last - first;
+	return &g_array_index (index, NMAMobileSearchEntry, first);
+}
+
 /**********************************/
 
 static gboolean
@@ -1488,6 +1726,8 @@ finalize (GObject *object)
 	g_free (self->priv->country_codes_path);
 	g_free (self->priv->service_providers_path);
 
+	if (self->priv->search_index)
+		search_index_free (self->priv->search_index);
 	if (self->priv->countries)
 		g_hash_table_unref (self->priv->countries);
 
@@ -33,6 +33,7 @@
 #include "nma-wifi-dialog.h"
 #include "wireless-security.h"
 #include "eap-method.h"
+#include "wifi-profile-index.h"
 
 G_DEFINE_TYPE (NMAWifiDialog, nma_wifi_dialog, GTK_TYPE_DIALOG)
 
@@ -450,7 +451,8 @@ connection_combo_init (NMAWifiDialog *self, NMConnection *connection)
 		                    C_CON_COLUMN, connection, -1);
 	} else {
 		GSList *to_add = NULL, *iter;
-		const GPtrArray *connections;
+		GPtrArray *connections;
+		const char *hw_addr;
 		int i;
 
 		gtk_list_store_append (store, &tree_iter);
@@ -461,25 +463,21 @@ connection_combo_init (NMAWifiDialog *self, NMConnection *connection)
 		gtk_list_store_append (store, &tree_iter);
 		gtk_list_store_set (store, &tree_iter, C_SEP_COLUMN, TRUE, -1);
 
-		connections = nm_client_get_connections (priv->client);
+		/* Only Wi-Fi connections that apply to the selected device */
+		hw_addr = nm_device_wifi_get_hw_address (NM_DEVICE_WIFI (priv->device));
+		connections = wifi_profile_index_get_for_device (priv->client, hw_addr);
 		for (i = 0; i < connections->len; i++) {
 			NMConnection *candidate = NM_CONNECTION (connections->pdata[i]);
 			NMSettingWireless *s_wireless;
 			const char *connection_type;
 			const char *mode;
-			const char *setting_mac, *hw_addr;
 
 			s_con = nm_connection_get_setting_connection (candidate);
 			connection_type = s_con ? nm_setting_connection_get_connection_type (s_con) : NULL;
-			if (!connection_type)
-				continue;
-
-			if (strcmp (connection_type, NM_SETTING_WIRELESS_SETTING_NAME))
+			if (g_strcmp0 (connection_type, NM_SETTING_WIRELESS_SETTING_NAME))
 				continue;
 
 			s_wireless = nm_connection_get_setting_wireless (candidate);
-			if (!s_wireless)
-				continue;
 
 			/* If creating a new Ad-Hoc network, only show shared network connections */
 			if (priv->operation == OP_CREATE_ADHOC) {
@@ -499,16 +497,9 @@ connection_combo_init (NMAWifiDialog *self, NMConnection *connection)
 					continue;
 			}
 
-			/* Ignore connections that don't apply to the selected device */
-			setting_mac = nm_setting_wireless_get_mac_address (s_wireless);
-			hw_addr = nm_device_wifi_get_hw_address (NM_DEVICE_WIFI (priv->device));
-			if (   setting_mac
-			    && hw_addr 
-			    && !nm_utils_hwaddr_matches (setting_mac, -1, hw_addr, -1))
-				continue;
-
-			to_add = g_slist_append (to_add, candidate);
+			to_add = g_slist_prepend (to_add, candidate);
 		}
+		g_ptr_array_unref (connections);
 
 		/* Alphabetize the list then add the connections */
 		to_add = g_slist_sort (to_add, (GCompareFunc) alphabetize_connections);
@@ -958,6 +949,12 @@ security_combo_init (NMAWifiDialog *self, gboolean secrets_only)
 
 		ws_wpa_psk = ws_wpa_psk_new (priv->connection, secrets_only);
 		if (ws_wpa_psk) {
+			if (!priv->connection && priv->ap) {
+				GBytes *ssid = nm_access_point_get_ssid (priv->ap);
+
+				if (ssid)
+					ws_wpa_psk_set_ssid (ws_wpa_psk, g_bytes_get_data (ssid, NULL), g_bytes_get_size (ssid));
+			}
 			add_security_item (self, WIRELESS_SECURITY (ws_wpa_psk), sec_model,
 			                   &iter, _("WPA & WPA2 Personal"));
 			if ((active < 0) && ((default_type == NMU_SEC_WPA_PSK) || (default_type == NMU_SEC_WPA2_PSK)))
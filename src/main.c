@@ -35,6 +35,8 @@
 #include <glib/gi18n.h>
 
 #include "applet.h"
+#include "applet-stats.h"
+#include "stall-detector.h"
 
 static GMainLoop *loop = NULL;
 gboolean shell_debug = FALSE;
@@ -75,6 +77,9 @@ int main (int argc, char *argv[])
 	gtk_init (&argc, &argv);
 	textdomain (GETTEXT_PACKAGE);
 
+	stall_detector_init ("nm-applet");
+	stall_detector_set_stall_func (applet_stats_record_stall);
+
 	loop = g_main_loop_new (NULL, FALSE);
 
 	applet = nm_applet_new ();
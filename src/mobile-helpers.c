@@ -27,9 +27,26 @@
 #include <libsecret/secret.h>
 
 #include "utils.h"
+#include "stall-detector.h"
 #include "mobile-helpers.h"
 #include "applet-dialogs.h"
 
+/* Upper bound on the number of composited status icons kept around; the
+ * set of distinct combinations is small, so this is only a safety net.
+ */
+#define MB_ICON_CACHE_MAX 64
+
+static void
+composite_layer (GdkPixbuf *src, GdkPixbuf *dest)
+{
+	gdk_pixbuf_composite (src, dest,
+	                      0, 0,
+	                      gdk_pixbuf_get_width (src),
+	                      gdk_pixbuf_get_height (src),
+	                      0, 0, 1.0, 1.0,
+	                      GDK_INTERP_BILINEAR, 255);
+}
+
 GdkPixbuf *
 mobile_helper_get_status_pixbuf (guint32 quality,
                                  gboolean quality_valid,
@@ -38,12 +55,35 @@ mobile_helper_get_status_pixbuf (guint32 quality,
                                  NMApplet *applet)
 {
 	GdkPixbuf *pixbuf, *qual_pixbuf, *wwan_pixbuf, *tmp;
-
-	wwan_pixbuf = nma_icon_check_and_load ("nm-wwan-tower", applet);
+	const char *qual_icon_name;
+	const char *overlay_icon_name;
+	char key[128];
 
 	if (!quality_valid)
 		quality = 0;
-	qual_pixbuf = nma_icon_check_and_load (mobile_helper_get_quality_icon_name (quality), applet);
+	qual_icon_name = mobile_helper_get_quality_icon_name (quality);
+
+	/* Only try to add the access tech info icon if we get a valid
+	 * access tech reported. */
+	if (state == MB_STATE_ROAMING)
+		overlay_icon_name = "nm-mb-roam";
+	else
+		overlay_icon_name = mobile_helper_get_tech_icon_name (access_tech);
+
+	/* The composited icon only depends on the quality bucket, the
+	 * roaming/technology overlay and the icon size, so reuse a previously
+	 * built one if we have it.  The cache is flushed by nma_icons_reload().
+	 */
+	g_snprintf (key, sizeof (key), "%s/%s/%d",
+	            qual_icon_name,
+	            overlay_icon_name ? overlay_icon_name : "",
+	            applet->icon_size);
+	pixbuf = g_hash_table_lookup (applet->mb_icon_cache, key);
+	if (pixbuf)
+		return g_object_ref (pixbuf);
+
+	wwan_pixbuf = nma_icon_check_and_load ("nm-wwan-tower", applet);
+	qual_pixbuf = nma_icon_check_and_load (qual_icon_name, applet);
 
 	pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
 	                         TRUE,
@@ -53,47 +93,22 @@ mobile_helper_get_status_pixbuf (guint32 quality,
 	gdk_pixbuf_fill (pixbuf, 0xFFFFFF00);
 
 	/* Composite the tower icon into the final icon at the bottom layer */
-	gdk_pixbuf_composite (wwan_pixbuf, pixbuf,
-	                      0, 0,
-	                      gdk_pixbuf_get_width (wwan_pixbuf),
-						  gdk_pixbuf_get_height (wwan_pixbuf),
-						  0, 0, 1.0, 1.0,
-						  GDK_INTERP_BILINEAR, 255);
+	composite_layer (wwan_pixbuf, pixbuf);
 
 	/* Composite the signal quality onto the icon on top of the WWAN tower */
-	gdk_pixbuf_composite (qual_pixbuf, pixbuf,
-	                      0, 0,
-	                      gdk_pixbuf_get_width (qual_pixbuf),
-						  gdk_pixbuf_get_height (qual_pixbuf),
-						  0, 0, 1.0, 1.0,
-						  GDK_INTERP_BILINEAR, 255);
+	composite_layer (qual_pixbuf, pixbuf);
 
 	/* And finally the roaming or technology icon */
-	if (state == MB_STATE_ROAMING) {
-		tmp = nma_icon_check_and_load ("nm-mb-roam", applet);
-		gdk_pixbuf_composite (tmp, pixbuf, 0, 0,
-		                      gdk_pixbuf_get_width (tmp),
-							  gdk_pixbuf_get_height (tmp),
-							  0, 0, 1.0, 1.0,
-							  GDK_INTERP_BILINEAR, 255);
-	} else {
-		const gchar *tech_icon_name;
-
-		/* Only try to add the access tech info icon if we get a valid
-		 * access tech reported. */
-		tech_icon_name = mobile_helper_get_tech_icon_name (access_tech);
-		if (tech_icon_name) {
-			tmp = nma_icon_check_and_load (tech_icon_name, applet);
-			if (tmp) {
-				gdk_pixbuf_composite (tmp, pixbuf, 0, 0,
-				                      gdk_pixbuf_get_width (tmp),
-				                      gdk_pixbuf_get_height (tmp),
-				                      0, 0, 1.0, 1.0,
-				                      GDK_INTERP_BILINEAR, 255);
-			}
-		}
+	if (overlay_icon_name) {
+		tmp = nma_icon_check_and_load (overlay_icon_name, applet);
+		if (tmp)
+			composite_layer (tmp, pixbuf);
 	}
 
+	if (g_hash_table_size (applet->mb_icon_cache) >= MB_ICON_CACHE_MAX)
+		g_hash_table_remove_all (applet->mb_icon_cache);
+	g_hash_table_insert (applet->mb_icon_cache, g_strdup (key), g_object_ref (pixbuf));
+
 	/* 'pixbuf' will be freed by the caller */
 	return pixbuf;
 }
@@ -660,7 +675,9 @@ mobile_helper_parse_3gpp_operator_name (NMAMobileProvidersDatabase **mpd, /* I/O
 	if (*mpd == NULL) {
 		GError *error = NULL;
 
+		stall_trace_begin ("nma_mobile_providers_database_new_sync");
 		*mpd = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
+		stall_trace_end ();
 		if (*mpd == NULL) {
 			g_warning ("Couldn't read database: %s", error->message);
 			g_error_free (error);
@@ -686,7 +703,9 @@ mobile_helper_parse_3gpp2_operator_name (NMAMobileProvidersDatabase **mpd, /* I/
 	if (*mpd == NULL) {
 		GError *error = NULL;
 
+		stall_trace_begin ("nma_mobile_providers_database_new_sync");
 		*mpd = nma_mobile_providers_database_new_sync (NULL, NULL, NULL, &error);
+		stall_trace_end ();
 		if (*mpd == NULL) {
 			g_warning ("Couldn't read database: %s", error->message);
 			g_error_free (error);
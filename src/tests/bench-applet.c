@@ -0,0 +1,561 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+/*
+ * Headless benchmark for the applet's menu and icon paths.
+ *
+ * A private bus is started with GTestDBus and used as both the session and
+ * the system bus; python-dbusmock's NetworkManager template is run on it
+ * and populated with the requested number of devices, access points, saved
+ * connections and VPNs.  A real NMApplet is then created against it and
+ * the menu and icon paths are timed.
+ *
+ * applet.c is included directly so its static functions can be driven.
+ *
+ * The default scenario is small enough for "make check"; "make bench" runs
+ * the large sizes.  Exits with 77 (skipped) when there is no display, no
+ * dbus-daemon to run the private bus with, or dbusmock is missing.
+ */
+
+#include "applet.c"
+
+#include <stdio.h>
+
+gboolean shell_debug = FALSE;
+gboolean with_agent = FALSE;
+
+#define MOCK_BUS_NAME  "org.freedesktop.NetworkManager"
+#define MOCK_PATH      "/org/freedesktop/NetworkManager"
+#define MOCK_IFACE     "org.freedesktop.NetworkManager.Mock"
+#define SETTINGS_PATH  "/org/freedesktop/NetworkManager/Settings"
+#define SETTINGS_IFACE "org.freedesktop.NetworkManager.Settings"
+
+#define EXIT_SKIP 77
+
+static int n_devices = 2;
+static int n_aps = 10;
+static int n_connections = 5;
+static int n_vpns = 2;
+static int n_iterations = 10;
+
+static GOptionEntry entries[] = {
+	{ "devices", 'd', 0, G_OPTION_ARG_INT, &n_devices, "Number of Ethernet devices", "N" },
+	{ "aps", 'a', 0, G_OPTION_ARG_INT, &n_aps, "Number of Wi-Fi access points", "N" },
+	{ "connections", 'c', 0, G_OPTION_ARG_INT, &n_connections, "Number of saved connections", "N" },
+	{ "vpns", 'v', 0, G_OPTION_ARG_INT, &n_vpns, "Number of VPN connections", "N" },
+	{ "iterations", 'i', 0, G_OPTION_ARG_INT, &n_iterations, "Iterations per path", "N" },
+	{ NULL }
+};
+
+/*****************************************************************************/
+
+/* Count allocations by interposing the allocator.  Other threads (the GDBus
+ * worker) are counted too, so the numbers are an upper bound.
+ */
+#ifdef __GLIBC__
+#define HAVE_ALLOC_COUNT 1
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static guint64 n_allocs;
+
+void *
+malloc (size_t size)
+{
+	__atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	__atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	__atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+	return __libc_realloc (ptr, size);
+}
+
+static guint64
+alloc_count (void)
+{
+	return __atomic_load_n (&n_allocs, __ATOMIC_RELAXED);
+}
+#else
+#define HAVE_ALLOC_COUNT 0
+
+static guint64
+alloc_count (void)
+{
+	return 0;
+}
+#endif
+
+/*****************************************************************************/
+
+typedef struct {
+	const char *name;
+	GArray *samples;  /* gint64, microseconds */
+	guint64 allocs;
+	guint64 items;
+	gint64 start;
+	guint64 start_allocs;
+} Bench;
+
+static void
+bench_init (Bench *bench, const char *name)
+{
+	memset (bench, 0, sizeof (*bench));
+	bench->name = name;
+	bench->samples = g_array_new (FALSE, FALSE, sizeof (gint64));
+}
+
+static void
+bench_start (Bench *bench)
+{
+	bench->start_allocs = alloc_count ();
+	bench->start = g_get_monotonic_time ();
+}
+
+static void
+bench_stop (Bench *bench, guint items)
+{
+	gint64 elapsed = g_get_monotonic_time () - bench->start;
+
+	bench->allocs += alloc_count () - bench->start_allocs;
+	bench->items += items;
+	g_array_append_val (bench->samples, elapsed);
+}
+
+static int
+cmp_int64 (gconstpointer a, gconstpointer b)
+{
+	gint64 x = *(const gint64 *) a, y = *(const gint64 *) b;
+
+	return x < y ? -1 : x > y;
+}
+
+static gint64
+percentile (GArray *sorted, int pct)
+{
+	guint idx;
+
+	if (!sorted->len)
+		return 0;
+	idx = (sorted->len - 1) * pct / 100;
+	return g_array_index (sorted, gint64, idx);
+}
+
+static void
+bench_report (Bench *bench)
+{
+	guint n = bench->samples->len;
+
+	g_array_sort (bench->samples, cmp_int64);
+	printf ("%-20s n=%-4u p50=%7" G_GINT64_FORMAT "us p90=%7" G_GINT64_FORMAT "us"
+	        " p99=%7" G_GINT64_FORMAT "us max=%7" G_GINT64_FORMAT "us",
+	        bench->name, n,
+	        percentile (bench->samples, 50),
+	        percentile (bench->samples, 90),
+	        percentile (bench->samples, 99),
+	        percentile (bench->samples, 100));
+	if (HAVE_ALLOC_COUNT)
+		printf (" allocs/iter=%" G_GUINT64_FORMAT, n ? bench->allocs / n : 0);
+	if (bench->items)
+		printf (" items/iter=%" G_GUINT64_FORMAT, n ? bench->items / n : 0);
+	printf ("\n");
+
+	g_array_unref (bench->samples);
+}
+
+/*****************************************************************************/
+
+/* GTestDBus aborts when it can't spawn the bus daemon */
+static gboolean
+bus_daemon_available (void)
+{
+	const char *daemon = g_getenv ("G_TEST_DBUS_DAEMON");
+	char *path;
+	gboolean found;
+
+	path = g_find_program_in_path (daemon ? daemon : "dbus-daemon");
+	found = (path != NULL);
+	g_free (path);
+	return found;
+}
+
+/* Spawning "python3 -m dbusmock" succeeds even when the module isn't
+ * installed, so probe for it first rather than waiting for a service that
+ * will never appear.
+ */
+static gboolean
+mock_available (void)
+{
+	char *argv[] = { "python3", "-c", "import dbusmock", NULL };
+	int status = -1;
+
+	if (!g_spawn_sync (NULL, argv, NULL,
+	                   G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+	                   NULL, NULL, NULL, NULL, &status, NULL))
+		return FALSE;
+	return g_spawn_check_exit_status (status, NULL);
+}
+
+static GVariant *
+mock_call (GDBusConnection *bus, const char *path, const char *iface,
+           const char *method, GVariant *args, const char *reply_type)
+{
+	GError *error = NULL;
+	GVariant *ret;
+
+	ret = g_dbus_connection_call_sync (bus, MOCK_BUS_NAME, path, iface, method, args,
+	                                   reply_type ? G_VARIANT_TYPE (reply_type) : NULL,
+	                                   G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+	if (!ret) {
+		g_printerr ("%s.%s failed: %s\n", iface, method, error->message);
+		exit (1);
+	}
+	return ret;
+}
+
+static gboolean
+mock_wait_for_service (GDBusConnection *bus)
+{
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		GVariant *ret;
+		gboolean has_owner = FALSE;
+
+		ret = g_dbus_connection_call_sync (bus, "org.freedesktop.DBus", "/org/freedesktop/DBus",
+		                                   "org.freedesktop.DBus", "NameHasOwner",
+		                                   g_variant_new ("(s)", MOCK_BUS_NAME),
+		                                   G_VARIANT_TYPE ("(b)"),
+		                                   G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+		if (ret) {
+			g_variant_get (ret, "(b)", &has_owner);
+			g_variant_unref (ret);
+		}
+		if (has_owner)
+			return TRUE;
+		g_usleep (100 * 1000);
+	}
+	return FALSE;
+}
+
+static void
+mock_add_connection (GDBusConnection *bus, const char *id, gboolean vpn)
+{
+	char *uuid = nm_utils_uuid_generate ();
+	GVariant *args;
+
+	if (vpn) {
+		args = g_variant_new_parsed ("({'connection': {'id': <%s>, 'uuid': <%s>, 'type': <'vpn'>},"
+		                             "  'vpn': {'service-type': <'org.freedesktop.NetworkManager.openvpn'>}},)",
+		                             id, uuid);
+	} else {
+		args = g_variant_new_parsed ("({'connection': {'id': <%s>, 'uuid': <%s>, 'type': <'802-3-ethernet'>},"
+		                             "  '802-3-ethernet': @a{sv} {}},)",
+		                             id, uuid);
+	}
+	g_variant_unref (mock_call (bus, SETTINGS_PATH, SETTINGS_IFACE, "AddConnection", args, "(o)"));
+	g_free (uuid);
+}
+
+static void
+mock_populate (GDBusConnection *bus)
+{
+	GVariant *ret;
+	char *name, *iface, *dev_path, *ssid, *bssid;
+	int i;
+
+	for (i = 0; i < n_devices; i++) {
+		name = g_strdup_printf ("bench-eth%d", i);
+		iface = g_strdup_printf ("eth%d", i);
+		g_variant_unref (mock_call (bus, MOCK_PATH, MOCK_IFACE, "AddEthernetDevice",
+		                            g_variant_new ("(ssi)", name, iface, NM_DEVICE_STATE_DISCONNECTED),
+		                            "(s)"));
+		g_free (name);
+		g_free (iface);
+	}
+
+	if (n_aps) {
+		ret = mock_call (bus, MOCK_PATH, MOCK_IFACE, "AddWiFiDevice",
+		                 g_variant_new ("(ssi)", "bench-wlan0", "wlan0", NM_DEVICE_STATE_DISCONNECTED),
+		                 "(s)");
+		g_variant_get (ret, "(s)", &dev_path);
+		g_variant_unref (ret);
+
+		for (i = 0; i < n_aps; i++) {
+			name = g_strdup_printf ("bench-ap%d", i);
+			ssid = g_strdup_printf ("bench-ssid-%d", i);
+			bssid = g_strdup_printf ("02:00:00:00:%02X:%02X", (i >> 8) & 0xFF, i & 0xFF);
+			g_variant_unref (mock_call (bus, MOCK_PATH, MOCK_IFACE, "AddAccessPoint",
+			                            g_variant_new ("(ssssuuuyu)", dev_path, name, ssid, bssid,
+			                                           NM_802_11_MODE_INFRA, 2412, 54000,
+			                                           (guchar) (i * 7 % 100), 0),
+			                            "(s)"));
+			g_free (name);
+			g_free (ssid);
+			g_free (bssid);
+		}
+		g_free (dev_path);
+	}
+
+	for (i = 0; i < n_connections; i++) {
+		name = g_strdup_printf ("bench-connection-%d", i);
+		mock_add_connection (bus, name, FALSE);
+		g_free (name);
+	}
+
+	for (i = 0; i < n_vpns; i++) {
+		name = g_strdup_printf ("bench-vpn-%d", i);
+		mock_add_connection (bus, name, TRUE);
+		g_free (name);
+	}
+}
+
+/* Let NMClient catch up with everything the mock service announced */
+static gboolean
+wait_for_client (NMApplet *applet)
+{
+	gint64 deadline = g_get_monotonic_time () + 10 * G_USEC_PER_SEC;
+	int want_devices = n_devices + (n_aps ? 1 : 0);
+	int want_connections = n_connections + n_vpns;
+
+	while (g_get_monotonic_time () < deadline) {
+		const GPtrArray *devices = nm_client_get_devices (applet->nm_client);
+		const GPtrArray *connections = nm_client_get_connections (applet->nm_client);
+
+		if (   devices && devices->len >= want_devices
+		    && connections && connections->len >= want_connections)
+			return TRUE;
+		g_main_context_iteration (NULL, FALSE);
+		g_usleep (1000);
+	}
+	return FALSE;
+}
+
+/*****************************************************************************/
+
+static void
+bench_menu_show (NMApplet *applet)
+{
+	Bench bench;
+	int i;
+
+	bench_init (&bench, "nma_menu_show_cb");
+	for (i = 0; i < n_iterations; i++) {
+		GtkWidget *menu = g_object_ref_sink (gtk_menu_new ());
+
+		bench_start (&bench);
+		nma_menu_show_cb (menu, applet);
+		bench_stop (&bench, count_menu_items (menu));
+
+		gtk_widget_destroy (menu);
+		g_object_unref (menu);
+	}
+	bench_report (&bench);
+}
+
+static void
+bench_wifi_add_menu_item (NMApplet *applet)
+{
+	const GPtrArray *devices;
+	GPtrArray *all_connections, *connections;
+	NMDevice *wifi = NULL;
+	Bench bench;
+	int i;
+
+	devices = nm_client_get_devices (applet->nm_client);
+	for (i = 0; devices && i < devices->len; i++) {
+		if (NM_IS_DEVICE_WIFI (devices->pdata[i])) {
+			wifi = devices->pdata[i];
+			break;
+		}
+	}
+	if (!wifi)
+		return;
+
+	all_connections = applet_get_all_connections (applet);
+	connections = nm_device_filter_connections (wifi, all_connections);
+
+	bench_init (&bench, "wifi_add_menu_item");
+	for (i = 0; i < n_iterations; i++) {
+		GtkWidget *menu = g_object_ref_sink (gtk_menu_new ());
+
+		bench_start (&bench);
+		applet->wifi_class->add_menu_item (wifi, FALSE, connections, NULL, menu, applet);
+		bench_stop (&bench, count_menu_items (menu));
+
+		gtk_widget_destroy (menu);
+		g_object_unref (menu);
+	}
+	bench_report (&bench);
+
+	g_ptr_array_unref (connections);
+	g_ptr_array_unref (all_connections);
+}
+
+static void
+bench_update_icon (NMApplet *applet)
+{
+	Bench bench;
+	int i;
+
+	bench_init (&bench, "applet_update_icon");
+	for (i = 0; i < n_iterations; i++) {
+		bench_start (&bench);
+		applet_update_icon (applet);
+		bench_stop (&bench, 0);
+	}
+	bench_report (&bench);
+}
+
+static void
+bench_set_icon (NMApplet *applet)
+{
+	static char *names[] = { "nm-signal-00", "nm-signal-25", "nm-signal-50",
+	                         "nm-signal-75", "nm-signal-100" };
+	Bench bench;
+	int i;
+
+	/* Cycle through the names so the same-icon shortcut isn't taken; after
+	 * the first round every lookup is an icon cache hit.
+	 */
+	bench_init (&bench, "foo_set_icon");
+	for (i = 0; i < n_iterations; i++) {
+		bench_start (&bench);
+		foo_set_icon (applet, ICON_LAYER_LINK, NULL, names[i % G_N_ELEMENTS (names)]);
+		bench_stop (&bench, 0);
+	}
+	bench_report (&bench);
+}
+
+/*****************************************************************************/
+
+int
+main (int argc, char *argv[])
+{
+	GOptionContext *context;
+	GTestDBus *test_bus;
+	GDBusConnection *bus;
+	GSubprocess *mock;
+	GError *error = NULL;
+	NMApplet *applet;
+	const char *address;
+
+	context = g_option_context_new ("- benchmark nm-applet menu and icon paths");
+	g_option_context_add_main_entries (context, entries, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error)) {
+		g_printerr ("%s\n", error->message);
+		return 1;
+	}
+	g_option_context_free (context);
+
+	if (!g_getenv ("DISPLAY") && !g_getenv ("WAYLAND_DISPLAY")) {
+		printf ("SKIP: no display available\n");
+		return EXIT_SKIP;
+	}
+	if (!bus_daemon_available ()) {
+		printf ("SKIP: dbus-daemon is not available\n");
+		return EXIT_SKIP;
+	}
+	if (!mock_available ()) {
+		printf ("SKIP: python-dbusmock is not installed\n");
+		return EXIT_SKIP;
+	}
+
+	/* Bring the private bus up before GTK gets a chance to talk to the
+	 * user's real session bus.
+	 */
+	g_setenv ("NO_AT_BRIDGE", "1", TRUE);
+	test_bus = g_test_dbus_new (G_TEST_DBUS_NONE);
+	g_test_dbus_up (test_bus);
+	address = g_test_dbus_get_bus_address (test_bus);
+	if (!address) {
+		printf ("SKIP: could not start a private session bus\n");
+		g_object_unref (test_bus);
+		return EXIT_SKIP;
+	}
+	g_setenv ("DBUS_SYSTEM_BUS_ADDRESS", address, TRUE);
+
+	if (!gtk_init_check (&argc, &argv)) {
+		printf ("SKIP: no display available\n");
+		g_test_dbus_down (test_bus);
+		return EXIT_SKIP;
+	}
+
+	mock = g_subprocess_new (G_SUBPROCESS_FLAGS_NONE, &error,
+	                         "python3", "-m", "dbusmock", "--system",
+	                         "--template", "networkmanager", NULL);
+	if (!mock) {
+		printf ("SKIP: could not start python-dbusmock: %s\n", error->message);
+		g_test_dbus_down (test_bus);
+		return EXIT_SKIP;
+	}
+
+	bus = g_bus_get_sync (G_BUS_TYPE_SYSTEM, NULL, &error);
+	if (!bus) {
+		printf ("SKIP: could not connect to the private bus: %s\n", error->message);
+		g_subprocess_force_exit (mock);
+		g_test_dbus_down (test_bus);
+		return EXIT_SKIP;
+	}
+	if (!mock_wait_for_service (bus)) {
+		printf ("SKIP: mock NetworkManager service did not appear\n");
+		g_subprocess_force_exit (mock);
+		g_test_dbus_down (test_bus);
+		return EXIT_SKIP;
+	}
+
+	mock_populate (bus);
+
+	applet = nm_applet_new ();
+	if (!applet)
+		return 1;
+	if (!wait_for_client (applet)) {
+		g_printerr ("NMClient did not see the mock devices and connections\n");
+		return 1;
+	}
+
+	printf ("devices=%d aps=%d connections=%d vpns=%d iterations=%d\n",
+	        n_devices, n_aps, n_connections, n_vpns, n_iterations);
+
+	bench_menu_show (applet);
+	bench_wifi_add_menu_item (applet);
+	bench_update_icon (applet);
+	bench_set_icon (applet);
+
+	g_object_unref (applet);
+	g_object_unref (bus);
+	g_subprocess_force_exit (mock);
+	g_object_unref (mock);
+	g_test_dbus_down (test_bus);
+	g_object_unref (test_bus);
+
+	return 0;
+}
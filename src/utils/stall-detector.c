@@ -0,0 +1,261 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <gio/gio.h>
+
+#include "stall-detector.h"
+
+#define MAX_DEPTH 16
+
+typedef struct {
+	const char *name;
+	char *origin;
+	gint64 start;
+	gint64 duration;
+	guint depth;
+} Span;
+
+static gboolean enabled;
+static gint64 threshold_us;
+static FILE *trace_file;
+static GPollFunc default_poll;
+static StallFunc stall_func;
+static int pid;
+
+/* Dispatch of the current main loop iteration */
+static gint64 iteration_start;
+static GArray *spans;            /* Span, completed during this iteration */
+static Span open_spans[MAX_DEPTH];
+static guint depth;
+
+static void
+span_clear (gpointer data)
+{
+	Span *span = data;
+
+	g_free (span->origin);
+}
+
+static void
+write_json_string (const char *str)
+{
+	const char *p;
+
+	fputc ('"', trace_file);
+	for (p = str; p && *p; p++) {
+		if (*p == '"' || *p == '\\')
+			fprintf (trace_file, "\\%c", *p);
+		else if ((guchar) *p < 0x20)
+			fprintf (trace_file, "\\u%04x", (guchar) *p);
+		else
+			fputc (*p, trace_file);
+	}
+	fputc ('"', trace_file);
+}
+
+static void
+write_trace_event (const char *cat, const char *name, const char *origin,
+                   gint64 start, gint64 duration)
+{
+	fprintf (trace_file, "{\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+	         "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%" G_GINT64_FORMAT ",\"name\":",
+	         cat, pid, pid, start, duration);
+	write_json_string (name);
+	if (origin) {
+		fputs (",\"args\":{\"origin\":", trace_file);
+		write_json_string (origin);
+		fputc ('}', trace_file);
+	}
+	fputs ("},\n", trace_file);
+}
+
+static void
+iteration_finish (void)
+{
+	gint64 now = g_get_monotonic_time ();
+	gint64 duration = now - iteration_start;
+	GString *culprits;
+	guint i;
+
+	if (duration > threshold_us) {
+		culprits = g_string_new (NULL);
+		for (i = 0; i < spans->len; i++) {
+			Span *span = &g_array_index (spans, Span, i);
+
+			if (span->depth)
+				continue;
+			g_string_append_printf (culprits, "%s%s (%" G_GINT64_FORMAT " ms%s%s)",
+			                        culprits->len ? ", " : "",
+			                        span->name, span->duration / 1000,
+			                        span->origin ? " from " : "",
+			                        span->origin ? span->origin : "");
+		}
+		g_message ("Main loop stalled for %" G_GINT64_FORMAT " ms: %s",
+		           duration / 1000,
+		           culprits->len ? culprits->str : "no traced operation");
+		g_string_free (culprits, TRUE);
+
+		if (stall_func)
+			stall_func (duration);
+
+		if (trace_file) {
+			write_trace_event ("stall", "main loop dispatch", NULL, iteration_start, duration);
+			for (i = 0; i < spans->len; i++) {
+				Span *span = &g_array_index (spans, Span, i);
+
+				write_trace_event ("span", span->name, span->origin, span->start, span->duration);
+			}
+			fflush (trace_file);
+		}
+	}
+
+	g_array_set_size (spans, 0);
+}
+
+static gint
+stall_poll (GPollFD *ufds, guint nfds, gint timeout)
+{
+	gint ret;
+
+	/* Time between returning from one poll and entering the next is what
+	 * the iteration spent dispatching sources.
+	 */
+	iteration_finish ();
+	ret = default_poll (ufds, nfds, timeout);
+	iteration_start = g_get_monotonic_time ();
+	return ret;
+}
+
+static gint64
+threshold_from_settings (void)
+{
+	GSettingsSchemaSource *source;
+	GSettingsSchema *schema;
+	GSettings *settings;
+	gint64 ms = 0;
+
+	source = g_settings_schema_source_get_default ();
+	schema = source ? g_settings_schema_source_lookup (source, "org.gnome.nm-applet", TRUE) : NULL;
+	if (!schema)
+		return 0;
+
+	if (g_settings_schema_has_key (schema, "stall-threshold-ms")) {
+		settings = g_settings_new ("org.gnome.nm-applet");
+		ms = g_settings_get_int (settings, "stall-threshold-ms");
+		g_object_unref (settings);
+	}
+	g_settings_schema_unref (schema);
+	return ms;
+}
+
+void
+stall_detector_init (const char *program)
+{
+	const char *env, *path;
+	gint64 ms;
+
+	g_return_if_fail (!enabled);
+
+	env = g_getenv ("NMA_STALL_THRESHOLD_MS");
+	ms = env ? g_ascii_strtoll (env, NULL, 10) : threshold_from_settings ();
+	if (ms <= 0)
+		return;
+
+	threshold_us = ms * 1000;
+	pid = getpid ();
+	spans = g_array_new (FALSE, FALSE, sizeof (Span));
+	g_array_set_clear_func (spans, span_clear);
+
+	path = g_getenv ("NMA_STALL_TRACE");
+	if (path && *path) {
+		trace_file = fopen (path, "w");
+		if (trace_file)
+			fputs ("[\n", trace_file);
+		else
+			g_warning ("%s: could not open trace file %s", program, path);
+	}
+
+	default_poll = g_main_context_get_poll_func (NULL);
+	g_main_context_set_poll_func (NULL, stall_poll);
+
+	/* Startup runs before the first poll; count it as an iteration */
+	iteration_start = g_get_monotonic_time ();
+	enabled = TRUE;
+
+	g_message ("%s: reporting main loop stalls over %" G_GINT64_FORMAT " ms%s%s",
+	           program, ms, trace_file ? ", tracing to " : "", trace_file ? path : "");
+}
+
+gint64
+stall_detector_get_threshold_ms (void)
+{
+	return enabled ? threshold_us / 1000 : 0;
+}
+
+void
+stall_detector_set_stall_func (StallFunc func)
+{
+	stall_func = func;
+}
+
+void
+stall_trace_begin (const char *name)
+{
+	GSource *source;
+	Span *span;
+
+	if (!enabled || depth >= MAX_DEPTH) {
+		depth++;
+		return;
+	}
+
+	span = &open_spans[depth];
+	span->name = name;
+	span->depth = depth;
+	span->start = g_get_monotonic_time ();
+
+	source = g_main_current_source ();
+	span->origin = source ? g_strdup (g_source_get_name (source)) : NULL;
+	depth++;
+}
+
+void
+stall_trace_end (void)
+{
+	Span *span;
+
+	g_return_if_fail (depth > 0);
+
+	depth--;
+	if (!enabled || depth >= MAX_DEPTH)
+		return;
+
+	span = &open_spans[depth];
+	span->duration = g_get_monotonic_time () - span->start;
+	g_array_append_vals (spans, span, 1);
+	span->origin = NULL;
+}
@@ -0,0 +1,47 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef STALL_DETECTOR_H
+#define STALL_DETECTOR_H
+
+#include <glib.h>
+
+/* Opt-in main loop watchdog.
+ *
+ * Enabled by NMA_STALL_THRESHOLD_MS=<ms> in the environment, or by the
+ * "stall-threshold-ms" key of org.gnome.nm-applet.  Every main loop
+ * iteration whose dispatch takes longer than the threshold is logged,
+ * together with the traced operations that ran during it.  Setting
+ * NMA_STALL_TRACE=<file> also writes them as Chrome trace events.
+ */
+void stall_detector_init (const char *program);
+
+/* Threshold in milliseconds, or 0 when the detector is disabled */
+gint64 stall_detector_get_threshold_ms (void);
+
+/* Called with the dispatch time of every stall that is reported */
+typedef void (*StallFunc) (gint64 duration_us);
+void stall_detector_set_stall_func (StallFunc func);
+
+/* Mark a potentially slow synchronous operation; no-ops when disabled */
+void stall_trace_begin (const char *name);
+void stall_trace_end (void);
+
+#endif  /* STALL_DETECTOR_H */
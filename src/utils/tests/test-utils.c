@@ -22,8 +22,10 @@
 
 #include <glib.h>
 #include <string.h>
+#include <sys/socket.h>
 
 #include "utils.h"
+#include "wpa-pmk.h"
 
 typedef struct {
 	char *foobar_infra_open;
@@ -408,6 +410,102 @@ test_ap_hash_foobar_asdf11_adhoc_wpa_rsn (TestData *d)
 	g_assert (strcmp (d->foobar_adhoc_wpa_rsn, d->asdf11_adhoc_wpa_rsn));
 }
 
+static void
+test_route_line (const char *line,
+                 int family,
+                 const char *dest,
+                 const char *prefix,
+                 const char *next_hop,
+                 const char *metric)
+{
+	char *out_dest, *out_prefix, *out_next_hop, *out_metric;
+
+	g_assert (utils_parse_route_line (line, family, &out_dest, &out_prefix, &out_next_hop, &out_metric));
+	g_assert_cmpstr (out_dest, ==, dest);
+	g_assert_cmpstr (out_prefix, ==, prefix);
+	g_assert_cmpstr (out_next_hop, ==, next_hop);
+	g_assert_cmpstr (out_metric, ==, metric);
+
+	g_free (out_dest);
+	g_free (out_prefix);
+	g_free (out_next_hop);
+	g_free (out_metric);
+}
+
+static void
+test_parse_route_line (void)
+{
+	char *dest, *prefix, *next_hop, *metric;
+
+	test_route_line ("10.0.0.0/8", AF_INET, "10.0.0.0", "8", NULL, NULL);
+	test_route_line ("  10.0.0.0/255.0.0.0\tvia 192.168.1.1  ", AF_INET, "10.0.0.0", "255.0.0.0", "192.168.1.1", NULL);
+	test_route_line ("10.0.0.0/8 via 192.168.1.1 metric 20", AF_INET, "10.0.0.0", "8", "192.168.1.1", "20");
+	test_route_line ("10.0.0.0/8 metric 20 # office", AF_INET, "10.0.0.0", "8", NULL, "20");
+	test_route_line ("10.0.0.0/8 192.168.1.1", AF_INET, "10.0.0.0", "8", "192.168.1.1", NULL);
+	test_route_line ("2001:db8::/32 via fe80::1 metric 1024", AF_INET6, "2001:db8::", "32", "fe80::1", "1024");
+	test_route_line ("192.168.5.1", AF_INET, "192.168.5.1", "32", NULL, NULL);
+	test_route_line ("2001:db8::1 via fe80::1", AF_INET6, "2001:db8::1", "128", "fe80::1", NULL);
+
+	g_assert (!utils_parse_route_line ("", AF_INET, &dest, &prefix, &next_hop, &metric));
+	g_assert (!utils_parse_route_line ("   \t ", AF_INET, &dest, &prefix, &next_hop, &metric));
+	g_assert (!utils_parse_route_line ("# 10.0.0.0/8", AF_INET6, &dest, &prefix, &next_hop, &metric));
+	g_assert (dest == NULL);
+}
+
+/* IEEE 802.11i-2004 Annex H.4 */
+static const struct {
+	const char *passphrase;
+	const char *ssid;
+	const char *psk;
+} pmk_vectors[] = {
+	{ "password", "IEEE",
+	  "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e" },
+	{ "ThisIsAPassword", "ThisIsASSID",
+	  "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af" },
+	{ "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+	  "ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ",
+	  "becb93866bb8c3832cb777c2f559807c8c59afcb6eae734885001300a981cc62" },
+};
+
+static void
+test_wpa_pmk_vectors (void)
+{
+	guint8 pmk[WPA_PMK_LEN];
+	char *psk;
+	int i;
+
+	for (i = 0; i < G_N_ELEMENTS (pmk_vectors); i++) {
+		psk = wpa_pmk_derive_hex (pmk_vectors[i].passphrase,
+		                          (const guint8 *) pmk_vectors[i].ssid,
+		                          strlen (pmk_vectors[i].ssid));
+		g_assert_cmpstr (psk, ==, pmk_vectors[i].psk);
+		g_free (psk);
+	}
+
+	/* Out of range passphrases and SSIDs */
+	g_assert (!wpa_pmk_derive ("short", (const guint8 *) "IEEE", 4, pmk));
+	g_assert (!wpa_pmk_derive ("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+	                           (const guint8 *) "IEEE", 4, pmk));
+	g_assert (!wpa_pmk_derive ("password",
+	                           (const guint8 *) "ZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZZ", 33, pmk));
+}
+
+static void
+test_wpa_pmk_benchmark (void)
+{
+	guint8 pmk[WPA_PMK_LEN];
+	guint n = 0;
+
+	g_test_timer_start ();
+	do {
+		g_assert (wpa_pmk_derive ("ThisIsAPassword", (const guint8 *) "ThisIsASSID", 11, pmk));
+		n++;
+	} while (g_test_timer_elapsed () < 2.0);
+
+	g_test_maximized_result (n / g_test_timer_last (),
+	                         "%.1f derivations per second", n / g_test_timer_last ());
+}
+
 int
 main (int argc, char **argv)
 {
@@ -497,6 +595,12 @@ main (int argc, char **argv)
 	g_test_add_data_func ("/ap_hash/foobar_asdf11/adhoc_wpa_rsn", data,
 	                      (GTestDataFunc) test_ap_hash_foobar_asdf11_adhoc_wpa_rsn);
 
+	g_test_add_func ("/route_line/parse", test_parse_route_line);
+
+	g_test_add_func ("/wpa_pmk/vectors", test_wpa_pmk_vectors);
+	if (g_test_perf ())
+		g_test_add_func ("/wpa_pmk/benchmark", test_wpa_pmk_benchmark);
+
 	result = g_test_run ();
 
 	test_data_free (data);
@@ -22,6 +22,7 @@
 
 #include <config.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <netinet/ether.h>
 #include <glib.h>
 #include <glib/gi18n.h>
@@ -372,3 +373,71 @@ utils_fake_return_key (GdkEventKey *event)
 	g_free (keys);
 }
 
+
+/* Parse one line of a route list as used by the routes dialogs' import and
+ * export: "DEST/PREFIX [via NEXT_HOP] [metric METRIC]", with '#' starting a
+ * comment.  A bare next hop after the destination is accepted as well, and
+ * a missing prefix means a host route for @family.  The parts are only split
+ * here; validating them is up to the caller.  Returns FALSE for blank and
+ * comment-only lines.
+ */
+gboolean
+utils_parse_route_line (const char *line,
+                        int family,
+                        char **out_dest,
+                        char **out_prefix,
+                        char **out_next_hop,
+                        char **out_metric)
+{
+	char *stripped, *comment, *slash;
+	char **tokens;
+	int i;
+
+	g_return_val_if_fail (line != NULL, FALSE);
+	g_return_val_if_fail (out_dest && out_prefix && out_next_hop && out_metric, FALSE);
+
+	*out_dest = *out_prefix = *out_next_hop = *out_metric = NULL;
+
+	stripped = g_strdup (line);
+	comment = strchr (stripped, '#');
+	if (comment)
+		*comment = '\0';
+	g_strstrip (stripped);
+	if (!*stripped) {
+		g_free (stripped);
+		return FALSE;
+	}
+
+	tokens = g_strsplit_set (stripped, " \t", -1);
+	for (i = 0; tokens[i]; i++) {
+		if (!*tokens[i])
+			continue;
+
+		if (!*out_dest) {
+			slash = strchr (tokens[i], '/');
+			if (slash) {
+				*slash = '\0';
+				*out_prefix = g_strdup (slash + 1);
+			}
+			*out_dest = g_strdup (tokens[i]);
+		} else if (!strcmp (tokens[i], "via") || !strcmp (tokens[i], "metric")) {
+			char **out = tokens[i][0] == 'v' ? out_next_hop : out_metric;
+
+			while (tokens[i + 1] && !*tokens[i + 1])
+				i++;
+			if (tokens[i + 1]) {
+				i++;
+				if (!*out)
+					*out = g_strdup (tokens[i]);
+			}
+		} else if (!*out_next_hop)
+			*out_next_hop = g_strdup (tokens[i]);
+	}
+
+	if (!*out_prefix)
+		*out_prefix = g_strdup (family == AF_INET6 ? "128" : "32");
+
+	g_strfreev (tokens);
+	g_free (stripped);
+	return TRUE;
+}
@@ -94,5 +94,12 @@ void utils_set_cell_background (GtkCellRenderer *cell,
 
 void utils_fake_return_key (GdkEventKey *event);
 
+gboolean utils_parse_route_line (const char *line,
+                                 int family,
+                                 char **out_dest,
+                                 char **out_prefix,
+                                 char **out_next_hop,
+                                 char **out_metric);
+
 #endif /* UTILS_H */
 
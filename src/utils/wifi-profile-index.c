@@ -0,0 +1,270 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "wifi-profile-index.h"
+
+#define WIFI_PROFILE_INDEX_TAG "wifi-profile-index"
+
+typedef struct {
+	GBytes *ssid;  /* NULL unless a Wi-Fi profile */
+	char *mac;     /* canonical bound MAC, or NULL */
+} IndexedProfile;
+
+typedef struct {
+	GHashTable *indexed;  /* NMConnection -> IndexedProfile */
+	GHashTable *by_ssid;  /* GBytes -> GPtrArray of NMConnection */
+	GHashTable *by_mac;   /* canonical MAC -> GPtrArray of NMConnection */
+	GPtrArray *unbound;   /* Wi-Fi profiles not bound to a MAC */
+} WifiProfileIndex;
+
+static void
+indexed_profile_free (IndexedProfile *entry)
+{
+	if (entry->ssid)
+		g_bytes_unref (entry->ssid);
+	g_free (entry->mac);
+	g_slice_free (IndexedProfile, entry);
+}
+
+static void
+list_add (GHashTable *table, gconstpointer key, GBoxedCopyFunc key_copy, NMConnection *connection)
+{
+	GPtrArray *list;
+
+	list = g_hash_table_lookup (table, key);
+	if (!list) {
+		list = g_ptr_array_new ();
+		g_hash_table_insert (table, key_copy (key), list);
+	}
+	g_ptr_array_add (list, connection);
+}
+
+static void
+list_remove (GHashTable *table, gconstpointer key, NMConnection *connection)
+{
+	GPtrArray *list;
+
+	list = g_hash_table_lookup (table, key);
+	if (!list)
+		return;
+
+	g_ptr_array_remove (list, connection);
+	if (!list->len)
+		g_hash_table_remove (table, key);
+}
+
+static void
+wifi_profile_index_unlink (WifiProfileIndex *index, NMConnection *connection, IndexedProfile *entry)
+{
+	if (!entry->ssid)
+		return;
+
+	list_remove (index->by_ssid, entry->ssid, connection);
+	if (entry->mac)
+		list_remove (index->by_mac, entry->mac, connection);
+	else
+		g_ptr_array_remove (index->unbound, connection);
+
+	g_clear_pointer (&entry->ssid, g_bytes_unref);
+	g_clear_pointer (&entry->mac, g_free);
+}
+
+static void
+wifi_profile_index_link (WifiProfileIndex *index, NMConnection *connection, IndexedProfile *entry)
+{
+	NMSettingWireless *s_wifi;
+	const char *mac;
+	GBytes *ssid;
+
+	s_wifi = nm_connection_get_setting_wireless (connection);
+	ssid = s_wifi ? nm_setting_wireless_get_ssid (s_wifi) : NULL;
+	if (!ssid)
+		return;
+
+	entry->ssid = g_bytes_ref (ssid);
+	list_add (index->by_ssid, ssid, (GBoxedCopyFunc) g_bytes_ref, connection);
+
+	mac = nm_setting_wireless_get_mac_address (s_wifi);
+	if (mac) {
+		/* Keep an unparseable MAC as is so that it matches no device */
+		entry->mac = nm_utils_hwaddr_canonical (mac, -1);
+		if (!entry->mac)
+			entry->mac = g_strdup (mac);
+		list_add (index->by_mac, entry->mac, (GBoxedCopyFunc) g_strdup, connection);
+	} else
+		g_ptr_array_add (index->unbound, connection);
+}
+
+static void
+wifi_profile_index_connection_changed (NMConnection *connection, gpointer user_data)
+{
+	WifiProfileIndex *index = user_data;
+	IndexedProfile *entry;
+
+	entry = g_hash_table_lookup (index->indexed, connection);
+	g_return_if_fail (entry != NULL);
+
+	wifi_profile_index_unlink (index, connection, entry);
+	wifi_profile_index_link (index, connection, entry);
+}
+
+static void
+wifi_profile_index_connection_added (NMClient *client, NMConnection *connection, gpointer user_data)
+{
+	WifiProfileIndex *index = user_data;
+	IndexedProfile *entry;
+
+	if (g_hash_table_contains (index->indexed, connection))
+		return;
+
+	entry = g_slice_new0 (IndexedProfile);
+	g_hash_table_insert (index->indexed, connection, entry);
+	wifi_profile_index_link (index, connection, entry);
+
+	g_signal_connect (connection, NM_CONNECTION_CHANGED,
+	                  G_CALLBACK (wifi_profile_index_connection_changed), index);
+}
+
+static void
+wifi_profile_index_connection_removed (NMClient *client, NMConnection *connection, gpointer user_data)
+{
+	WifiProfileIndex *index = user_data;
+	IndexedProfile *entry;
+
+	entry = g_hash_table_lookup (index->indexed, connection);
+	if (!entry)
+		return;
+
+	g_signal_handlers_disconnect_by_func (connection, wifi_profile_index_connection_changed, index);
+
+	wifi_profile_index_unlink (index, connection, entry);
+	g_hash_table_remove (index->indexed, connection);
+}
+
+static void
+wifi_profile_index_free (WifiProfileIndex *index)
+{
+	GHashTableIter iter;
+	gpointer connection;
+
+	g_hash_table_iter_init (&iter, index->indexed);
+	while (g_hash_table_iter_next (&iter, &connection, NULL))
+		g_signal_handlers_disconnect_by_func (connection, wifi_profile_index_connection_changed, index);
+
+	g_hash_table_destroy (index->indexed);
+	g_hash_table_destroy (index->by_ssid);
+	g_hash_table_destroy (index->by_mac);
+	g_ptr_array_unref (index->unbound);
+	g_slice_free (WifiProfileIndex, index);
+}
+
+static WifiProfileIndex *
+wifi_profile_index_get (NMClient *client)
+{
+	WifiProfileIndex *index;
+	const GPtrArray *connections;
+	int i;
+
+	index = g_object_get_data (G_OBJECT (client), WIFI_PROFILE_INDEX_TAG);
+	if (index)
+		return index;
+
+	index = g_slice_new0 (WifiProfileIndex);
+	index->indexed = g_hash_table_new_full (NULL, NULL, NULL,
+	                                        (GDestroyNotify) indexed_profile_free);
+	index->by_ssid = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+	                                        (GDestroyNotify) g_bytes_unref,
+	                                        (GDestroyNotify) g_ptr_array_unref);
+	index->by_mac = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                       g_free, (GDestroyNotify) g_ptr_array_unref);
+	index->unbound = g_ptr_array_new ();
+	g_object_set_data_full (G_OBJECT (client), WIFI_PROFILE_INDEX_TAG,
+	                        index, (GDestroyNotify) wifi_profile_index_free);
+
+	connections = nm_client_get_connections (client);
+	for (i = 0; connections && i < connections->len; i++)
+		wifi_profile_index_connection_added (client, connections->pdata[i], index);
+
+	g_signal_connect (client, NM_CLIENT_CONNECTION_ADDED,
+	                  G_CALLBACK (wifi_profile_index_connection_added), index);
+	g_signal_connect (client, NM_CLIENT_CONNECTION_REMOVED,
+	                  G_CALLBACK (wifi_profile_index_connection_removed), index);
+
+	return index;
+}
+
+static void
+append_all (GPtrArray *dst, GPtrArray *src)
+{
+	guint i;
+
+	for (i = 0; src && i < src->len; i++)
+		g_ptr_array_add (dst, src->pdata[i]);
+}
+
+GPtrArray *
+wifi_profile_index_get_for_device (NMClient *client, const char *hw_addr)
+{
+	WifiProfileIndex *index;
+	GHashTableIter iter;
+	GPtrArray *result, *list;
+	char *canonical;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+
+	index = wifi_profile_index_get (client);
+	result = g_ptr_array_new ();
+	append_all (result, index->unbound);
+
+	if (!hw_addr) {
+		g_hash_table_iter_init (&iter, index->by_mac);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer) &list))
+			append_all (result, list);
+		return result;
+	}
+
+	canonical = nm_utils_hwaddr_canonical (hw_addr, -1);
+	if (canonical) {
+		append_all (result, g_hash_table_lookup (index->by_mac, canonical));
+		g_free (canonical);
+	}
+	return result;
+}
+
+GPtrArray *
+wifi_profile_index_get_for_ssid (NMClient *client, GBytes *ssid)
+{
+	WifiProfileIndex *index;
+	GPtrArray *result;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+
+	index = wifi_profile_index_get (client);
+	result = g_ptr_array_new ();
+	if (ssid)
+		append_all (result, g_hash_table_lookup (index->by_ssid, ssid));
+	return result;
+}
@@ -0,0 +1,40 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef WIFI_PROFILE_INDEX_H
+#define WIFI_PROFILE_INDEX_H
+
+#include <NetworkManager.h>
+
+/* Wi-Fi profiles of an NMClient indexed by SSID and by the MAC address
+ * they are bound to.  The index is created on first use, hangs off the
+ * client and is kept current from its connection signals, so the applet
+ * menu and the Wi-Fi dialog share it.
+ *
+ * Both return the connections in a new array that doesn't hold references.
+ */
+
+/* Profiles bound to @hw_addr or to no device; all of them if @hw_addr is NULL */
+GPtrArray *wifi_profile_index_get_for_device (NMClient *client, const char *hw_addr);
+
+/* Profiles for the network @ssid */
+GPtrArray *wifi_profile_index_get_for_ssid (NMClient *client, GBytes *ssid);
+
+#endif  /* WIFI_PROFILE_INDEX_H */
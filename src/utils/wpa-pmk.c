@@ -0,0 +1,273 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "wpa-pmk.h"
+
+#define PBKDF2_ITERATIONS 4096
+#define SHA1_DIGEST_WORDS 5
+#define SHA1_BLOCK_LEN    64
+
+/* The 256-bit PMK takes two PBKDF2 output blocks, and the two are
+ * independent chains of HMAC-SHA1.  Both are run through one SHA-1
+ * compression with the state stored lane-minor, so each round step is a
+ * plain loop over the lanes that the compiler turns into vector code
+ * where the target has it.
+ */
+#define LANES 2
+
+typedef struct {
+	guint32 h[SHA1_DIGEST_WORDS][LANES];
+} Sha1Lanes;
+
+static const guint32 sha1_iv[SHA1_DIGEST_WORDS] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+static inline guint32
+rol32 (guint32 x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+static void
+sha1_compress (Sha1Lanes *state, guint32 block[16][LANES])
+{
+	guint32 w[80][LANES];
+	guint32 a[LANES], b[LANES], c[LANES], d[LANES], e[LANES];
+	int t, l;
+
+	for (t = 0; t < 16; t++) {
+		for (l = 0; l < LANES; l++)
+			w[t][l] = block[t][l];
+	}
+	for (t = 16; t < 80; t++) {
+		for (l = 0; l < LANES; l++)
+			w[t][l] = rol32 (w[t - 3][l] ^ w[t - 8][l] ^ w[t - 14][l] ^ w[t - 16][l], 1);
+	}
+
+	for (l = 0; l < LANES; l++) {
+		a[l] = state->h[0][l];
+		b[l] = state->h[1][l];
+		c[l] = state->h[2][l];
+		d[l] = state->h[3][l];
+		e[l] = state->h[4][l];
+	}
+
+#define SHA1_ROUNDS(from, to, f_expr, k) \
+	for (t = from; t < to; t++) { \
+		for (l = 0; l < LANES; l++) { \
+			guint32 tmp = rol32 (a[l], 5) + (f_expr) + e[l] + k + w[t][l]; \
+			e[l] = d[l]; \
+			d[l] = c[l]; \
+			c[l] = rol32 (b[l], 30); \
+			b[l] = a[l]; \
+			a[l] = tmp; \
+		} \
+	}
+
+	SHA1_ROUNDS ( 0, 20, (b[l] & c[l]) | (~b[l] & d[l]), 0x5a827999);
+	SHA1_ROUNDS (20, 40, b[l] ^ c[l] ^ d[l], 0x6ed9eba1);
+	SHA1_ROUNDS (40, 60, (b[l] & c[l]) | (b[l] & d[l]) | (c[l] & d[l]), 0x8f1bbcdc);
+	SHA1_ROUNDS (60, 80, b[l] ^ c[l] ^ d[l], 0xca62c1d6);
+
+#undef SHA1_ROUNDS
+
+	for (l = 0; l < LANES; l++) {
+		state->h[0][l] += a[l];
+		state->h[1][l] += b[l];
+		state->h[2][l] += c[l];
+		state->h[3][l] += d[l];
+		state->h[4][l] += e[l];
+	}
+}
+
+static void
+sha1_init (Sha1Lanes *state)
+{
+	int i, l;
+
+	for (i = 0; i < SHA1_DIGEST_WORDS; i++) {
+		for (l = 0; l < LANES; l++)
+			state->h[i][l] = sha1_iv[i];
+	}
+}
+
+/* Load a 64-byte big-endian block for one lane */
+static void
+load_block (guint32 block[16][LANES], int lane, const guint8 *bytes)
+{
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		block[i][lane] =   ((guint32) bytes[4 * i] << 24)
+		                 | ((guint32) bytes[4 * i + 1] << 16)
+		                 | ((guint32) bytes[4 * i + 2] << 8)
+		                 |  (guint32) bytes[4 * i + 3];
+	}
+}
+
+/* Prepare the block hashing a 20-byte digest that follows the 64-byte
+ * HMAC pad block; only words 0-4 change between iterations.
+ */
+static void
+init_digest_block (guint32 block[16][LANES])
+{
+	int i, l;
+
+	for (l = 0; l < LANES; l++) {
+		for (i = SHA1_DIGEST_WORDS; i < 16; i++)
+			block[i][l] = 0;
+		block[5][l] = 0x80000000;
+		block[15][l] = (SHA1_BLOCK_LEN + 20) * 8;
+	}
+}
+
+static inline void
+set_digest_block (guint32 block[16][LANES], const Sha1Lanes *digest)
+{
+	int i, l;
+
+	for (i = 0; i < SHA1_DIGEST_WORDS; i++) {
+		for (l = 0; l < LANES; l++)
+			block[i][l] = digest->h[i][l];
+	}
+}
+
+gboolean
+wpa_pmk_derive (const char *passphrase,
+                const guint8 *ssid,
+                gsize ssid_len,
+                guint8 pmk[WPA_PMK_LEN])
+{
+	guint8 pad[SHA1_BLOCK_LEN], msg[SHA1_BLOCK_LEN];
+	guint32 block[16][LANES];
+	Sha1Lanes ipad, opad, inner, u, t;
+	gsize key_len, i;
+	int l, iter;
+
+	g_return_val_if_fail (passphrase != NULL, FALSE);
+	g_return_val_if_fail (ssid != NULL || ssid_len == 0, FALSE);
+	g_return_val_if_fail (pmk != NULL, FALSE);
+
+	key_len = strlen (passphrase);
+	if (key_len < 8 || key_len > 63 || ssid_len > 32)
+		return FALSE;
+
+	/* HMAC key pads; the passphrase is always shorter than a block */
+	sha1_init (&ipad);
+	memset (pad, 0x36, sizeof (pad));
+	for (i = 0; i < key_len; i++)
+		pad[i] ^= passphrase[i];
+	for (l = 0; l < LANES; l++)
+		load_block (block, l, pad);
+	sha1_compress (&ipad, block);
+
+	sha1_init (&opad);
+	memset (pad, 0x5c, sizeof (pad));
+	for (i = 0; i < key_len; i++)
+		pad[i] ^= passphrase[i];
+	for (l = 0; l < LANES; l++)
+		load_block (block, l, pad);
+	sha1_compress (&opad, block);
+
+	/* U1 = HMAC (passphrase, SSID || INT (lane + 1)) */
+	for (l = 0; l < LANES; l++) {
+		gsize len = ssid_len + 4;
+
+		memset (msg, 0, sizeof (msg));
+		if (ssid_len)
+			memcpy (msg, ssid, ssid_len);
+		msg[ssid_len + 3] = l + 1;
+		msg[len] = 0x80;
+		msg[62] = ((SHA1_BLOCK_LEN + len) * 8) >> 8;
+		msg[63] = ((SHA1_BLOCK_LEN + len) * 8) & 0xff;
+		load_block (block, l, msg);
+	}
+	inner = ipad;
+	sha1_compress (&inner, block);
+
+	init_digest_block (block);
+	set_digest_block (block, &inner);
+	u = opad;
+	sha1_compress (&u, block);
+	t = u;
+
+	/* U2 ... U4096, each two compressions thanks to the saved pad states */
+	for (iter = 1; iter < PBKDF2_ITERATIONS; iter++) {
+		set_digest_block (block, &u);
+		inner = ipad;
+		sha1_compress (&inner, block);
+
+		set_digest_block (block, &inner);
+		u = opad;
+		sha1_compress (&u, block);
+
+		for (i = 0; i < SHA1_DIGEST_WORDS; i++) {
+			for (l = 0; l < LANES; l++)
+				t.h[i][l] ^= u.h[i][l];
+		}
+	}
+
+	/* T1 || T2, truncated to 256 bits */
+	for (i = 0; i < WPA_PMK_LEN; i++) {
+		guint32 word = t.h[(i % 20) / 4][i / 20];
+
+		pmk[i] = word >> (24 - 8 * (i % 4));
+	}
+
+	memset (pad, 0, sizeof (pad));
+	memset (&ipad, 0, sizeof (ipad));
+	memset (&opad, 0, sizeof (opad));
+	memset (&inner, 0, sizeof (inner));
+	memset (&u, 0, sizeof (u));
+	memset (&t, 0, sizeof (t));
+	memset (block, 0, sizeof (block));
+	return TRUE;
+}
+
+char *
+wpa_pmk_derive_hex (const char *passphrase,
+                    const guint8 *ssid,
+                    gsize ssid_len)
+{
+	static const char hex[] = "0123456789abcdef";
+	guint8 pmk[WPA_PMK_LEN];
+	char *str;
+	int i;
+
+	if (!wpa_pmk_derive (passphrase, ssid, ssid_len, pmk))
+		return NULL;
+
+	str = g_malloc (WPA_PMK_LEN * 2 + 1);
+	for (i = 0; i < WPA_PMK_LEN; i++) {
+		str[2 * i] = hex[pmk[i] >> 4];
+		str[2 * i + 1] = hex[pmk[i] & 0xf];
+	}
+	str[WPA_PMK_LEN * 2] = '\0';
+
+	memset (pmk, 0, sizeof (pmk));
+	return str;
+}
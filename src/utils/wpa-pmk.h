@@ -0,0 +1,43 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/* NetworkManager Applet -- allow user control over networking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * Copyright 2016 Red Hat, Inc.
+ */
+
+#ifndef WPA_PMK_H
+#define WPA_PMK_H
+
+#include <glib.h>
+
+#define WPA_PMK_LEN 32
+
+/* Derive the WPA/WPA2 pairwise master key from a passphrase and SSID, as
+ * PBKDF2-HMAC-SHA1 (passphrase, SSID, 4096 iterations) truncated to 256 bits
+ * (IEEE 802.11i Annex H.4).  The passphrase must be 8 to 63 characters and
+ * the SSID at most 32 bytes.
+ */
+gboolean wpa_pmk_derive (const char *passphrase,
+                         const guint8 *ssid,
+                         gsize ssid_len,
+                         guint8 pmk[WPA_PMK_LEN]);
+
+/* Same, as the 64 hex digit form accepted for the "psk" property */
+char *wpa_pmk_derive_hex (const char *passphrase,
+                          const guint8 *ssid,
+                          gsize ssid_len);
+
+#endif  /* WPA_PMK_H */
@@ -35,6 +35,7 @@
 #include "eap-method.h"
 #include "nm-utils.h"
 #include "utils.h"
+#include "stall-detector.h"
 
 G_DEFINE_BOXED_TYPE (EAPMethod, eap_method, eap_method_ref, eap_method_unref)
 
@@ -235,6 +236,7 @@ eap_method_validate_filepicker (GtkBuilder *builder,
 	if (!g_file_test (filename, G_FILE_TEST_EXISTS | G_FILE_TEST_IS_REGULAR))
 		goto out;
 
+	stall_trace_begin ("eap_method_validate_filepicker");
 	setting = (NMSetting8021x *) nm_setting_802_1x_new ();
 
 	if (item_type == TYPE_PRIVATE_KEY) {
@@ -250,6 +252,7 @@ eap_method_validate_filepicker (GtkBuilder *builder,
 		g_warning ("%s: invalid item type %d.", __func__, item_type);
 
 	g_object_unref (setting);
+	stall_trace_end ();
 
 out:
 	g_free (filename);
@@ -28,16 +28,194 @@
 #include "helpers.h"
 #include "nma-ui-utils.h"
 #include "utils.h"
-
-#define WPA_PMK_LEN 32
+#include "wpa-pmk.h"
 
 struct _WirelessSecurityWPAPSK {
 	WirelessSecurity parent;
 
 	gboolean editing_connection;
 	const char *password_flags_name;
+
+	/* Optional PSK pre-computation, done in a worker thread as the
+	 * password is typed so that saving doesn't wait for it.
+	 */
+	GBytes *ssid;
+	GCancellable *derive_cancellable;
+	char *derived_passphrase;
+	GBytes *derived_ssid;
+	char *derived_psk;
 };
 
+typedef struct {
+	char *passphrase;
+	GBytes *ssid;
+} DeriveData;
+
+static void
+psk_free (gpointer psk)
+{
+	if (psk) {
+		memset (psk, 0, strlen (psk));
+		g_free (psk);
+	}
+}
+
+static void
+derive_data_free (gpointer user_data)
+{
+	DeriveData *data = user_data;
+
+	memset (data->passphrase, 0, strlen (data->passphrase));
+	g_free (data->passphrase);
+	g_bytes_unref (data->ssid);
+	g_slice_free (DeriveData, data);
+}
+
+static void
+clear_derived (WirelessSecurityWPAPSK *sec)
+{
+	if (sec->derived_passphrase) {
+		memset (sec->derived_passphrase, 0, strlen (sec->derived_passphrase));
+		g_clear_pointer (&sec->derived_passphrase, g_free);
+	}
+	if (sec->derived_psk) {
+		memset (sec->derived_psk, 0, strlen (sec->derived_psk));
+		g_clear_pointer (&sec->derived_psk, g_free);
+	}
+	g_clear_pointer (&sec->derived_ssid, g_bytes_unref);
+}
+
+static gboolean
+store_pmk_enabled (WirelessSecurity *parent)
+{
+	GtkWidget *widget;
+
+	widget = GTK_WIDGET (gtk_builder_get_object (parent->builder, "store_pmk_checkbutton_wpa"));
+	g_assert (widget);
+	return gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (widget));
+}
+
+static gboolean
+is_hex_psk (WirelessSecurity *parent)
+{
+	GtkWidget *entry;
+	const char *key;
+	int i;
+
+	entry = GTK_WIDGET (gtk_builder_get_object (parent->builder, "wpa_psk_entry"));
+	key = gtk_entry_get_text (GTK_ENTRY (entry));
+	if (!key || strlen (key) != 64)
+		return FALSE;
+	for (i = 0; i < 64; i++) {
+		if (!isxdigit (key[i]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+static GBytes *
+connection_get_ssid (NMConnection *connection)
+{
+	NMSettingWireless *s_wireless;
+
+	s_wireless = nm_connection_get_setting_wireless (connection);
+	if (!s_wireless)
+		return NULL;
+#if defined (LIBNM_BUILD)
+	{
+		GBytes *ssid = nm_setting_wireless_get_ssid (s_wireless);
+
+		return ssid ? g_bytes_ref (ssid) : NULL;
+	}
+#else
+	{
+		const GByteArray *ssid = nm_setting_wireless_get_ssid (s_wireless);
+
+		return ssid ? g_bytes_new (ssid->data, ssid->len) : NULL;
+	}
+#endif
+}
+
+static void
+derive_thread (GTask *task,
+               gpointer source_object,
+               gpointer task_data,
+               GCancellable *cancellable)
+{
+	DeriveData *data = task_data;
+	gconstpointer ssid;
+	gsize ssid_len;
+
+	ssid = g_bytes_get_data (data->ssid, &ssid_len);
+	g_task_return_pointer (task,
+	                       wpa_pmk_derive_hex (data->passphrase, ssid, ssid_len),
+	                       psk_free);
+}
+
+static void
+derive_done_cb (GObject *source_object, GAsyncResult *result, gpointer user_data)
+{
+	WirelessSecurityWPAPSK *sec = user_data;
+	DeriveData *data = g_task_get_task_data (G_TASK (result));
+	char *psk;
+
+	psk = g_task_propagate_pointer (G_TASK (result), NULL);
+	if (psk) {
+		clear_derived (sec);
+		sec->derived_passphrase = g_strdup (data->passphrase);
+		sec->derived_ssid = g_bytes_ref (data->ssid);
+		sec->derived_psk = psk;
+	}
+
+	wireless_security_unref (WIRELESS_SECURITY (sec));
+}
+
+static void
+schedule_derive (WirelessSecurityWPAPSK *sec)
+{
+	WirelessSecurity *parent = WIRELESS_SECURITY (sec);
+	GtkWidget *entry;
+	const char *key;
+	DeriveData *data;
+	GTask *task;
+	gsize len;
+
+	if (sec->derive_cancellable) {
+		g_cancellable_cancel (sec->derive_cancellable);
+		g_clear_object (&sec->derive_cancellable);
+	}
+
+	if (!sec->ssid || !store_pmk_enabled (parent))
+		return;
+
+	entry = GTK_WIDGET (gtk_builder_get_object (parent->builder, "wpa_psk_entry"));
+	key = gtk_entry_get_text (GTK_ENTRY (entry));
+	len = key ? strlen (key) : 0;
+	if (len < 8 || len > 63)
+		return;
+	if (   sec->derived_psk
+	    && !strcmp (sec->derived_passphrase, key)
+	    && g_bytes_equal (sec->derived_ssid, sec->ssid))
+		return;
+
+	data = g_slice_new0 (DeriveData);
+	data->passphrase = g_strdup (key);
+	data->ssid = g_bytes_ref (sec->ssid);
+
+	sec->derive_cancellable = g_cancellable_new ();
+	task = g_task_new (NULL, sec->derive_cancellable, derive_done_cb,
+	                   wireless_security_ref (parent));
+	g_task_set_task_data (task, data, derive_data_free);
+	g_task_run_in_thread (task, derive_thread);
+	g_object_unref (task);
+}
+
+static void
+passphrase_changed_cb (GtkWidget *widget, WirelessSecurityWPAPSK *sec)
+{
+	schedule_derive (sec);
+}
+
 static void
 show_toggled_cb (GtkCheckButton *button, WirelessSecurity *sec)
 {
@@ -102,6 +280,7 @@ fill_connection (WirelessSecurity *parent, NMConnection *connection)
 	WirelessSecurityWPAPSK *wpa_psk = (WirelessSecurityWPAPSK *) parent;
 	GtkWidget *widget, *passwd_entry;
 	const char *key;
+	char *psk = NULL;
 	NMSettingWireless *s_wireless;
 	NMSettingWirelessSecurity *s_wireless_sec;
 	NMSettingSecretFlags secret_flags;
@@ -122,7 +301,30 @@ fill_connection (WirelessSecurity *parent, NMConnection *connection)
 	widget = GTK_WIDGET (gtk_builder_get_object (parent->builder, "wpa_psk_entry"));
 	passwd_entry = widget;
 	key = gtk_entry_get_text (GTK_ENTRY (widget));
-	g_object_set (s_wireless_sec, NM_SETTING_WIRELESS_SECURITY_PSK, key, NULL);
+
+	/* Store the derived key instead of the passphrase if asked to; use the
+	 * one pre-computed for this SSID when it is ready.
+	 */
+	if (store_pmk_enabled (parent)) {
+		GBytes *ssid = connection_get_ssid (connection);
+
+		if (   ssid
+		    && wpa_psk->derived_psk
+		    && !g_strcmp0 (wpa_psk->derived_passphrase, key)
+		    && g_bytes_equal (wpa_psk->derived_ssid, ssid))
+			psk = g_strdup (wpa_psk->derived_psk);
+		else if (ssid) {
+			gconstpointer ssid_data;
+			gsize ssid_len;
+
+			ssid_data = g_bytes_get_data (ssid, &ssid_len);
+			psk = wpa_pmk_derive_hex (key, ssid_data, ssid_len);
+		}
+		if (ssid)
+			g_bytes_unref (ssid);
+	}
+	g_object_set (s_wireless_sec, NM_SETTING_WIRELESS_SECURITY_PSK, psk ? psk : key, NULL);
+	psk_free (psk);
 
 	/* Save PSK_FLAGS to the connection */
 	secret_flags = nma_utils_menu_to_secret_flags (passwd_entry);
@@ -164,6 +366,31 @@ update_secrets (WirelessSecurity *parent, NMConnection *connection)
 	                          (HelperSecretFunc) nm_setting_wireless_security_get_psk);
 }
 
+static void
+destroy (WirelessSecurity *parent)
+{
+	WirelessSecurityWPAPSK *sec = (WirelessSecurityWPAPSK *) parent;
+
+	if (sec->derive_cancellable) {
+		g_cancellable_cancel (sec->derive_cancellable);
+		g_object_unref (sec->derive_cancellable);
+	}
+	clear_derived (sec);
+	if (sec->ssid)
+		g_bytes_unref (sec->ssid);
+}
+
+void
+ws_wpa_psk_set_ssid (WirelessSecurityWPAPSK *sec, const guint8 *ssid, gsize len)
+{
+	g_return_if_fail (sec != NULL);
+
+	if (sec->ssid)
+		g_bytes_unref (sec->ssid);
+	sec->ssid = ssid ? g_bytes_new (ssid, len) : NULL;
+	schedule_derive (sec);
+}
+
 WirelessSecurityWPAPSK *
 ws_wpa_psk_new (NMConnection *connection, gboolean secrets_only)
 {
@@ -177,7 +404,7 @@ ws_wpa_psk_new (NMConnection *connection, gboolean secrets_only)
 	                                 add_to_size_group,
 	                                 fill_connection,
 	                                 update_secrets,
-	                                 NULL,
+	                                 destroy,
 	                                 UIDIR "/ws-wpa-psk.ui",
 	                                 "wpa_psk_notebook",
 	                                 "wpa_psk_entry");
@@ -194,6 +421,9 @@ ws_wpa_psk_new (NMConnection *connection, gboolean secrets_only)
 	g_signal_connect (G_OBJECT (widget), "changed",
 	                  (GCallback) wireless_security_changed_cb,
 	                  sec);
+	g_signal_connect (G_OBJECT (widget), "changed",
+	                  (GCallback) passphrase_changed_cb,
+	                  sec);
 	gtk_entry_set_width_chars (GTK_ENTRY (widget), 28);
 
 	/* Create password-storage popup menu for password entry under entry's secondary icon */
@@ -203,8 +433,10 @@ ws_wpa_psk_new (NMConnection *connection, gboolean secrets_only)
 	                                  FALSE, secrets_only);
 
 	/* Fill secrets, if any */
-	if (connection)
+	if (connection) {
+		sec->ssid = connection_get_ssid (connection);
 		update_secrets (WIRELESS_SECURITY (sec), connection);
+	}
 
 	widget = GTK_WIDGET (gtk_builder_get_object (parent->builder, "show_checkbutton_wpa"));
 	g_assert (widget);
@@ -212,6 +444,14 @@ ws_wpa_psk_new (NMConnection *connection, gboolean secrets_only)
 	                  (GCallback) show_toggled_cb,
 	                  sec);
 
+	/* A key that is already stored as a PMK should stay one */
+	widget = GTK_WIDGET (gtk_builder_get_object (parent->builder, "store_pmk_checkbutton_wpa"));
+	g_assert (widget);
+	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (widget), is_hex_psk (parent));
+	g_signal_connect_swapped (G_OBJECT (widget), "toggled",
+	                          (GCallback) schedule_derive,
+	                          sec);
+
 	/* Hide WPA/RSN for now since this can be autodetected by NM and the
 	 * supplicant when connecting to the AP.
 	 */
@@ -35,5 +35,7 @@ typedef struct _WirelessSecurityWPAPSK WirelessSecurityWPAPSK;
 
 WirelessSecurityWPAPSK * ws_wpa_psk_new (NMConnection *connection, gboolean secrets_only);
 
+void ws_wpa_psk_set_ssid (WirelessSecurityWPAPSK *sec, const guint8 *ssid, gsize len);
+
 #endif /* WS_WEP_KEY_H */
 